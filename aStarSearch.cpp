@@ -0,0 +1,166 @@
+#include "aStarSearch.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+
+const double Infinity = std::numeric_limits<double>::infinity();
+
+} // namespace
+
+/**
+ * Constructs an engine with no graph.
+ */
+AStarSearch::AStarSearch() : cost(Infinity), settledCount(0)
+{
+}
+
+/**
+ * Picks an anchor for every airport and prepares the edge costs.
+ * @param g - the graph to search; it is copied
+ * @param locations - coordinates indexed by the graph's vertex IDs
+ */
+AStarSearch::AStarSearch(const CSRGraph& g, const AirportLocations& locations)
+    : graph(g), locations(locations), cost(Infinity), settledCount(0)
+{
+    size_t count = graph.vertexCount();
+
+    // breadth-first from every located airport at once, ignoring edge
+    // direction, so each unlocated airport borrows the fewest-hop one
+    CSRGraph backward = graph.reversed();
+    anchor.assign(count, Graph::InvalidVertexId);
+    std::vector<VertexId> pending;
+    for (VertexId v = 0; v < count; v++)
+    {
+        if (locations.known(v))
+        {
+            anchor[v] = v;
+            pending.push_back(v);
+        }
+    }
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        VertexId u = pending[i];
+        for (const CSRGraph* side : {&graph, &backward})
+        {
+            for (uint32_t e = side->edgeBegin(u); e < side->edgeEnd(u); e++)
+            {
+                VertexId v = side->target(e);
+                if (anchor[v] != Graph::InvalidVertexId)
+                    continue;
+                anchor[v] = anchor[u];
+                pending.push_back(v);
+            }
+        }
+    }
+
+    costs.resize(graph.edgeCount());
+    for (VertexId u = 0; u < count; u++)
+        for (uint32_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++)
+            costs[e] = anchorDistanceKm(u, graph.target(e)) * (1 + std::max(0.0, graph.weight(e)));
+
+    label.assign(count, Infinity);
+    estimate.assign(count, 0.0);
+    pred.assign(count, Graph::InvalidVertexId);
+    settled.assign(count, 0);
+    queue.reset(count);
+}
+
+/**
+ * Finds the cheapest route between two vertices.
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @param path - filled with the IDs along the route, source first;
+ *               left empty if there is no route
+ * @param useHeuristic - false to run plain Dijkstra on the same costs
+ * @return - whether a route was found
+ */
+bool AStarSearch::findPath(VertexId source, VertexId destination, std::vector<VertexId>& path, bool useHeuristic)
+{
+    path.clear();
+    for (VertexId v : reached)
+    {
+        label[v] = Infinity;
+        estimate[v] = 0.0;
+        pred[v] = Graph::InvalidVertexId;
+        settled[v] = 0;
+    }
+    reached.clear();
+    queue.clear();
+    cost = Infinity;
+    settledCount = 0;
+    if (source >= graph.vertexCount() || destination >= graph.vertexCount())
+        return false;
+
+    label[source] = 0.0;
+    if (useHeuristic)
+        estimate[source] = anchorDistanceKm(source, destination);
+    reached.push_back(source);
+    queue.push(source, estimate[source]);
+
+    while (!queue.empty())
+    {
+        VertexId u = queue.pop();
+        settled[u] = 1;
+        settledCount++;
+        if (u == destination)
+            break;
+
+        for (uint32_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++)
+        {
+            VertexId v = graph.target(e);
+            if (settled[v])
+                continue;
+            double candidate = label[u] + costs[e];
+            if (candidate < label[v])
+            {
+                if (label[v] == Infinity)
+                {
+                    reached.push_back(v);
+                    if (useHeuristic)
+                        estimate[v] = anchorDistanceKm(v, destination);
+                }
+                label[v] = candidate;
+                pred[v] = u;
+                queue.decreaseKey(v, candidate + estimate[v]);
+            }
+        }
+    }
+
+    if (!settled[destination])
+        return false;
+    for (VertexId v = destination; v != Graph::InvalidVertexId; v = pred[v])
+        path.push_back(v);
+    std::reverse(path.begin(), path.end());
+    cost = label[destination];
+    return true;
+}
+
+/**
+ * Returns the cost of the route found by the last query.
+ */
+double AStarSearch::getCost() const
+{
+    return cost;
+}
+
+/**
+ * Returns how many vertices the last query settled.
+ */
+size_t AStarSearch::getSettledCount() const
+{
+    return settledCount;
+}
+
+/**
+ * Great-circle distance between the anchors of two vertices.
+ * @return - the distance in kilometres, or 0 if either has no anchor
+ */
+double AStarSearch::anchorDistanceKm(VertexId a, VertexId b) const
+{
+    if (anchor[a] == Graph::InvalidVertexId || anchor[b] == Graph::InvalidVertexId)
+        return 0.0;
+    return locations.distanceKm(anchor[a], anchor[b]);
+}
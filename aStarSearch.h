@@ -0,0 +1,98 @@
+/**
+ * @file aStarSearch.h
+ * Goal-directed point-to-point search guided by great-circle distance.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "airportLocations.h"
+#include "csrGraph.h"
+#include "indexedHeap.h"
+
+/**
+ * Finds the cheapest route between two airports with A*, where a flight
+ * costs its great-circle length stretched by the risk it adds:
+ *
+ *   cost(u, v) = distanceKm(u, v) * (1 + max(0, weight(u, v)))
+ *
+ * Risk weights alone cannot guide A* (they are mostly zero and may be
+ * negative), but this cost is never less than the flight's length, so the
+ * remaining great-circle distance to the destination is a lower bound on
+ * the remaining cost. By the triangle inequality that bound is also
+ * consistent, so every settled vertex is final just as in Dijkstra.
+ *
+ * Airports without coordinates borrow the position of a located airport
+ * they are connected to (their anchor). Any choice keeps the bound valid,
+ * since edge costs and the heuristic are measured between the same
+ * positions; a nearby one just keeps it tight. Airports with no located
+ * airport anywhere in their component have no anchor, and their flights
+ * cost nothing.
+ */
+class AStarSearch
+{
+  public:
+    /**
+     * Constructs an engine with no graph.
+     */
+    AStarSearch();
+
+    /**
+     * Picks an anchor for every airport and prepares the edge costs.
+     * @param g - the graph to search; it is copied
+     * @param locations - coordinates indexed by the graph's vertex IDs
+     */
+    AStarSearch(const CSRGraph& g, const AirportLocations& locations);
+
+    /**
+     * Finds the cheapest route between two vertices.
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @param path - filled with the IDs along the route, source first;
+     *               left empty if there is no route
+     * @param useHeuristic - false to run plain Dijkstra on the same costs
+     * @return - whether a route was found
+     */
+    bool findPath(VertexId source, VertexId destination, std::vector<VertexId>& path, bool useHeuristic = true);
+
+    /**
+     * Returns the cost of the route found by the last query.
+     */
+    double getCost() const;
+
+    /**
+     * Returns how many vertices the last query settled.
+     */
+    size_t getSettledCount() const;
+
+    /**
+     * Returns the cost of one edge.
+     * @param e - the edge index in the graph
+     */
+    double edgeCost(uint32_t e) const
+    {
+        return costs[e];
+    }
+
+  private:
+    CSRGraph graph;
+    AirportLocations locations;
+    std::vector<double> costs; /**< Cost of each edge, indexed like the graph's edges **/
+    std::vector<VertexId> anchor; /**< Located vertex whose position each vertex uses **/
+
+    std::vector<double> label; /**< Cost of the best route found to each vertex **/
+    std::vector<double> estimate; /**< Heuristic of each reached vertex, computed once per query **/
+    std::vector<VertexId> pred;
+    std::vector<char> settled;
+    std::vector<VertexId> reached; /**< Every labeled vertex, for resetting **/
+    IndexedHeap<double> queue;
+    double cost;
+    size_t settledCount;
+
+    /**
+     * Great-circle distance between the anchors of two vertices.
+     * @return - the distance in kilometres, or 0 if either has no anchor
+     */
+    double anchorDistanceKm(VertexId a, VertexId b) const;
+};
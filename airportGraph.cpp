@@ -1,6 +1,7 @@
 #include "airportGraph.h"
 
 const Vertex Graph::InvalidVertex = "_SAFECOVIDINVALIDVERTEX";
+const VertexId Graph::InvalidVertexId = UINT32_MAX;
 const int Graph::InvalidWeight = INT_MIN;
 const string Graph:: InvalidLabel = "_SAFECOVIDINVALIDLABEL";
 const Edge Graph::InvalidEdge = Edge(Graph::InvalidVertex, Graph::InvalidVertex, Graph::InvalidWeight, Graph::InvalidLabel);
@@ -48,6 +49,119 @@ vector<Vertex> Graph::getAdjacent(Vertex source) const
     }
 }
 
+/**
+ * Gets the number of vertices adjacent to the parameter vertex.
+ * Same as getAdjacent(source).size(), without building the vector.
+ * @param source - vertex to count neighbors of
+ * @return the number of adjacent vertices, 0 if source doesn't exist
+ */
+size_t Graph::getDegree(const Vertex& source) const
+{
+    auto lookup = adjacency_list.find(source);
+    if (lookup == adjacency_list.end())
+        return 0;
+    return lookup->second.size();
+}
+
+/**
+ * Gets the dense ID of a vertex. IDs are handed out in the order
+ * vertices are first inserted, starting at 0, and stay the same for
+ * the life of the graph (until clear()), even if the vertex is
+ * removed and inserted again.
+ * @param v - the vertex to look up
+ * @return - if v exists, its ID
+ *         - if not, InvalidVertexId
+ */
+VertexId Graph::getVertexId(const Vertex& v) const
+{
+    auto lookup = vertex_ids.find(v);
+    if (lookup == vertex_ids.end() || adjacency_list.find(v) == adjacency_list.end())
+        return InvalidVertexId;
+    return lookup->second;
+}
+
+/**
+ * Gets the vertex with the given dense ID.
+ * @param id - the ID to look up
+ * @return - if the ID was handed out, the vertex name (even if the
+ *  vertex has since been removed)
+ *         - if not, InvalidVertex
+ */
+Vertex Graph::getVertexName(VertexId id) const
+{
+    if (id >= vertex_names.size())
+        return InvalidVertex;
+    return vertex_names[id];
+}
+
+/**
+ * Returns the number of IDs handed out so far. Every valid ID is
+ * smaller than this, so it is the size to use for arrays indexed by ID.
+ */
+size_t Graph::getIdCount() const
+{
+    return vertex_names.size();
+}
+
+/**
+ * Checks if the vertex with the given ID exists.
+ * @param id - the vertex ID
+ * @return - if the vertex exists, true
+ *         - if not (or the ID was never handed out), false
+ */
+bool Graph::vertexExists(VertexId id) const
+{
+    return id < vertex_names.size() && adjacency_list.find(vertex_names[id]) != adjacency_list.end();
+}
+
+/**
+ * Gets the IDs of all vertices adjacent to the parameter vertex.
+ * @param source - ID of the vertex to get neighbors from
+ * @return a vector of vertex IDs
+ */
+vector<VertexId> Graph::getAdjacentIds(VertexId source) const
+{
+    if (source >= vertex_names.size())
+        return vector<VertexId>();
+    auto lookup = adjacency_list.find(vertex_names[source]);
+    if (lookup == adjacency_list.end())
+        return vector<VertexId>();
+
+    vector<VertexId> ids;
+    ids.reserve(lookup->second.size());
+    for (auto it = lookup->second.begin(); it != lookup->second.end(); it++)
+        ids.push_back(vertex_ids.find(it->first)->second);
+    return ids;
+}
+
+/**
+ * Checks if an edge exists between the vertices with the given IDs.
+ * @param source - ID of one vertex the edge is connected to
+ * @param destination - ID of the other vertex the edge is connected to
+ * @return - if the edge exists, true
+ *         - if not, false
+ */
+bool Graph::edgeExists(VertexId source, VertexId destination) const
+{
+    if (source >= vertex_names.size() || destination >= vertex_names.size())
+        return false;
+    return assertEdgeExists(vertex_names[source], vertex_names[destination], "");
+}
+
+/**
+ * Gets the weight of the edge between the vertices with the given IDs.
+ * @param source - ID of one vertex the edge is connected to
+ * @param destination - ID of the other vertex the edge is connected to
+ * @return - if edge exists, return edge weight
+ *         - if doesn't, return InvalidWeight
+ */
+double Graph::getEdgeWeight(VertexId source, VertexId destination) const
+{
+    if (source >= vertex_names.size() || destination >= vertex_names.size())
+        return InvalidWeight;
+    return getEdgeWeight(vertex_names[source], vertex_names[destination]);
+}
+
 /**
  * Returns one vertex in the graph. This function can be used
  *  to find a random vertex with which to start a traversal.
@@ -99,6 +213,18 @@ vector<Edge> Graph::getEdges() const
         return vector<Edge>();
 
     vector<Edge> ret;
+
+    if (directed)
+    {
+        // every (source, destination) key is already a distinct edge
+        for (auto it = adjacency_list.begin(); it != adjacency_list.end(); it++)
+        {
+            for (auto its = it->second.begin(); its != it->second.end(); its++)
+                ret.push_back(its->second);
+        }
+        return ret;
+    }
+
     set<pair<Vertex, Vertex>> seen;
 
     for (auto it = adjacency_list.begin(); it != adjacency_list.end(); it++)
@@ -207,6 +333,7 @@ void Graph::insertVertex(Vertex v)
     removeVertex(v);
     // make it empty again
     adjacency_list[v] = unordered_map<Vertex, Edge>();
+    intern(v);
 }
 
 /**
@@ -265,6 +392,7 @@ bool Graph::insertEdge(Vertex source, Vertex destination)
     if(adjacency_list.find(source)==adjacency_list.end())
     {
         adjacency_list[source] = unordered_map<Vertex, Edge>();
+        intern(source);
     }
         //source vertex exists
     adjacency_list[source][destination] = Edge(source, destination);
@@ -273,6 +401,7 @@ bool Graph::insertEdge(Vertex source, Vertex destination)
         if(adjacency_list.find(destination)== adjacency_list.end())
         {
             adjacency_list[destination] = unordered_map<Vertex, Edge>();
+            intern(destination);
         }
         adjacency_list[destination][source] = Edge(source, destination);
     }
@@ -386,6 +515,22 @@ bool Graph::isDirected() const
 void Graph::clear()
 {
     adjacency_list.clear();
+    vertex_names.clear();
+    vertex_ids.clear();
+}
+
+/**
+ * Hands out an ID for a vertex name if it does not have one yet.
+ * Called wherever a vertex is added to adjacency_list.
+ * @param v - the vertex name
+ * @return the ID of v
+ */
+VertexId Graph::intern(const Vertex& v)
+{
+    auto inserted = vertex_ids.emplace(v, static_cast<VertexId>(vertex_names.size()));
+    if (inserted.second)
+        vertex_names.push_back(v);
+    return inserted.first->second;
 }
 
 
@@ -39,6 +39,10 @@
 
 #include "edge.h"
 
+class GraphBuilder;
+class GraphSnapshot;
+class CSRGraph;
+
 using std::cerr;
 using std::cout;
 using std::endl;
@@ -81,6 +85,90 @@ public:
      */
     vector<Vertex> getAdjacent(Vertex source) const;
 
+    /**
+     * Calls visit(neighbor, weight) for every vertex adjacent to source,
+     * without copying the adjacency list like getAdjacent does.
+     * @param source - vertex to get neighbors from
+     * @param visit - callable taking a const Vertex& and a double
+     */
+    template <class Callback>
+    void forEachNeighbor(const Vertex& source, Callback visit) const
+    {
+        auto lookup = adjacency_list.find(source);
+        if (lookup == adjacency_list.end())
+            return;
+        for (auto it = lookup->second.begin(); it != lookup->second.end(); it++)
+            visit(it->first, it->second.getWeight());
+    }
+
+    /**
+     * Gets the number of vertices adjacent to the parameter vertex.
+     * Same as getAdjacent(source).size(), without building the vector.
+     * @param source - vertex to count neighbors of
+     * @return the number of adjacent vertices, 0 if source doesn't exist
+     */
+    size_t getDegree(const Vertex& source) const;
+
+    /**
+     * Gets the dense ID of a vertex. IDs are handed out in the order
+     * vertices are first inserted, starting at 0, and stay the same for
+     * the life of the graph (until clear()), even if the vertex is
+     * removed and inserted again. They can be used to index flat arrays
+     * of size getIdCount().
+     * @param v - the vertex to look up
+     * @return - if v exists, its ID
+     *         - if not, InvalidVertexId
+     */
+    VertexId getVertexId(const Vertex& v) const;
+
+    /**
+     * Gets the vertex with the given dense ID.
+     * @param id - the ID to look up
+     * @return - if the ID was handed out, the vertex name (even if the
+     *  vertex has since been removed)
+     *         - if not, InvalidVertex
+     */
+    Vertex getVertexName(VertexId id) const;
+
+    /**
+     * Returns the number of IDs handed out so far. Every valid ID is
+     * smaller than this, so it is the size to use for arrays indexed by ID.
+     */
+    size_t getIdCount() const;
+
+    /**
+     * Checks if the vertex with the given ID exists.
+     * @param id - the vertex ID
+     * @return - if the vertex exists, true
+     *         - if not (or the ID was never handed out), false
+     */
+    bool vertexExists(VertexId id) const;
+
+    /**
+     * Gets the IDs of all vertices adjacent to the parameter vertex.
+     * @param source - ID of the vertex to get neighbors from
+     * @return a vector of vertex IDs
+     */
+    vector<VertexId> getAdjacentIds(VertexId source) const;
+
+    /**
+     * Checks if an edge exists between the vertices with the given IDs.
+     * @param source - ID of one vertex the edge is connected to
+     * @param destination - ID of the other vertex the edge is connected to
+     * @return - if the edge exists, true
+     *         - if not, false
+     */
+    bool edgeExists(VertexId source, VertexId destination) const;
+
+    /**
+     * Gets the weight of the edge between the vertices with the given IDs.
+     * @param source - ID of one vertex the edge is connected to
+     * @param destination - ID of the other vertex the edge is connected to
+     * @return - if edge exists, return edge weight
+     *         - if doesn't, return InvalidWeight
+     */
+    double getEdgeWeight(VertexId source, VertexId destination) const;
+
     /**
      * Returns one vertex in the graph. This function can be used
      *  to find a random vertex with which to start a traversal.
@@ -229,6 +317,7 @@ public:
 
 
     const static Vertex InvalidVertex;
+    const static VertexId InvalidVertexId;
     const static Edge InvalidEdge;
     const static int InvalidWeight;
     const static string InvalidLabel;
@@ -244,8 +333,16 @@ public:
 
 
 private:
+    friend class GraphBuilder;
+    friend class GraphSnapshot;
+    friend class CSRGraph;
+
     mutable unordered_map<Vertex, unordered_map<Vertex, Edge>> adjacency_list;
 
+    // interning table between vertex names and dense IDs
+    vector<Vertex> vertex_names;
+    unordered_map<Vertex, VertexId> vertex_ids;
+
     bool weighted;
     bool directed;
     int picNum;
@@ -260,6 +357,14 @@ private:
      */
     bool assertVertexExists(Vertex v, string functionName) const;
 
+    /**
+     * Hands out an ID for a vertex name if it does not have one yet.
+     * Called wherever a vertex is added to adjacency_list.
+     * @param v - the vertex name
+     * @return the ID of v
+     */
+    VertexId intern(const Vertex& v);
+
 
 
     /**
@@ -0,0 +1,167 @@
+#include "airportLocations.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "mappedFile.h"
+
+const double AirportLocations::EarthRadiusKm = 6371.0;
+
+namespace
+{
+
+const double DegreesToRadians = 3.14159265358979323846 / 180.0;
+
+/**
+ * Splits one row of a CSV file into fields, honouring double quotes.
+ * Quotes are left on the field.
+ * @param begin - first byte of the row
+ * @param end - one past the last byte of the row
+ * @param fields - filled with [start, end) pointers of each field
+ * @param maxFields - stop after this many fields
+ * @return - the number of fields found
+ */
+int splitRow(const char* begin, const char* end, const char* fields[][2], int maxFields)
+{
+    int found = 0;
+    const char* fieldStart = begin;
+    bool quoted = false;
+    for (const char* c = begin; c <= end && found < maxFields; c++)
+    {
+        if (c < end && *c == '"')
+        {
+            quoted = !quoted;
+            continue;
+        }
+        if (c == end || (*c == ',' && !quoted))
+        {
+            fields[found][0] = fieldStart;
+            fields[found][1] = c;
+            found++;
+            fieldStart = c + 1;
+        }
+    }
+    return found;
+}
+
+} // namespace
+
+/**
+ * Constructs an empty table where no airport has a location.
+ */
+AirportLocations::AirportLocations() : count(0)
+{
+}
+
+/**
+ * Reads the coordinates of every airport in the graph.
+ * @param filename - the airport file, e.g. data/airportcodes.txt
+ * @param g - the graph whose VertexIds index the table
+ * @return - false if the file could not be read
+ */
+bool AirportLocations::load(const std::string& filename, const Graph& g)
+{
+    size_t vertices = g.getIdCount();
+    lat.assign(vertices, 0.0);
+    lon.assign(vertices, 0.0);
+    cosLat.assign(vertices, 1.0);
+    present.assign(vertices, 0);
+    count = 0;
+
+    MappedFile file;
+    if (!file.open(filename))
+        return false;
+
+    const char* line = file.data();
+    const char* end = file.data() + file.size();
+    while (line < end)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (lineEnd == NULL)
+            lineEnd = end;
+        const char* rowEnd = (lineEnd > line && lineEnd[-1] == '\r') ? lineEnd - 1 : lineEnd;
+
+        const char* fields[8][2];
+        if (splitRow(line, rowEnd, fields, 8) == 8)
+        {
+            // IATA codes are quoted in the file; strip the quotes for the lookup
+            const char* codeBegin = fields[4][0];
+            const char* codeEnd = fields[4][1];
+            if (codeEnd - codeBegin >= 2 && *codeBegin == '"' && codeEnd[-1] == '"')
+            {
+                codeBegin++;
+                codeEnd--;
+            }
+            VertexId v = g.getVertexId(Vertex(codeBegin, codeEnd));
+            if (v != Graph::InvalidVertexId && !present[v])
+            {
+                char* parsedEnd = NULL;
+                double latDegrees = strtod(fields[6][0], &parsedEnd);
+                bool ok = parsedEnd == fields[6][1];
+                double lonDegrees = strtod(fields[7][0], &parsedEnd);
+                ok = ok && parsedEnd == fields[7][1];
+                if (ok)
+                {
+                    lat[v] = latDegrees * DegreesToRadians;
+                    lon[v] = lonDegrees * DegreesToRadians;
+                    cosLat[v] = std::cos(lat[v]);
+                    present[v] = 1;
+                    count++;
+                }
+            }
+        }
+        line = lineEnd + 1;
+    }
+    return true;
+}
+
+/**
+ * Checks whether an airport has a location.
+ * @param v - ID of the airport
+ */
+bool AirportLocations::known(VertexId v) const
+{
+    return v < present.size() && present[v];
+}
+
+/**
+ * Returns the number of airports with a location.
+ */
+size_t AirportLocations::knownCount() const
+{
+    return count;
+}
+
+/**
+ * Returns an airport's latitude in degrees. The airport must be known.
+ * @param v - ID of the airport
+ */
+double AirportLocations::latitude(VertexId v) const
+{
+    return lat[v] / DegreesToRadians;
+}
+
+/**
+ * Returns an airport's longitude in degrees. The airport must be known.
+ * @param v - ID of the airport
+ */
+double AirportLocations::longitude(VertexId v) const
+{
+    return lon[v] / DegreesToRadians;
+}
+
+/**
+ * Great-circle distance between two known airports (haversine formula).
+ * @param a - ID of one airport
+ * @param b - ID of the other airport
+ * @return - the distance in kilometres
+ */
+double AirportLocations::distanceKm(VertexId a, VertexId b) const
+{
+    double sinLat = std::sin((lat[b] - lat[a]) / 2);
+    double sinLon = std::sin((lon[b] - lon[a]) / 2);
+    double h = sinLat * sinLat + cosLat[a] * cosLat[b] * sinLon * sinLon;
+    return 2 * EarthRadiusKm * std::asin(std::sqrt(std::min(1.0, h)));
+}
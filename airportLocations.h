@@ -0,0 +1,78 @@
+/**
+ * @file airportLocations.h
+ * Airport coordinates from an OpenFlights airport file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "airportGraph.h"
+
+/**
+ * Latitude and longitude of the airports in a Graph, indexed by VertexId.
+ *
+ * Each row of an OpenFlights airport file looks like
+ *   ID,"name","city","country","IATA","ICAO",latitude,longitude,altitude,...
+ * where the quoted fields may themselves contain commas. Only the IATA
+ * code (field 5) and the coordinates (fields 7 and 8) are used. Airports
+ * in the graph that the file does not list have no location.
+ */
+class AirportLocations
+{
+  public:
+    /** Mean radius of the earth in kilometres. **/
+    const static double EarthRadiusKm;
+
+    /**
+     * Constructs an empty table where no airport has a location.
+     */
+    AirportLocations();
+
+    /**
+     * Reads the coordinates of every airport in the graph.
+     * @param filename - the airport file, e.g. data/airportcodes.txt
+     * @param g - the graph whose VertexIds index the table
+     * @return - false if the file could not be read
+     */
+    bool load(const std::string& filename, const Graph& g);
+
+    /**
+     * Checks whether an airport has a location.
+     * @param v - ID of the airport
+     */
+    bool known(VertexId v) const;
+
+    /**
+     * Returns the number of airports with a location.
+     */
+    size_t knownCount() const;
+
+    /**
+     * Returns an airport's latitude in degrees. The airport must be known.
+     * @param v - ID of the airport
+     */
+    double latitude(VertexId v) const;
+
+    /**
+     * Returns an airport's longitude in degrees. The airport must be known.
+     * @param v - ID of the airport
+     */
+    double longitude(VertexId v) const;
+
+    /**
+     * Great-circle distance between two known airports (haversine formula).
+     * @param a - ID of one airport
+     * @param b - ID of the other airport
+     * @return - the distance in kilometres
+     */
+    double distanceKm(VertexId a, VertexId b) const;
+
+  private:
+    std::vector<double> lat; /**< Latitude of each vertex in radians **/
+    std::vector<double> lon; /**< Longitude of each vertex in radians **/
+    std::vector<double> cosLat; /**< Cached cos(lat) for distanceKm **/
+    std::vector<char> present;
+    size_t count;
+};
@@ -0,0 +1,304 @@
+#include "altSearch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace
+{
+
+const double Infinity = std::numeric_limits<double>::infinity();
+
+} // namespace
+
+/**
+ * Constructs an engine with no graph.
+ */
+ALTSearch::ALTSearch() : cycleFree(false), cost(Infinity), settledCount(0)
+{
+}
+
+/**
+ * Picks the landmarks and computes the distances to and from them.
+ * @param g - the graph to search; it is copied
+ * @param landmarkCount - how many landmarks to pick; more give tighter
+ *                        bounds at the cost of memory and build time
+ */
+ALTSearch::ALTSearch(const CSRGraph& g, unsigned landmarkCount) : forward(g), cost(Infinity), settledCount(0)
+{
+    size_t count = forward.vertexCount();
+    cycleFree = forward.feasiblePotential(potential);
+    label.assign(count, std::make_pair(Infinity, 0u));
+    estimate.assign(count, std::make_pair(0.0, 0));
+    pred.assign(count, Graph::InvalidVertexId);
+    settled.assign(count, 0);
+    queue.reset(count);
+    if (!cycleFree)
+        return;
+
+    pickLandmarks(landmarkCount);
+    fromLandmark.assign(count * landmarks.size(), std::make_pair(Infinity, 0u));
+    toLandmark.assign(count * landmarks.size(), std::make_pair(Infinity, 0u));
+    CSRGraph backward = forward.reversed();
+    for (size_t i = 0; i < landmarks.size(); i++)
+    {
+        fillColumn(forward, false, i, fromLandmark);
+        fillColumn(backward, true, i, toLandmark);
+    }
+}
+
+/**
+ * Whether queries can be answered, which is false if the graph has a
+ * negative cycle.
+ */
+bool ALTSearch::usable() const
+{
+    return cycleFree;
+}
+
+/**
+ * Finds the safest path between two vertices.
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @param path - filled with the IDs along the path, source first;
+ *               left empty if there is no path
+ * @param useLandmarks - false to run plain Dijkstra on the same weights
+ * @return - whether a path was found
+ */
+bool ALTSearch::findPath(VertexId source, VertexId destination, std::vector<VertexId>& path, bool useLandmarks)
+{
+    path.clear();
+    for (VertexId v : reached)
+    {
+        label[v] = std::make_pair(Infinity, 0u);
+        estimate[v] = std::make_pair(0.0, 0);
+        pred[v] = Graph::InvalidVertexId;
+        settled[v] = 0;
+    }
+    reached.clear();
+    queue.clear();
+    cost = Infinity;
+    settledCount = 0;
+    if (!cycleFree || source >= forward.vertexCount() || destination >= forward.vertexCount())
+        return false;
+
+    label[source] = std::make_pair(0.0, 0u);
+    if (useLandmarks)
+        estimate[source] = lowerBound(source, destination);
+    reached.push_back(source);
+    if (estimate[source].first != Infinity)
+        queue.push(source, estimate[source]);
+
+    while (!queue.empty())
+    {
+        VertexId u = queue.pop();
+        settled[u] = 1;
+        settledCount++;
+        if (u == destination)
+            break;
+
+        for (uint32_t e = forward.edgeBegin(u); e < forward.edgeEnd(u); e++)
+        {
+            VertexId v = forward.target(e);
+            if (settled[v])
+                continue;
+            double reduced = std::max(0.0, forward.weight(e) + potential[u] - potential[v]);
+            Label candidate = std::make_pair(label[u].first + reduced, label[u].second + 1);
+            if (candidate < label[v])
+            {
+                if (label[v].first == Infinity)
+                {
+                    reached.push_back(v);
+                    if (useLandmarks)
+                        estimate[v] = lowerBound(v, destination);
+                }
+                label[v] = candidate;
+                pred[v] = u;
+                // no path from v reaches the destination, so it is never queued
+                if (estimate[v].first == Infinity)
+                    continue;
+                queue.decreaseKey(v, std::make_pair(candidate.first + estimate[v].first,
+                                                    static_cast<int>(candidate.second) + estimate[v].second));
+            }
+        }
+    }
+
+    if (!settled[destination])
+        return false;
+    for (VertexId v = destination; v != Graph::InvalidVertexId; v = pred[v])
+        path.push_back(v);
+    std::reverse(path.begin(), path.end());
+    cost = label[destination].first - potential[source] + potential[destination];
+    return true;
+}
+
+/**
+ * Returns the total weight of the path found by the last query.
+ */
+double ALTSearch::getCost() const
+{
+    return cost;
+}
+
+/**
+ * Returns how many vertices the last query settled.
+ */
+size_t ALTSearch::getSettledCount() const
+{
+    return settledCount;
+}
+
+/**
+ * Returns the IDs of the landmarks, in the order they were picked.
+ */
+const std::vector<VertexId>& ALTSearch::getLandmarks() const
+{
+    return landmarks;
+}
+
+/**
+ * Returns the bytes taken by the distance tables, which grow linearly
+ * with the number of landmarks.
+ */
+size_t ALTSearch::tableBytes() const
+{
+    return (fromLandmark.size() + toLandmark.size()) * sizeof(Label);
+}
+
+/**
+ * Picks landmarks farthest-first by undirected hop distance.
+ * @param count - how many to pick
+ */
+void ALTSearch::pickLandmarks(unsigned count)
+{
+    size_t vertices = forward.vertexCount();
+    if (vertices == 0)
+        return;
+    CSRGraph backward = forward.reversed();
+
+    // start from the busiest airport, so every landmark lies in its component
+    VertexId root = 0;
+    for (VertexId v = 1; v < vertices; v++)
+        if (forward.degree(v) + backward.degree(v) > forward.degree(root) + backward.degree(root))
+            root = v;
+
+    std::vector<unsigned> hops(vertices, UINT32_MAX);
+    std::vector<VertexId> pending;
+    hops[root] = 0;
+    pending.push_back(root);
+    while (landmarks.size() < std::min<size_t>(count, vertices))
+    {
+        // multi-source BFS from everything queued so far, both directions
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            VertexId u = pending[i];
+            for (const CSRGraph* side : {&forward, &backward})
+            {
+                for (uint32_t e = side->edgeBegin(u); e < side->edgeEnd(u); e++)
+                {
+                    VertexId v = side->target(e);
+                    if (hops[v] <= hops[u] + 1)
+                        continue;
+                    hops[v] = hops[u] + 1;
+                    pending.push_back(v);
+                }
+            }
+        }
+
+        VertexId farthest = Graph::InvalidVertexId;
+        unsigned farthestHops = 0;
+        for (VertexId v = 0; v < vertices; v++)
+        {
+            if (hops[v] != UINT32_MAX && hops[v] > farthestHops)
+            {
+                farthest = v;
+                farthestHops = hops[v];
+            }
+        }
+        // everything reachable is already a landmark
+        if (farthest == Graph::InvalidVertexId)
+        {
+            if (!landmarks.empty())
+                break;
+            farthest = root;
+        }
+
+        landmarks.push_back(farthest);
+        // the root only seeds the first search
+        if (landmarks.size() == 1)
+            std::fill(hops.begin(), hops.end(), UINT32_MAX);
+        hops[farthest] = 0;
+        pending.assign(1, farthest);
+    }
+}
+
+/**
+ * Runs Dijkstra on reduced weights from one landmark and stores the
+ * distances in one column of a table.
+ * @param graph - forward for distances from the landmark, reversed for
+ *                distances to it
+ * @param backwards - whether graph's edges point against the real direction
+ * @param column - which landmark
+ * @param table - fromLandmark or toLandmark
+ */
+void ALTSearch::fillColumn(const CSRGraph& graph, bool backwards, size_t column, std::vector<Label>& table)
+{
+    size_t stride = landmarks.size();
+    VertexId root = landmarks[column];
+    std::vector<char> done(graph.vertexCount(), 0);
+    IndexedHeap<Label> pending;
+    pending.reset(graph.vertexCount());
+    table[root * stride + column] = std::make_pair(0.0, 0u);
+    pending.push(root, table[root * stride + column]);
+    while (!pending.empty())
+    {
+        VertexId u = pending.pop();
+        done[u] = 1;
+        for (uint32_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++)
+        {
+            VertexId v = graph.target(e);
+            if (done[v])
+                continue;
+            // reduced weight of the real edge, which runs v -> u when searching backwards
+            double reduced = backwards ? graph.weight(e) + potential[v] - potential[u]
+                                       : graph.weight(e) + potential[u] - potential[v];
+            const Label& from = table[u * stride + column];
+            Label candidate = std::make_pair(from.first + std::max(0.0, reduced), from.second + 1);
+            if (candidate < table[v * stride + column])
+            {
+                table[v * stride + column] = candidate;
+                pending.decreaseKey(v, candidate);
+            }
+        }
+    }
+}
+
+/**
+ * Largest landmark lower bound on the distance from a vertex to the
+ * destination.
+ * @return - the bound, with an infinite weight if the destination
+ *           cannot be reached from v
+ */
+ALTSearch::Bound ALTSearch::lowerBound(VertexId v, VertexId destination) const
+{
+    size_t stride = landmarks.size();
+    const Label* fromV = &fromLandmark[v * stride];
+    const Label* fromT = &fromLandmark[destination * stride];
+    const Label* toV = &toLandmark[v * stride];
+    const Label* toT = &toLandmark[destination * stride];
+    Bound best = std::make_pair(0.0, 0);
+    for (size_t i = 0; i < stride; i++)
+    {
+        // L reaches v but not t, or t reaches L but v does not: v cannot reach t
+        if ((fromV[i].first != Infinity && fromT[i].first == Infinity) ||
+            (toT[i].first != Infinity && toV[i].first == Infinity))
+            return std::make_pair(Infinity, 0);
+        if (fromV[i].first != Infinity)
+            best = std::max(best, std::make_pair(fromT[i].first - fromV[i].first,
+                                                 static_cast<int>(fromT[i].second) - static_cast<int>(fromV[i].second)));
+        if (toT[i].first != Infinity)
+            best = std::max(best, std::make_pair(toV[i].first - toT[i].first,
+                                                 static_cast<int>(toV[i].second) - static_cast<int>(toT[i].second)));
+    }
+    return best;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file altSearch.h
+ * Safest-path search guided by landmark distances (A*, landmarks and the
+ * triangle inequality).
+ */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "csrGraph.h"
+#include "indexedHeap.h"
+
+/**
+ * Answers safest-path queries with A*, using lower bounds taken from
+ * precomputed distances to and from a few landmark airports. These
+ * landmarks only guide the search; they have nothing to do with the
+ * airports a landmark path (safeCovid::getPathLandmarkDijkstra) must visit.
+ *
+ * Paths are ranked like safeCovid's Dijkstra, by total weight and then by
+ * number of flights. Such (weight, flights) pairs, added componentwise and
+ * compared lexicographically, obey the triangle inequality like plain
+ * numbers do, so for a landmark L and destination t
+ *
+ *   dist(u, t) >= dist(L, t) - dist(L, u)  and  dist(u, t) >= dist(u, L) - dist(t, L)
+ *
+ * and the largest of these over all landmarks is a consistent heuristic.
+ * The flight count matters here: the safeCovid weights are zero on most
+ * edges, and it is the flight count that gives the bounds their pull.
+ *
+ * Like BidirectionalDijkstra, the search runs on Johnson-reduced weights
+ * (see CSRGraph::feasiblePotential), which leaves the ranking of paths
+ * between two fixed vertices unchanged. A graph with a negative cycle is
+ * reported as unusable.
+ *
+ * Landmarks are picked farthest-first: each one is the vertex the most
+ * flights away (ignoring direction) from the ones already picked.
+ */
+class ALTSearch
+{
+  public:
+    /**
+     * Constructs an engine with no graph.
+     */
+    ALTSearch();
+
+    /**
+     * Picks the landmarks and computes the distances to and from them.
+     * @param g - the graph to search; it is copied
+     * @param landmarkCount - how many landmarks to pick; more give tighter
+     *                        bounds at the cost of memory and build time
+     */
+    ALTSearch(const CSRGraph& g, unsigned landmarkCount);
+
+    /**
+     * Whether queries can be answered, which is false if the graph has a
+     * negative cycle.
+     */
+    bool usable() const;
+
+    /**
+     * Finds the safest path between two vertices.
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @param path - filled with the IDs along the path, source first;
+     *               left empty if there is no path
+     * @param useLandmarks - false to run plain Dijkstra on the same weights
+     * @return - whether a path was found
+     */
+    bool findPath(VertexId source, VertexId destination, std::vector<VertexId>& path, bool useLandmarks = true);
+
+    /**
+     * Returns the total weight of the path found by the last query.
+     */
+    double getCost() const;
+
+    /**
+     * Returns how many vertices the last query settled.
+     */
+    size_t getSettledCount() const;
+
+    /**
+     * Returns the IDs of the landmarks, in the order they were picked.
+     */
+    const std::vector<VertexId>& getLandmarks() const;
+
+    /**
+     * Returns the bytes taken by the distance tables, which grow linearly
+     * with the number of landmarks.
+     */
+    size_t tableBytes() const;
+
+  private:
+    /** A path's total reduced weight and its number of edges. */
+    typedef std::pair<double, unsigned> Label;
+    /** A lower bound on a Label; either part may be negative. */
+    typedef std::pair<double, int> Bound;
+
+    CSRGraph forward;
+    std::vector<double> potential;
+    bool cycleFree;
+    std::vector<VertexId> landmarks;
+    std::vector<Label> fromLandmark; /**< dist(L_i, v) at [v * landmarks.size() + i] **/
+    std::vector<Label> toLandmark; /**< dist(v, L_i) at [v * landmarks.size() + i] **/
+
+    std::vector<Label> label;
+    std::vector<Bound> estimate; /**< Heuristic of each reached vertex, computed once per query **/
+    std::vector<VertexId> pred;
+    std::vector<char> settled;
+    std::vector<VertexId> reached; /**< Every labeled vertex, for resetting **/
+    IndexedHeap<Bound> queue;
+    double cost;
+    size_t settledCount;
+
+    /**
+     * Picks landmarks farthest-first by undirected hop distance.
+     * @param count - how many to pick
+     */
+    void pickLandmarks(unsigned count);
+
+    /**
+     * Runs Dijkstra on reduced weights from one landmark and stores the
+     * distances in one column of a table.
+     * @param graph - forward for distances from the landmark, reversed for
+     *                distances to it
+     * @param backwards - whether graph's edges point against the real direction
+     * @param column - which landmark
+     * @param table - fromLandmark or toLandmark
+     */
+    void fillColumn(const CSRGraph& graph, bool backwards, size_t column, std::vector<Label>& table);
+
+    /**
+     * Largest landmark lower bound on the distance from a vertex to the
+     * destination.
+     * @return - the bound, with an infinite weight if the destination
+     *           cannot be reached from v
+     */
+    Bound lowerBound(VertexId v, VertexId destination) const;
+};
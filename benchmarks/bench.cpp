@@ -0,0 +1,1332 @@
+/**
+ * @file bench.cpp
+ * Benchmarks for SAFECOVID.
+ *
+ * Build with "make bench" and run "./bench [name ...]" from the project
+ * root. With no arguments every benchmark is run.
+ */
+
+#include "../safecovid.h"
+#include "../graphBuilder.h"
+#include "../routeFile.h"
+#include "../graphSnapshot.h"
+#include "../csrGraph.h"
+#include "../indexedHeap.h"
+#include "../bidirectionalDijkstra.h"
+#include "../directionOptimizingBFS.h"
+#include "../multiSourceBFS.h"
+#include "../hopMatrix.h"
+#include "../riskMatrix.h"
+#include "../aStarSearch.h"
+#include "../altSearch.h"
+#include "../contractionHierarchy.h"
+#include "../customizableHierarchy.h"
+#include "../hubLabels.h"
+#include "../shortestPathTree.h"
+#include "../distanceTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <iostream>
+#include <queue>
+#include <unordered_map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+const std::string kRoutes = "data/edges.txt";
+
+/**
+ * Milliseconds elapsed since start.
+ */
+double millisSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/**
+ * Reads the source and destination IATA codes of every route row.
+ */
+std::vector<std::pair<std::string, std::string>> readRoutes(const std::string& filename)
+{
+    std::vector<std::pair<std::string, std::string>> routes;
+    std::ifstream in(filename);
+    std::string line;
+    while (getline(in, line))
+    {
+        std::vector<std::string> words;
+        size_t begin = 0;
+        for (size_t pos = line.find(','); pos != std::string::npos; pos = line.find(',', begin))
+        {
+            words.push_back(line.substr(begin, pos - begin));
+            begin = pos + 1;
+        }
+        words.push_back(line.substr(begin));
+        routes.push_back(std::make_pair(words[2], words[4]));
+    }
+    return routes;
+}
+
+/**
+ * Startup cost: loading data/edges.txt through safeCovid, and building the
+ * same graph with one insertVertex/insertEdge call per route row the way
+ * safeCovid used to.
+ */
+void benchStartup()
+{
+    const int rounds = 5;
+    double best = 0;
+    size_t vertices = 0;
+    for (int i = 0; i < rounds; i++)
+    {
+        Clock::time_point start = Clock::now();
+        safeCovid s(kRoutes);
+        double elapsed = millisSince(start);
+        if (i == 0 || elapsed < best)
+            best = elapsed;
+        vertices = s.getAirportGraph().getVertices().size();
+    }
+    std::cout << "  safeCovid(\"" << kRoutes << "\"): " << best << " ms (best of "
+              << rounds << ", " << vertices << " airports)" << std::endl;
+
+    std::vector<std::pair<std::string, std::string>> routes = readRoutes(kRoutes);
+
+    Clock::time_point start = Clock::now();
+    GraphBuilder builder;
+    builder.reserve(2 * routes.size(), routes.size());
+    for (const auto& r : routes)
+    {
+        builder.addVertex(r.first);
+        builder.addVertex(r.second);
+        builder.addEdge(r.first, r.second);
+    }
+    Graph bulk(true, true);
+    builder.build(bulk);
+    std::cout << "  GraphBuilder, " << routes.size() << " rows: " << millisSince(start)
+              << " ms" << std::endl;
+
+    start = Clock::now();
+    Graph legacy(true, true);
+    for (const auto& r : routes)
+    {
+        legacy.insertVertex(r.first);
+        legacy.insertVertex(r.second);
+    }
+    for (const auto& r : routes)
+        legacy.insertEdge(r.first, r.second);
+    std::cout << "  insertVertex/insertEdge per row, " << routes.size() << " rows: "
+              << millisSince(start) << " ms" << std::endl;
+}
+
+/**
+ * Prints the throughput of parsing bytes/rows in the given time.
+ */
+void printThroughput(const std::string& what, size_t bytes, size_t rows, double millis)
+{
+    double seconds = millis / 1000.0;
+    std::cout << "  " << what << ": " << rows << " rows, " << bytes / 1e6 << " MB in " << millis
+              << " ms = " << bytes / 1e6 / seconds << " MB/s, " << rows / seconds << " rows/s"
+              << std::endl;
+}
+
+/**
+ * Writes data/edges.txt repeated the given number of times to /tmp.
+ * @return the path of the written file
+ */
+std::string writeScaledRoutes(int copies)
+{
+    const std::string scaled = "/tmp/safecovid_routes_x" + std::to_string(copies) + ".txt";
+    RouteFile source(kRoutes);
+    std::ofstream out(scaled.c_str(), std::ios::binary);
+    for (int i = 0; i < copies && source.size() > 0; i++)
+        out.write(source.data(), source.size());
+    return scaled;
+}
+
+/**
+ * Times one pass of RouteFile over a file, best of the given rounds.
+ */
+void timeRouteFile(const std::string& what, const std::string& filename, int rounds)
+{
+    double best = 0;
+    size_t rows = 0;
+    size_t bytes = 0;
+    for (int i = 0; i < rounds; i++)
+    {
+        Clock::time_point start = Clock::now();
+        RouteFile routes(filename);
+        size_t codeBytes = 0;
+        rows = routes.forEachRoute([&codeBytes](const Field& source, const Field& dest) {
+            codeBytes += source.size + dest.size;
+        });
+        double elapsed = millisSince(start);
+        if (i == 0 || elapsed < best)
+            best = elapsed;
+        bytes = routes.size();
+        if (codeBytes == 0)
+            std::cout << "  (no routes found in " << filename << ")" << std::endl;
+    }
+    printThroughput(what, bytes, rows, best);
+}
+
+/**
+ * Route file parse throughput: the getline/substr loop safeCovid used to
+ * run, against the memory-mapped RouteFile, on data/edges.txt and on a
+ * copy of it repeated 100 times.
+ */
+void benchParse()
+{
+    Clock::time_point start = Clock::now();
+    std::ifstream in(kRoutes);
+    std::string line;
+    size_t rows = 0;
+    size_t bytes = 0;
+    while (getline(in, line))
+    {
+        bytes += line.size() + 1;
+        std::vector<std::string> words;
+        size_t pos = 0;
+        while (true)
+        {
+            pos = line.find(",");
+            if (pos == std::string::npos)
+            {
+                words.push_back(line);
+                break;
+            }
+            words.push_back(line.substr(0, pos));
+            line = line.substr(pos + 1);
+        }
+        rows++;
+    }
+    printThroughput("getline/substr, " + kRoutes, bytes, rows, millisSince(start));
+
+    timeRouteFile("RouteFile, " + kRoutes, kRoutes, 5);
+
+    const std::string scaled = writeScaledRoutes(100);
+    timeRouteFile("RouteFile, data/edges.txt x100", scaled, 3);
+    std::remove(scaled.c_str());
+}
+
+/**
+ * Parallel load scaling: a full safeCovid load of data/edges.txt repeated
+ * 20 times on 1 up to N threads, where N is the number of cores (at least
+ * 4). Every thread parses and interns its own chunk of the file, then the
+ * chunks are merged, built into the graph and weighted on the calling
+ * thread.
+ */
+void benchIngest()
+{
+    const std::string scaled = writeScaledRoutes(20);
+    unsigned cores = std::thread::hardware_concurrency();
+    unsigned maxThreads = std::max(4u, cores);
+    std::cout << "  " << cores << " hardware threads" << std::endl;
+
+    RouteFile routes(scaled);
+    size_t rows = routes.forEachRoute([](const Field&, const Field&) {});
+
+    double single = 0;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        double best = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            Clock::time_point start = Clock::now();
+            safeCovid s(scaled, person(), threads);
+            double elapsed = millisSince(start);
+            if (i == 0 || elapsed < best)
+                best = elapsed;
+        }
+        if (threads == 1)
+            single = best;
+        printThroughput(std::to_string(threads) + " thread(s)", routes.size(), rows, best);
+        std::cout << "    speedup over 1 thread: " << single / best << "x" << std::endl;
+        if (threads < maxThreads && threads * 2 > maxThreads)
+            threads = maxThreads / 2;
+    }
+    std::remove(scaled.c_str());
+}
+
+/**
+ * Cold start with and without the binary graph snapshot: safeCovid built
+ * from the CSV and asked to write data/edges.txt.graph, then safeCovid
+ * loaded from that snapshot.
+ */
+void benchSnapshot()
+{
+    const std::string snapshot = kRoutes + ".graph";
+    std::remove(snapshot.c_str());
+
+    Clock::time_point start = Clock::now();
+    {
+        safeCovid s(kRoutes, person(), 0, snapshot);
+    }
+    std::cout << "  safeCovid from CSV (and writing the snapshot): " << millisSince(start) << " ms"
+              << std::endl;
+
+    MappedFile written(snapshot);
+    std::cout << "  snapshot size: " << written.size() / 1e6 << " MB" << std::endl;
+
+    start = Clock::now();
+    uint64_t fingerprint = MappedFile(kRoutes).fingerprint();
+    std::cout << "  fingerprint of " << kRoutes << ": " << millisSince(start) << " ms" << std::endl;
+
+    double best = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        start = Clock::now();
+        safeCovid s(kRoutes, person(), 0, snapshot);
+        double elapsed = millisSince(start);
+        if (i == 0 || elapsed < best)
+            best = elapsed;
+    }
+    std::cout << "  safeCovid from snapshot: " << best << " ms (best of 5)" << std::endl;
+
+    Graph g(true, true);
+    start = Clock::now();
+    bool loaded = GraphSnapshot::load(g, snapshot, fingerprint);
+    std::cout << "  GraphSnapshot::load alone: " << millisSince(start) << " ms"
+              << (loaded ? "" : " (failed)") << std::endl;
+}
+
+/**
+ * Edges traversed per second by a full BFS from every 16th airport, over
+ * the Graph's hash maps (getAdjacent, visited set keyed by name) and over
+ * the frozen CSR view (visited array indexed by ID).
+ */
+void benchTraverse()
+{
+    safeCovid s(kRoutes);
+    Graph g = s.getAirportGraph();
+    const CSRGraph& csr = s.getNetwork();
+
+    vector<Vertex> roots;
+    for (VertexId id = 0; id < csr.vertexCount(); id += 16)
+        roots.push_back(csr.getVertexName(id));
+
+    Clock::time_point start = Clock::now();
+    size_t edges = 0;
+    for (const Vertex& root : roots)
+    {
+        std::unordered_map<Vertex, bool> visited;
+        std::queue<Vertex> q;
+        visited[root] = true;
+        q.push(root);
+        while (!q.empty())
+        {
+            Vertex v = q.front();
+            q.pop();
+            for (const Vertex& w : g.getAdjacent(v))
+            {
+                edges++;
+                if (!visited[w])
+                {
+                    visited[w] = true;
+                    q.push(w);
+                }
+            }
+        }
+    }
+    double graphMillis = millisSince(start);
+    std::cout << "  Graph BFS x" << roots.size() << ": " << edges << " edges in " << graphMillis
+              << " ms = " << edges / graphMillis / 1e3 << " M edges/s" << std::endl;
+
+    start = Clock::now();
+    size_t csrEdges = 0;
+    std::vector<char> visited(csr.vertexCount());
+    std::vector<VertexId> queue(csr.vertexCount());
+    for (const Vertex& root : roots)
+    {
+        std::fill(visited.begin(), visited.end(), 0);
+        size_t head = 0;
+        size_t tail = 0;
+        VertexId r = g.getVertexId(root);
+        visited[r] = 1;
+        queue[tail++] = r;
+        while (head < tail)
+        {
+            VertexId v = queue[head++];
+            for (uint32_t e = csr.edgeBegin(v); e < csr.edgeEnd(v); e++)
+            {
+                csrEdges++;
+                VertexId w = csr.target(e);
+                if (!visited[w])
+                {
+                    visited[w] = 1;
+                    queue[tail++] = w;
+                }
+            }
+        }
+    }
+    double csrMillis = millisSince(start);
+    std::cout << "  CSR BFS x" << roots.size() << ": " << csrEdges << " edges in " << csrMillis
+              << " ms = " << csrEdges / csrMillis / 1e3 << " M edges/s (" << graphMillis / csrMillis
+              << "x)" << std::endl;
+
+    start = Clock::now();
+    CSRGraph frozen(g);
+    std::cout << "  freezing the graph: " << millisSince(start) << " ms" << std::endl;
+}
+
+/**
+ * Reweighting cost: safeCovid::setPerson (initializeWeights over the CSR
+ * view) against the old loop that called getAdjacent four times per edge.
+ */
+void benchWeights()
+{
+    safeCovid s(kRoutes);
+    Clock::time_point start = Clock::now();
+    s.setPerson(21);
+    std::cout << "  setPerson (forEachNeighbor/degree): " << millisSince(start) << " ms" << std::endl;
+
+    Graph g = s.getAirportGraph();
+    person p;
+    p.setAge(21);
+    start = Clock::now();
+    vector<Edge> edges = g.getEdges();
+    for (const Edge& e : edges)
+    {
+        if (g.getAdjacent(e.source).size() == 0)
+            continue;
+        p.rate(g.getAdjacent(e.source).size());
+        double rate1 = p.getRate();
+        if (g.getAdjacent(e.dest).size() == 0)
+            continue;
+        p.rate(g.getAdjacent(e.dest).size());
+        double rate2 = p.getRate();
+        g.setEdgeWeight(e.source, e.dest, rate2 - rate1);
+    }
+    std::cout << "  old loop (getAdjacent copies): " << millisSince(start) << " ms" << std::endl;
+}
+
+/**
+ * Runs Dijkstra's algorithm from every root over the CSR view with an
+ * IndexedHeap of the given arity, using costs[e] as the cost of edge e.
+ * @return the number of decrease-key operations that moved a queued key
+ */
+template <unsigned Arity>
+size_t dijkstraRuns(const CSRGraph& csr, const std::vector<double>& costs, const std::vector<VertexId>& roots)
+{
+    size_t decreases = 0;
+    std::vector<double> dist(csr.vertexCount());
+    std::vector<char> settled(csr.vertexCount());
+    IndexedHeap<double, Arity> queue(csr.vertexCount());
+    for (VertexId root : roots)
+    {
+        std::fill(dist.begin(), dist.end(), std::numeric_limits<double>::infinity());
+        std::fill(settled.begin(), settled.end(), 0);
+        dist[root] = 0;
+        queue.push(root, 0);
+        while (!queue.empty())
+        {
+            VertexId v = queue.pop();
+            settled[v] = 1;
+            for (uint32_t e = csr.edgeBegin(v); e < csr.edgeEnd(v); e++)
+            {
+                VertexId w = csr.target(e);
+                double candidate = dist[v] + costs[e];
+                if (settled[w] || candidate >= dist[w])
+                    continue;
+                decreases += queue.contains(w);
+                dist[w] = candidate;
+                queue.decreaseKey(w, candidate);
+            }
+        }
+    }
+    return decreases;
+}
+
+/**
+ * Full single-source Dijkstra runs from every 16th airport with the
+ * IndexedHeap at arity 2, 4 and 8. The route weights are almost all zero,
+ * which never exercises decrease-key, so edges get pseudo-random costs
+ * instead. Also times safeCovid::getPathDijkstra end to end.
+ */
+void benchHeap()
+{
+    safeCovid s(kRoutes);
+    const CSRGraph& csr = s.getNetwork();
+
+    std::vector<double> costs(csr.edgeCount());
+    uint32_t state = 12345;
+    for (double& cost : costs)
+    {
+        state = state * 1664525u + 1013904223u;
+        cost = 1 + (state >> 8) % 1000;
+    }
+    std::vector<VertexId> roots;
+    for (VertexId id = 0; id < csr.vertexCount(); id += 16)
+        roots.push_back(id);
+
+    Clock::time_point start = Clock::now();
+    size_t decreases = dijkstraRuns<2>(csr, costs, roots);
+    double millis = millisSince(start);
+    std::cout << "  arity 2: " << millis / roots.size() << " ms per SSSP (" << decreases / roots.size()
+              << " decrease-keys each)" << std::endl;
+
+    start = Clock::now();
+    dijkstraRuns<4>(csr, costs, roots);
+    millis = millisSince(start);
+    std::cout << "  arity 4: " << millis / roots.size() << " ms per SSSP" << std::endl;
+
+    start = Clock::now();
+    dijkstraRuns<8>(csr, costs, roots);
+    millis = millisSince(start);
+    std::cout << "  arity 8: " << millis / roots.size() << " ms per SSSP" << std::endl;
+
+    s.setPerson(21);
+    start = Clock::now();
+    s.getPathDijkstra("ORD", "MNL");
+    std::cout << "  safeCovid::getPathDijkstra ORD -> MNL: " << millisSince(start) << " ms" << std::endl;
+}
+
+/**
+ * Point-to-point getPathDijkstra between random pairs of the 100 busiest
+ * airports, against a full DijkstraSSSP from the same origins.
+ */
+void benchQuery()
+{
+    safeCovid s(kRoutes);
+    s.setPerson(21);
+    const CSRGraph& csr = s.getNetwork();
+
+    std::vector<VertexId> hubs;
+    for (VertexId id = 0; id < csr.vertexCount(); id++)
+        hubs.push_back(id);
+    std::sort(hubs.begin(), hubs.end(), [&csr](VertexId a, VertexId b) { return csr.degree(a) > csr.degree(b); });
+    hubs.resize(std::min<size_t>(hubs.size(), 100));
+
+    const size_t queries = 1000;
+    std::vector<std::pair<Vertex, Vertex>> pairs;
+    uint32_t state = 12345;
+    for (size_t i = 0; i < queries; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        VertexId a = hubs[(state >> 8) % hubs.size()];
+        state = state * 1664525u + 1013904223u;
+        VertexId b = hubs[(state >> 8) % hubs.size()];
+        pairs.push_back(std::make_pair(csr.getVertexName(a), csr.getVertexName(b)));
+    }
+
+    Clock::time_point start = Clock::now();
+    size_t fullSettled = 0;
+    for (const std::pair<Vertex, Vertex>& q : pairs)
+    {
+        s.DijkstraSSSP(q.first);
+        fullSettled += s.getSettledCount();
+    }
+    double fullMillis = millisSince(start);
+    std::cout << "  full SSSP: " << fullMillis * 1e3 / queries << " us/query, " << fullSettled / queries
+              << " settled" << std::endl;
+
+    start = Clock::now();
+    size_t settled = 0;
+    for (const std::pair<Vertex, Vertex>& q : pairs)
+    {
+        s.getPathDijkstra(q.first, q.second);
+        settled += s.getSettledCount();
+    }
+    double millis = millisSince(start);
+    std::cout << "  getPathDijkstra: " << millis * 1e3 / queries << " us/query, " << settled / queries
+              << " settled (" << fullMillis / millis << "x)" << std::endl;
+}
+
+/**
+ * Random origin-destination pairs over the whole network, answered by
+ * getPathDijkstra in each query mode.
+ */
+void benchBidirectional()
+{
+    safeCovid s(kRoutes);
+    s.setPerson(21);
+    const CSRGraph& csr = s.getNetwork();
+
+    const size_t queries = 2000;
+    std::vector<std::pair<Vertex, Vertex>> pairs;
+    uint32_t state = 54321;
+    for (size_t i = 0; i < queries; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        VertexId a = (state >> 8) % csr.vertexCount();
+        state = state * 1664525u + 1013904223u;
+        VertexId b = (state >> 8) % csr.vertexCount();
+        pairs.push_back(std::make_pair(csr.getVertexName(a), csr.getVertexName(b)));
+    }
+
+    Clock::time_point start = Clock::now();
+    BidirectionalDijkstra engine(csr);
+    std::cout << "  building the reversed graph and potential: " << millisSince(start) << " ms" << std::endl;
+
+    double baseline = 0;
+    const safeCovid::QueryMode modes[] = {safeCovid::Unidirectional, safeCovid::Bidirectional};
+    const char* names[] = {"unidirectional", "bidirectional"};
+    for (int m = 0; m < 2; m++)
+    {
+        s.setQueryMode(modes[m]);
+        s.getPathDijkstra(pairs[0].first, pairs[0].second);
+        start = Clock::now();
+        size_t settled = 0;
+        for (const std::pair<Vertex, Vertex>& q : pairs)
+        {
+            s.getPathDijkstra(q.first, q.second);
+            settled += s.getSettledCount();
+        }
+        double millis = millisSince(start);
+        if (m == 0)
+            baseline = millis;
+        std::cout << "  " << names[m] << ": " << millis * 1e3 / queries << " us/query, " << settled / queries
+                  << " settled (" << baseline / millis << "x)" << std::endl;
+    }
+}
+
+/**
+ * Random fewest-hop queries answered by getPathBFS (bidirectional BFS),
+ * next to a full BFSstart traversal, which is what getPathBFS used to run
+ * for every query.
+ */
+void benchHops()
+{
+    safeCovid s(kRoutes);
+    const CSRGraph& csr = s.getNetwork();
+
+    const size_t queries = 2000;
+    std::vector<std::pair<Vertex, Vertex>> pairs;
+    uint32_t state = 98765;
+    for (size_t i = 0; i < queries; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        VertexId a = (state >> 8) % csr.vertexCount();
+        state = state * 1664525u + 1013904223u;
+        VertexId b = (state >> 8) % csr.vertexCount();
+        pairs.push_back(std::make_pair(csr.getVertexName(a), csr.getVertexName(b)));
+    }
+
+    const size_t fullRuns = 200;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < fullRuns; i++)
+        s.BFSstart(pairs[i].first);
+    double fullMillis = millisSince(start);
+    std::cout << "  BFSstart: " << fullMillis / fullRuns * 1e3 << " us/traversal" << std::endl;
+
+    start = Clock::now();
+    size_t discovery = 0;
+    for (VertexId v = 0; v < csr.vertexCount(); v++)
+        for (Neighbor n : csr.neighbors(v))
+            discovery += s.getEdgeLabel(csr.getVertexName(v), csr.getVertexName(n.id)) == safeCovid::Discovery;
+    std::cout << "  labelling every edge on request: " << millisSince(start) << " ms (" << discovery
+              << " discovery edges)" << std::endl;
+
+    // getPathBFS prints a line for every unconnected pair
+    std::streambuf* saved = std::cout.rdbuf(NULL);
+    start = Clock::now();
+    size_t found = 0;
+    for (const std::pair<Vertex, Vertex>& q : pairs)
+        found += !s.getPathBFS(q.first, q.second).empty();
+    double millis = millisSince(start);
+    std::cout.rdbuf(saved);
+    std::cout << "  getPathBFS: " << millis * 1e3 / queries << " us/query (" << found << " of " << queries
+              << " connected)" << std::endl;
+
+    const unsigned maxHops = 2;
+    size_t within = 0;
+    std::vector<std::string> path;
+    start = Clock::now();
+    for (const std::pair<Vertex, Vertex>& q : pairs)
+        within += s.getPathBFS(q.first, q.second, maxHops, path) == PathFound;
+    millis = millisSince(start);
+    std::cout << "  getPathBFS within " << maxHops << " hops: " << millis * 1e3 / queries << " us/query (" << within
+              << " of " << queries << " found)" << std::endl;
+}
+
+/**
+ * Random long-haul queries (over 8000 km apart) on the distance-based
+ * cost, A* with the great-circle heuristic vs plain Dijkstra.
+ */
+void benchRiskMatrix()
+{
+    safeCovid s(kRoutes);
+    const CSRGraph& csr = s.getNetwork();
+    size_t count = csr.vertexCount();
+
+    // every weight is -1 before setPerson, so a cycle is found at once
+    Clock::time_point start = Clock::now();
+    RiskMatrix cyclic(csr);
+    std::cout << "  unweighted graph: " << (cyclic.hasNegativeCycle() ? "negative cycle" : "no negative cycle")
+              << " found in " << millisSince(start) << " ms" << std::endl;
+
+    s.setPerson(21);
+    // min and add per k per pair, padding not counted
+    double flops = 2.0 * count * count * count;
+    RiskMatrix risks;
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= cores; threads *= 2)
+    {
+        start = Clock::now();
+        risks = RiskMatrix(csr, threads);
+        double millis = millisSince(start);
+        std::cout << "  " << count << " x " << count << ", " << RiskMatrix::BlockSize << "-wide tiles, " << threads
+                  << " thread(s): " << millis << " ms, " << flops / (millis / 1e3) / 1e9 << " GFLOP/s, "
+                  << risks.bytes() / 1e6 << " MB" << std::endl;
+    }
+
+    // spot-check against hub labels, which rank on the same weights
+    HubLabels labels(csr);
+    size_t reachable = 0;
+    size_t mismatches = 0;
+    double lowest = 0;
+    for (VertexId a = 0; a < count; a += 7)
+    {
+        for (VertexId b = 0; b < count; b++)
+        {
+            double expected = labels.distance(a, b);
+            float found = risks.risk(a, b);
+            if (found != RiskMatrix::Unreachable)
+            {
+                reachable++;
+                lowest = std::min<double>(lowest, found);
+            }
+            if ((found == RiskMatrix::Unreachable) != (expected == std::numeric_limits<double>::infinity())
+                || (found != RiskMatrix::Unreachable && found != expected))
+                mismatches++;
+        }
+    }
+    std::cout << "  rows checked against hub labels: " << reachable << " reachable pairs, lowest risk " << lowest
+              << ", " << mismatches << " mismatches" << std::endl;
+}
+
+void benchTrees()
+{
+    safeCovid s(kRoutes);
+    s.setPerson(21);
+    s.setQueryMode(safeCovid::Unidirectional);
+    const CSRGraph& csr = s.getNetwork();
+    size_t count = csr.vertexCount();
+
+    // one tree, then a route to every airport read off it
+    Clock::time_point start = Clock::now();
+    ShortestPathTree tree(csr, 0, ShortestPathTree::Risk);
+    double grow = millisSince(start);
+    std::vector<VertexId> ids;
+    size_t flights = 0;
+    start = Clock::now();
+    for (VertexId d = 0; d < count; d++)
+        if (tree.pathTo(d, ids))
+            flights += ids.size() - 1;
+    double millis = millisSince(start);
+    std::cout << "  risk tree: " << grow << " ms, then " << count << " routes in " << millis << " ms ("
+              << count / (millis / 1e3) / 1e6 << " M routes/s, " << flights << " flights)" << std::endl;
+
+    // landmark queries over a few popular starts and landmarks, as an
+    // itinerary planner would issue them
+    const size_t queries = 2000;
+    const size_t popular = 6;
+    std::vector<std::string> starts;
+    std::vector<std::string> landmarks;
+    std::vector<std::string> destinations;
+    uint32_t state = 13579;
+    for (size_t i = 0; i < queries; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        starts.push_back(csr.getVertexName((state >> 8) % popular * 101));
+        state = state * 1664525u + 1013904223u;
+        landmarks.push_back(csr.getVertexName((state >> 8) % popular * 211 + 7));
+        state = state * 1664525u + 1013904223u;
+        destinations.push_back(csr.getVertexName((state >> 8) % count));
+    }
+
+    // the old way: one search per leg
+    start = Clock::now();
+    size_t legs = 0;
+    for (size_t i = 0; i < queries; i++)
+        legs += s.getPathDijkstra(starts[i], landmarks[i]).size() + s.getPathDijkstra(landmarks[i], destinations[i]).size();
+    double baseline = millisSince(start);
+    std::cout << "  " << queries << " landmark queries, two Dijkstra searches each: " << baseline << " ms (" << legs
+              << " airports)" << std::endl;
+
+    start = Clock::now();
+    size_t airports = 0;
+    for (size_t i = 0; i < queries; i++)
+        airports += s.getPathLandmarkDijkstra(starts[i], landmarks[i], destinations[i]).size();
+    millis = millisSince(start);
+    std::cout << "  " << queries << " landmark queries from kept risk trees: " << millis << " ms (" << airports
+              << " airports, " << baseline / millis << "x)" << std::endl;
+
+    start = Clock::now();
+    airports = 0;
+    for (size_t i = 0; i < queries; i++)
+        airports += s.getPathLandmarkBFS(starts[i], landmarks[i], destinations[i]).size();
+    millis = millisSince(start);
+    std::cout << "  " << queries << " landmark queries from kept hop trees: " << millis << " ms (" << airports
+              << " airports)" << std::endl;
+}
+
+void benchTable()
+{
+    safeCovid s(kRoutes);
+    s.setPerson(21);
+    const Graph& airports = s.getAirportGraph();
+    const CSRGraph& csr = s.getNetwork();
+
+    const char* usHubs[] = {"ATL", "ORD", "LAX", "DFW", "DEN", "JFK", "SFO", "SEA", "LAS", "MCO",
+                            "EWR", "CLT", "PHX", "IAH", "MIA", "BOS", "MSP", "DTW", "FLL", "PHL",
+                            "LGA", "BWI", "SLC", "DCA", "MDW", "IAD", "SAN", "TPA", "PDX", "HNL"};
+    const char* asiaHubs[] = {"HND", "PEK", "PVG", "CAN", "HKG", "ICN", "NRT", "SIN", "BKK", "KUL",
+                              "CGK", "MNL", "TPE", "DEL", "BOM", "CTU", "KMG", "SZX", "XIY", "CKG",
+                              "HGH", "SGN", "HAN", "KIX", "NGO", "FUK", "CTS", "DMK", "CEB", "DPS",
+                              "SUB", "KNO", "PUS", "GMP", "BLR", "MAA", "HYD", "CCU", "TAO", "XMN"};
+    std::vector<std::string> sources;
+    std::vector<std::string> targets;
+    for (const char* code : usHubs)
+        if (airports.vertexExists(code))
+            sources.push_back(code);
+    for (const char* code : asiaHubs)
+        if (airports.vertexExists(code))
+            targets.push_back(code);
+    size_t cells = sources.size() * targets.size();
+
+    // the old way: one query per cell
+    s.setQueryMode(safeCovid::Unidirectional);
+    Clock::time_point start = Clock::now();
+    for (const std::string& a : sources)
+        for (const std::string& b : targets)
+            s.getPathDijkstra(a, b);
+    double baseline = millisSince(start);
+    std::cout << "  " << sources.size() << " x " << targets.size() << " hubs, one Dijkstra per cell: " << baseline
+              << " ms, " << cells / (baseline / 1e3) << " cells/s" << std::endl;
+
+    std::vector<double> table;
+    start = Clock::now();
+    s.getRiskTable(sources, targets, table, 1);
+    std::cout << "  contraction hierarchy: " << millisSince(start) << " ms" << std::endl;
+
+    s.setQueryMode(safeCovid::CH);
+    start = Clock::now();
+    for (const std::string& a : sources)
+        for (const std::string& b : targets)
+            s.getPathDijkstra(a, b);
+    double point = millisSince(start);
+    std::cout << "  one CH query per cell: " << point << " ms, " << cells / (point / 1e3) << " cells/s" << std::endl;
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= cores; threads *= 2)
+    {
+        const int rounds = 20;
+        start = Clock::now();
+        for (int i = 0; i < rounds; i++)
+            s.getRiskTable(sources, targets, table, threads);
+        double millis = millisSince(start) / rounds;
+        std::cout << "  bucket table, " << threads << " thread(s): " << millis << " ms, " << cells / (millis / 1e3)
+                  << " cells/s (" << baseline / millis << "x)" << std::endl;
+    }
+
+    // a bigger table over random airports
+    size_t count = csr.vertexCount();
+    std::vector<VertexId> many;
+    uint32_t state = 8642;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        many.push_back((state >> 8) % count);
+    }
+    ContractionHierarchy hierarchy(csr);
+    DistanceTable engine;
+    for (unsigned threads = 1; threads <= cores; threads *= 2)
+    {
+        start = Clock::now();
+        engine.fill(hierarchy, many, many, table, threads);
+        double millis = millisSince(start);
+        size_t reachable = table.size() - std::count(table.begin(), table.end(), std::numeric_limits<double>::infinity());
+        std::cout << "  " << many.size() << " x " << many.size() << " random airports, " << threads
+                  << " thread(s): " << millis << " ms, " << table.size() / (millis / 1e3) / 1e6 << " M cells/s, "
+                  << engine.getBucketEntries() << " bucket entries, " << reachable << " reachable" << std::endl;
+    }
+}
+
+void benchAStar()
+{
+    safeCovid s(kRoutes);
+    s.setPerson(21);
+    Clock::time_point start = Clock::now();
+    s.loadCoordinates("data/airportcodes.txt");
+    const AirportLocations& locations = s.getLocations();
+    const CSRGraph& csr = s.getNetwork();
+    std::cout << "  loading coordinates: " << millisSince(start) << " ms (" << locations.knownCount() << " of "
+              << csr.vertexCount() << " airports located)" << std::endl;
+
+    start = Clock::now();
+    AStarSearch engine(csr, locations);
+    std::cout << "  choosing anchors and edge costs: " << millisSince(start) << " ms" << std::endl;
+
+    const size_t queries = 1000;
+    std::vector<std::pair<VertexId, VertexId>> pairs;
+    uint32_t state = 24680;
+    while (pairs.size() < queries)
+    {
+        state = state * 1664525u + 1013904223u;
+        VertexId a = (state >> 8) % csr.vertexCount();
+        state = state * 1664525u + 1013904223u;
+        VertexId b = (state >> 8) % csr.vertexCount();
+        if (locations.known(a) && locations.known(b) && locations.distanceKm(a, b) > 8000)
+            pairs.push_back(std::make_pair(a, b));
+    }
+
+    std::vector<VertexId> path;
+    double baseline = 0;
+    const char* names[] = {"Dijkstra", "A*"};
+    for (int useHeuristic = 0; useHeuristic < 2; useHeuristic++)
+    {
+        start = Clock::now();
+        size_t settled = 0;
+        for (const std::pair<VertexId, VertexId>& q : pairs)
+        {
+            engine.findPath(q.first, q.second, path, useHeuristic);
+            settled += engine.getSettledCount();
+        }
+        double millis = millisSince(start);
+        if (useHeuristic == 0)
+            baseline = millis;
+        std::cout << "  " << names[useHeuristic] << ": " << millis * 1e3 / queries << " us/query, "
+                  << settled / queries << " settled (" << baseline / millis << "x)" << std::endl;
+    }
+}
+
+/**
+ * ALT preprocessing time, table size and random query latency for a range
+ * of landmark counts, next to getPathDijkstra's unidirectional search.
+ */
+void benchALT()
+{
+    safeCovid s(kRoutes);
+    s.setPerson(21);
+    const CSRGraph& csr = s.getNetwork();
+
+    const size_t queries = 2000;
+    std::vector<std::pair<VertexId, VertexId>> pairs;
+    uint32_t state = 13579;
+    for (size_t i = 0; i < queries; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        VertexId a = (state >> 8) % csr.vertexCount();
+        state = state * 1664525u + 1013904223u;
+        VertexId b = (state >> 8) % csr.vertexCount();
+        pairs.push_back(std::make_pair(a, b));
+    }
+
+    s.setQueryMode(safeCovid::Unidirectional);
+    Clock::time_point start = Clock::now();
+    size_t settled = 0;
+    for (const std::pair<VertexId, VertexId>& q : pairs)
+    {
+        s.getPathDijkstra(csr.getVertexName(q.first), csr.getVertexName(q.second));
+        settled += s.getSettledCount();
+    }
+    double baseline = millisSince(start);
+    std::cout << "  Dijkstra: " << baseline * 1e3 / queries << " us/query, " << settled / queries << " settled"
+              << std::endl;
+
+    std::vector<VertexId> path;
+    const unsigned counts[] = {1, 2, 4, 8, 16, 32};
+    for (unsigned k : counts)
+    {
+        start = Clock::now();
+        ALTSearch engine(csr, k);
+        double buildMillis = millisSince(start);
+
+        start = Clock::now();
+        settled = 0;
+        for (const std::pair<VertexId, VertexId>& q : pairs)
+        {
+            engine.findPath(q.first, q.second, path);
+            settled += engine.getSettledCount();
+        }
+        double millis = millisSince(start);
+        std::cout << "  " << k << " landmarks: build " << buildMillis << " ms, "
+                  << engine.tableBytes() / k / 1024.0 << " KiB/landmark, " << millis * 1e3 / queries
+                  << " us/query, " << settled / queries << " settled (" << baseline / millis << "x)" << std::endl;
+    }
+}
+
+/**
+ * Contraction hierarchy build, save and load times, and random query
+ * latency next to getPathDijkstra's unidirectional search.
+ */
+void benchCH()
+{
+    safeCovid s(kRoutes);
+    s.setPerson(21);
+    const CSRGraph& csr = s.getNetwork();
+
+    Clock::time_point start = Clock::now();
+    ContractionHierarchy hierarchy(csr);
+    std::cout << "  contracting " << csr.vertexCount() << " vertices: " << millisSince(start) << " ms, "
+              << hierarchy.shortcutCount() << " shortcuts" << std::endl;
+
+    const std::string file = "data/bench_hierarchy.ch";
+    start = Clock::now();
+    hierarchy.save(file);
+    std::cout << "  save: " << millisSince(start) << " ms" << std::endl;
+    start = Clock::now();
+    ContractionHierarchy loaded;
+    loaded.load(file, csr);
+    std::cout << "  load (with fingerprint check): " << millisSince(start) << " ms" << std::endl;
+    std::remove(file.c_str());
+
+    const size_t queries = 2000;
+    std::vector<std::pair<VertexId, VertexId>> pairs;
+    uint32_t state = 86420;
+    for (size_t i = 0; i < queries; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        VertexId a = (state >> 8) % csr.vertexCount();
+        state = state * 1664525u + 1013904223u;
+        VertexId b = (state >> 8) % csr.vertexCount();
+        pairs.push_back(std::make_pair(a, b));
+    }
+
+    s.setQueryMode(safeCovid::Unidirectional);
+    start = Clock::now();
+    size_t settled = 0;
+    for (const std::pair<VertexId, VertexId>& q : pairs)
+    {
+        s.getPathDijkstra(csr.getVertexName(q.first), csr.getVertexName(q.second));
+        settled += s.getSettledCount();
+    }
+    double baseline = millisSince(start);
+    std::cout << "  Dijkstra: " << baseline * 1e3 / queries << " us/query, " << settled / queries << " settled"
+              << std::endl;
+
+    std::vector<VertexId> path;
+    start = Clock::now();
+    settled = 0;
+    for (const std::pair<VertexId, VertexId>& q : pairs)
+    {
+        loaded.findPath(q.first, q.second, path);
+        settled += loaded.getSettledCount();
+    }
+    double millis = millisSince(start);
+    std::cout << "  CH with path unpacking: " << millis * 1e3 / queries << " us/query, " << settled / queries
+              << " settled (" << baseline / millis << "x)" << std::endl;
+}
+
+void benchCCH()
+{
+    safeCovid s(kRoutes);
+    const CSRGraph& csr = s.getNetwork();
+
+    Clock::time_point start = Clock::now();
+    CustomizableHierarchy customizable(csr);
+    std::cout << "  ordering " << csr.vertexCount() << " vertices: " << millisSince(start) << " ms, "
+              << customizable.arcCount() << " arcs" << std::endl;
+
+    const size_t queries = 2000;
+    std::vector<std::pair<VertexId, VertexId>> pairs;
+    uint32_t state = 97531;
+    for (size_t i = 0; i < queries; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        VertexId a = (state >> 8) % csr.vertexCount();
+        state = state * 1664525u + 1013904223u;
+        VertexId b = (state >> 8) % csr.vertexCount();
+        pairs.push_back(std::make_pair(a, b));
+    }
+
+    std::vector<VertexId> path;
+    for (float age : {10.0f, 21.0f, 45.0f, 70.0f, 90.0f})
+    {
+        s.setPerson(age);
+        start = Clock::now();
+        customizable.customize(csr);
+        double customizeMillis = millisSince(start);
+
+        start = Clock::now();
+        size_t settled = 0;
+        for (const std::pair<VertexId, VertexId>& q : pairs)
+        {
+            customizable.findPath(q.first, q.second, path);
+            settled += customizable.getSettledCount();
+        }
+        double millis = millisSince(start);
+        std::cout << "  age " << age << ": customize " << customizeMillis << " ms, "
+                  << customizable.getHierarchy().shortcutCount() << " shortcut arcs, " << millis * 1e3 / queries
+                  << " us/query, " << settled / queries << " settled" << std::endl;
+    }
+
+    // what each new person would cost without customization
+    start = Clock::now();
+    ContractionHierarchy hierarchy(csr);
+    double rebuild = millisSince(start);
+    start = Clock::now();
+    size_t settled = 0;
+    for (const std::pair<VertexId, VertexId>& q : pairs)
+    {
+        hierarchy.findPath(q.first, q.second, path);
+        settled += hierarchy.getSettledCount();
+    }
+    std::cout << "  full CH rebuild: " << rebuild << " ms, " << millisSince(start) * 1e3 / queries << " us/query, "
+              << settled / queries << " settled" << std::endl;
+}
+
+void benchLabels()
+{
+    safeCovid s(kRoutes);
+    s.setPerson(21);
+    const CSRGraph& csr = s.getNetwork();
+
+    Clock::time_point start = Clock::now();
+    HubLabels labels(csr);
+    std::cout << "  labeling " << csr.vertexCount() << " vertices: " << millisSince(start) << " ms, "
+              << static_cast<double>(labels.entryCount()) / (2 * csr.vertexCount()) << " hubs per label, "
+              << labels.indexBytes() / 1e6 << " MB" << std::endl;
+
+    // every ordered pair, the batch analytics case
+    size_t count = csr.vertexCount();
+    start = Clock::now();
+    double checksum = 0;
+    size_t reachable = 0;
+    for (VertexId a = 0; a < count; a++)
+    {
+        for (VertexId b = 0; b < count; b++)
+        {
+            double d = labels.distance(a, b);
+            if (d != std::numeric_limits<double>::infinity())
+            {
+                checksum += d;
+                reachable++;
+            }
+        }
+    }
+    double millis = millisSince(start);
+    std::cout << "  all " << count * count << " distances: " << millis << " ms, "
+              << count * count / (millis / 1e3) / 1e6 << " M lookups/s (" << reachable << " reachable, checksum "
+              << checksum << ")" << std::endl;
+
+    const size_t queries = 2000;
+    std::vector<std::pair<VertexId, VertexId>> pairs;
+    uint32_t state = 24680;
+    for (size_t i = 0; i < queries; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        VertexId a = (state >> 8) % count;
+        state = state * 1664525u + 1013904223u;
+        VertexId b = (state >> 8) % count;
+        pairs.push_back(std::make_pair(a, b));
+    }
+
+    s.setQueryMode(safeCovid::Unidirectional);
+    start = Clock::now();
+    for (const std::pair<VertexId, VertexId>& q : pairs)
+        s.getPathDijkstra(csr.getVertexName(q.first), csr.getVertexName(q.second));
+    double baseline = millisSince(start);
+    std::cout << "  Dijkstra: " << baseline * 1e3 / queries << " us/query" << std::endl;
+
+    std::vector<VertexId> path;
+    start = Clock::now();
+    for (const std::pair<VertexId, VertexId>& q : pairs)
+        labels.findPath(q.first, q.second, path);
+    millis = millisSince(start);
+    std::cout << "  labels with path unpacking: " << millis * 1e3 / queries << " us/query (" << baseline / millis
+              << "x)" << std::endl;
+}
+
+void benchLayers()
+{
+    safeCovid s(kRoutes);
+    const CSRGraph& csr = s.getNetwork();
+    Graph g = s.getAirportGraph();
+    DirectionOptimizingBFS layers(csr);
+    std::vector<unsigned> hops;
+
+    const DirectionOptimizingBFS::Strategy strategies[] = {DirectionOptimizingBFS::TopDownOnly,
+                                                           DirectionOptimizingBFS::BottomUpOnly,
+                                                           DirectionOptimizingBFS::Adaptive};
+    const char* strategyNames[] = {"top-down", "bottom-up", "adaptive"};
+    for (const char* hub : {"ATL", "FRA"})
+    {
+        VertexId root = g.getVertexId(hub);
+        for (int i = 0; i < 3; i++)
+        {
+            layers.run(root, hops, strategies[i]);
+            std::cout << "  " << hub << " " << strategyNames[i] << ": " << layers.getTopDownLevels()
+                      << " top-down + " << layers.getBottomUpLevels() << " bottom-up levels, "
+                      << layers.getEdgesExamined() << " edges examined" << std::endl;
+        }
+    }
+
+    // whole hop layers from every root, as the analytics would
+    for (int i = 0; i < 3; i++)
+    {
+        Clock::time_point start = Clock::now();
+        size_t examined = 0;
+        for (VertexId root = 0; root < csr.vertexCount(); root++)
+        {
+            layers.run(root, hops, strategies[i]);
+            examined += layers.getEdgesExamined();
+        }
+        double millis = millisSince(start);
+        std::cout << "  all " << csr.vertexCount() << " roots, " << strategyNames[i] << ": " << millis << " ms, "
+                  << millis * 1e3 / csr.vertexCount() << " us/root, " << examined / csr.vertexCount()
+                  << " edges examined/root" << std::endl;
+    }
+}
+
+void benchAllHops()
+{
+    safeCovid s(kRoutes);
+    const CSRGraph& csr = s.getNetwork();
+    size_t count = csr.vertexCount();
+
+    // the baseline: one direction-optimizing BFS per source
+    DirectionOptimizingBFS single(csr);
+    std::vector<unsigned> hops;
+    Clock::time_point start = Clock::now();
+    unsigned diameter = 0;
+    for (VertexId root = 0; root < count; root++)
+    {
+        single.run(root, hops);
+        for (unsigned h : hops)
+            if (h != DirectionOptimizingBFS::Unreached)
+                diameter = std::max(diameter, h);
+    }
+    double baseline = millisSince(start);
+    std::cout << "  " << count << " single-source BFS runs: " << baseline << " ms (diameter " << diameter << ")"
+              << std::endl;
+
+    MultiSourceBFS batch(csr);
+    std::vector<uint8_t> matrix;
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= cores; threads *= 2)
+    {
+        start = Clock::now();
+        batch.allPairs(matrix, threads);
+        double millis = millisSince(start);
+        size_t reachable = count * count - std::count(matrix.begin(), matrix.end(), MultiSourceBFS::Unreached);
+        std::cout << "  all-pairs, " << MultiSourceBFS::Width << " sources per traversal, " << threads
+                  << " thread(s): " << millis << " ms, " << count / (millis / 1e3) << " sources/s, " << reachable
+                  << " reachable pairs (" << baseline / millis << "x)" << std::endl;
+    }
+}
+
+void benchHopMatrix()
+{
+    safeCovid s(kRoutes);
+    const CSRGraph& csr = s.getNetwork();
+    size_t count = csr.vertexCount();
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    Clock::time_point start = Clock::now();
+    HopMatrix matrix(csr, cores);
+    std::cout << "  build on " << cores << " thread(s): " << millisSince(start) << " ms, " << matrix.bytes() / 1e6
+              << " MB" << std::endl;
+
+    const std::string file = "data/bench_hops.bin";
+    start = Clock::now();
+    matrix.save(file);
+    std::cout << "  save: " << millisSince(start) << " ms" << std::endl;
+    start = Clock::now();
+    HopMatrix loaded;
+    loaded.load(file, csr);
+    std::cout << "  load (with topology check): " << millisSince(start) << " ms" << std::endl;
+    std::remove(file.c_str());
+
+    const size_t queries = 1000000;
+    std::vector<std::pair<VertexId, VertexId>> pairs;
+    uint32_t state = 13579;
+    for (size_t i = 0; i < queries; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        VertexId a = (state >> 8) % count;
+        state = state * 1664525u + 1013904223u;
+        VertexId b = (state >> 8) % count;
+        pairs.push_back(std::make_pair(a, b));
+    }
+    start = Clock::now();
+    size_t within = 0;
+    for (const std::pair<VertexId, VertexId>& q : pairs)
+        within += loaded.withinHops(q.first, q.second, 3);
+    double millis = millisSince(start);
+    std::cout << "  within-3-flights lookups: " << queries / (millis / 1e3) / 1e6 << " M/s (" << within
+              << " of " << queries << ")" << std::endl;
+
+    // fewest-flight routes: bidirectional BFS vs walking down the matrix
+    BidirectionalBFS search(csr);
+    std::vector<VertexId> path;
+    const size_t routes = 20000;
+    start = Clock::now();
+    for (size_t i = 0; i < routes; i++)
+        search.findPath(pairs[i].first, pairs[i].second, path);
+    double baseline = millisSince(start);
+    start = Clock::now();
+    for (size_t i = 0; i < routes; i++)
+        loaded.findPath(csr, pairs[i].first, pairs[i].second, path);
+    millis = millisSince(start);
+    std::cout << "  routes: bidirectional BFS " << baseline * 1e3 / routes << " us, matrix walk "
+              << millis * 1e3 / routes << " us (" << baseline / millis << "x)" << std::endl;
+}
+
+struct Benchmark
+{
+    const char* name;
+    const char* description;
+    void (*run)();
+};
+
+const Benchmark kBenchmarks[] = {
+    {"startup", "graph construction from data/edges.txt", benchStartup},
+    {"parse", "route file parse throughput", benchParse},
+    {"ingest", "full safeCovid load with parallel parsing, 1 to N threads", benchIngest},
+    {"snapshot", "cold start from CSV vs binary snapshot", benchSnapshot},
+    {"traverse", "BFS edges/s over Graph hash maps vs CSR", benchTraverse},
+    {"weights", "initializeWeights with and without neighbor copies", benchWeights},
+    {"heap", "Dijkstra with the indexed d-ary heap at arity 2, 4 and 8", benchHeap},
+    {"query", "point-to-point Dijkstra between hubs vs full SSSP", benchQuery},
+    {"bidirectional", "random queries, unidirectional vs bidirectional Dijkstra", benchBidirectional},
+    {"hops", "random fewest-hop queries, bidirectional BFS vs BFSstart", benchHops},
+    {"layers", "whole-graph hop layers, top-down vs bottom-up vs direction-optimizing BFS", benchLayers},
+    {"allhops", "all-pairs hop matrix, bit-parallel multi-source BFS vs one BFS per source", benchAllHops},
+    {"hopmatrix", "all-pairs hop matrix build, persistence, O(1) lookups and route walks", benchHopMatrix},
+    {"risk", "all-pairs least-risk matrix, blocked min-plus Floyd-Warshall by thread count", benchRiskMatrix},
+    {"trees", "kept shortest-path trees for landmark queries vs one search per leg", benchTrees},
+    {"table", "many-to-many risk tables, bucket searches on a CH vs one query per cell", benchTable},
+    {"astar", "long-haul distance-cost queries, A* vs Dijkstra", benchAStar},
+    {"alt", "ALT preprocessing and queries by landmark count vs Dijkstra", benchALT},
+    {"ch", "contraction hierarchy build, persistence and queries vs Dijkstra", benchCH},
+    {"cch", "customizable CH: one order, new weights per age vs a full CH rebuild", benchCCH},
+    {"labels", "hub label build, all-pairs distance lookups and path queries", benchLabels},
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bool ranAny = false;
+    for (const Benchmark& b : kBenchmarks)
+    {
+        bool selected = (argc == 1);
+        for (int i = 1; i < argc; i++)
+            selected = selected || strcmp(argv[i], b.name) == 0;
+        if (!selected)
+            continue;
+        std::cout << b.name << ": " << b.description << std::endl;
+        b.run();
+        ranAny = true;
+    }
+
+    if (!ranAny)
+    {
+        std::cerr << "usage: " << argv[0] << " [benchmark ...]" << std::endl << "benchmarks:";
+        for (const Benchmark& b : kBenchmarks)
+            std::cerr << " " << b.name;
+        std::cerr << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "bidirectionalBFS.h"
+
+#include <algorithm>
+#include <climits>
+
+const unsigned BidirectionalBFS::NoHopLimit = UINT_MAX;
+
+/**
+ * Constructs an engine with no graph.
+ */
+BidirectionalBFS::BidirectionalBFS() : visitedCount(0)
+{
+}
+
+/**
+ * Prepares the forward and reversed graphs.
+ * @param g - the graph to search; it is copied
+ */
+BidirectionalBFS::BidirectionalBFS(const CSRGraph& g) : forward(g), backward(g.reversed()), visitedCount(0)
+{
+    size_t count = forward.vertexCount();
+    for (Side* side : {&fromSource, &fromDestination})
+    {
+        side->pred.assign(count, Graph::InvalidVertexId);
+        side->visited.assign(count, 0);
+    }
+}
+
+/**
+ * Finds a route with the fewest edges between two vertices, using at
+ * most maxHops edges. No route longer than the limit is accepted; if
+ * the limit is reached first, the search carries on only to tell
+ * NoPathWithinHops from NoPath, until the sides meet or the smaller
+ * one runs out.
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @param path - filled with the IDs along the route, source first;
+ *               left empty if there is no route
+ * @param maxHops - the most edges the route may use
+ * @return - PathFound, NoPathWithinHops or NoPath
+ */
+HopSearchResult BidirectionalBFS::findPath(VertexId source, VertexId destination, std::vector<VertexId>& path,
+                                           unsigned maxHops)
+{
+    path.clear();
+    resetSide(fromSource);
+    resetSide(fromDestination);
+    visitedCount = 0;
+    if (source >= forward.vertexCount() || destination >= forward.vertexCount())
+        return NoPath;
+
+    fromSource.visited[source] = 1;
+    fromSource.reached.push_back(source);
+    fromSource.frontier.push_back(source);
+    fromDestination.visited[destination] = 1;
+    fromDestination.reached.push_back(destination);
+    fromDestination.frontier.push_back(destination);
+    visitedCount = (source == destination) ? 1 : 2;
+
+    VertexId meet = (source == destination) ? source : Graph::InvalidVertexId;
+    bool tooFar = false;
+    while (meet == Graph::InvalidVertexId && !fromSource.frontier.empty() && !fromDestination.frontier.empty())
+    {
+        // the next meeting would need depth + depth + 1 hops; past the
+        // limit a meeting only shows that the destination is reachable
+        if (fromSource.depth + fromDestination.depth >= maxHops)
+            tooFar = true;
+        if (fromSource.frontier.size() <= fromDestination.frontier.size())
+            meet = expand(fromSource, forward, fromDestination);
+        else
+            meet = expand(fromDestination, backward, fromSource);
+    }
+    if (meet == Graph::InvalidVertexId)
+        return NoPath;
+    if (tooFar)
+        return NoPathWithinHops;
+
+    for (VertexId v = meet; v != Graph::InvalidVertexId; v = fromSource.pred[v])
+        path.push_back(v);
+    std::reverse(path.begin(), path.end());
+    for (VertexId v = fromDestination.pred[meet]; v != Graph::InvalidVertexId; v = fromDestination.pred[v])
+        path.push_back(v);
+    return PathFound;
+}
+
+/**
+ * Returns how many vertices the last query visited, both sides together.
+ */
+size_t BidirectionalBFS::getVisitedCount() const
+{
+    return visitedCount;
+}
+
+/**
+ * Empties one side, resetting only the vertices it visited last time.
+ */
+void BidirectionalBFS::resetSide(Side& side)
+{
+    for (VertexId v : side.reached)
+    {
+        side.pred[v] = Graph::InvalidVertexId;
+        side.visited[v] = 0;
+    }
+    side.reached.clear();
+    side.frontier.clear();
+    side.next.clear();
+    side.depth = 0;
+}
+
+/**
+ * Visits every neighbor of one side's frontier and makes them the new
+ * frontier, stopping early if a neighbor was already visited by the
+ * other side.
+ * @param side - the side to expand
+ * @param graph - forward for the source side, backward for the other
+ * @param other - the opposite side
+ * @return - the vertex where the sides met, or Graph::InvalidVertexId
+ */
+VertexId BidirectionalBFS::expand(Side& side, const CSRGraph& graph, const Side& other)
+{
+    side.next.clear();
+    for (VertexId u : side.frontier)
+    {
+        for (uint32_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++)
+        {
+            VertexId w = graph.target(e);
+            if (side.visited[w])
+                continue;
+            side.visited[w] = 1;
+            side.pred[w] = u;
+            side.reached.push_back(w);
+            visitedCount++;
+            if (other.visited[w])
+            {
+                side.depth++;
+                return w;
+            }
+            side.next.push_back(w);
+        }
+    }
+    side.frontier.swap(side.next);
+    side.depth++;
+    return Graph::InvalidVertexId;
+}
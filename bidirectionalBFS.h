@@ -0,0 +1,107 @@
+/**
+ * @file bidirectionalBFS.h
+ * Point-to-point fewest-hop search from both ends at once.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "csrGraph.h"
+
+/**
+ * Outcome of a fewest-hop search.
+ */
+enum HopSearchResult
+{
+    PathFound, /**< A route was found within the hop limit **/
+    NoPathWithinHops, /**< There are routes, but every one needs more hops than allowed **/
+    NoPath /**< The destination cannot be reached at all **/
+};
+
+/**
+ * Finds a route with the fewest flights between two airports by running
+ * breadth-first search forward from the origin and backward from the
+ * destination (over the reversed graph). Each round expands one whole
+ * level of whichever side has the smaller frontier, and the search stops
+ * at the first vertex reached by both sides.
+ *
+ * Until the sides meet, everything within depth a of the origin and depth
+ * b of the destination is disjoint, so the first meeting found while
+ * expanding a level is already a shortest route, with a + b hops. That
+ * also means a hop limit k can be enforced by never letting a + b pass k.
+ */
+class BidirectionalBFS
+{
+  public:
+    /**
+     * Constructs an engine with no graph.
+     */
+    BidirectionalBFS();
+
+    /**
+     * Prepares the forward and reversed graphs.
+     * @param g - the graph to search; it is copied
+     */
+    BidirectionalBFS(const CSRGraph& g);
+
+    /**
+     * Finds a route with the fewest edges between two vertices, using at
+     * most maxHops edges. No route longer than the limit is accepted; if
+     * the limit is reached first, the search carries on only to tell
+     * NoPathWithinHops from NoPath, until the sides meet or the smaller
+     * one runs out.
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @param path - filled with the IDs along the route, source first;
+     *               left empty if there is no route
+     * @param maxHops - the most edges the route may use
+     * @return - PathFound, NoPathWithinHops or NoPath
+     */
+    HopSearchResult findPath(VertexId source, VertexId destination, std::vector<VertexId>& path,
+                             unsigned maxHops = NoHopLimit);
+
+    /** maxHops value that does not limit the search. **/
+    const static unsigned NoHopLimit;
+
+    /**
+     * Returns how many vertices the last query visited, both sides together.
+     */
+    size_t getVisitedCount() const;
+
+  private:
+    /**
+     * Search state for one direction, indexed by vertex ID.
+     */
+    struct Side
+    {
+        std::vector<VertexId> pred; /**< Neighbor one step closer to this side's root **/
+        std::vector<char> visited;
+        std::vector<VertexId> reached; /**< Every visited vertex, for resetting **/
+        std::vector<VertexId> frontier;
+        std::vector<VertexId> next;
+        unsigned depth = 0; /**< Levels expanded so far **/
+    };
+
+    CSRGraph forward;
+    CSRGraph backward;
+    Side fromSource;
+    Side fromDestination;
+    size_t visitedCount;
+
+    /**
+     * Empties one side, resetting only the vertices it visited last time.
+     */
+    void resetSide(Side& side);
+
+    /**
+     * Visits every neighbor of one side's frontier and makes them the new
+     * frontier, stopping early if a neighbor was already visited by the
+     * other side.
+     * @param side - the side to expand
+     * @param graph - forward for the source side, backward for the other
+     * @param other - the opposite side
+     * @return - the vertex where the sides met, or Graph::InvalidVertexId
+     */
+    VertexId expand(Side& side, const CSRGraph& graph, const Side& other);
+};
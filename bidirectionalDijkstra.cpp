@@ -0,0 +1,185 @@
+#include "bidirectionalDijkstra.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+
+const double Infinity = std::numeric_limits<double>::infinity();
+
+std::pair<double, unsigned> operator+(const std::pair<double, unsigned>& a, const std::pair<double, unsigned>& b)
+{
+    return std::make_pair(a.first + b.first, a.second + b.second);
+}
+
+} // namespace
+
+/**
+ * Constructs an engine with no graph.
+ */
+BidirectionalDijkstra::BidirectionalDijkstra() : cycleFree(false), cost(Infinity), settledCount(0)
+{
+}
+
+/**
+ * Prepares the forward and reversed graphs and the vertex potential.
+ * @param g - the graph to search; it is copied
+ */
+BidirectionalDijkstra::BidirectionalDijkstra(const CSRGraph& g)
+    : forward(g), backward(g.reversed()), cost(Infinity), settledCount(0)
+{
+    cycleFree = forward.feasiblePotential(potential);
+
+    size_t count = forward.vertexCount();
+    for (Side* side : {&fromSource, &fromDestination})
+    {
+        side->label.assign(count, std::make_pair(Infinity, 0u));
+        side->pred.assign(count, Graph::InvalidVertexId);
+        side->settled.assign(count, 0);
+        side->queue.reset(count);
+    }
+}
+
+/**
+ * Whether queries can be answered, which is false if the graph has a
+ * negative cycle.
+ */
+bool BidirectionalDijkstra::usable() const
+{
+    return cycleFree;
+}
+
+/**
+ * Finds the safest path between two vertices.
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @param path - filled with the IDs along the path, source first;
+ *               left empty if there is no path
+ * @return - whether a path was found
+ */
+bool BidirectionalDijkstra::findPath(VertexId source, VertexId destination, std::vector<VertexId>& path)
+{
+    path.clear();
+    resetSide(fromSource);
+    resetSide(fromDestination);
+    cost = Infinity;
+    settledCount = 0;
+    if (!cycleFree || source >= forward.vertexCount() || destination >= forward.vertexCount())
+        return false;
+
+    Label start = std::make_pair(0.0, 0u);
+    fromSource.label[source] = start;
+    fromSource.reached.push_back(source);
+    fromSource.queue.push(source, start);
+    fromDestination.label[destination] = start;
+    fromDestination.reached.push_back(destination);
+    fromDestination.queue.push(destination, start);
+
+    Label best = std::make_pair(Infinity, 0u);
+    VertexId meet = Graph::InvalidVertexId;
+    if (source == destination)
+    {
+        best = start;
+        meet = source;
+    }
+
+    while (!fromSource.queue.empty() && !fromDestination.queue.empty())
+    {
+        const Label& forwardTop = fromSource.queue.topPriority();
+        const Label& backwardTop = fromDestination.queue.topPriority();
+        // nothing left in either queue can be part of a better path
+        if (!(forwardTop + backwardTop < best))
+            break;
+        if (forwardTop < backwardTop || (forwardTop == backwardTop && fromSource.queue.size() <= fromDestination.queue.size()))
+            advance(fromSource, forward, fromDestination, false, best, meet);
+        else
+            advance(fromDestination, backward, fromSource, true, best, meet);
+    }
+
+    if (meet == Graph::InvalidVertexId)
+        return false;
+
+    for (VertexId v = meet; v != Graph::InvalidVertexId; v = fromSource.pred[v])
+        path.push_back(v);
+    std::reverse(path.begin(), path.end());
+    for (VertexId v = fromDestination.pred[meet]; v != Graph::InvalidVertexId; v = fromDestination.pred[v])
+        path.push_back(v);
+
+    cost = best.first - potential[source] + potential[destination];
+    return true;
+}
+
+/**
+ * Returns the total weight of the path found by the last query.
+ */
+double BidirectionalDijkstra::getCost() const
+{
+    return cost;
+}
+
+/**
+ * Returns how many vertices the last query settled, both sides together.
+ */
+size_t BidirectionalDijkstra::getSettledCount() const
+{
+    return settledCount;
+}
+
+/**
+ * Empties one side, resetting only the vertices it reached last time.
+ */
+void BidirectionalDijkstra::resetSide(Side& side)
+{
+    for (VertexId v : side.reached)
+    {
+        side.label[v] = std::make_pair(Infinity, 0u);
+        side.pred[v] = Graph::InvalidVertexId;
+        side.settled[v] = 0;
+    }
+    side.reached.clear();
+    side.queue.clear();
+}
+
+/**
+ * Settles the top of one side's queue and relaxes its edges.
+ * @param side - the side to advance
+ * @param graph - forward for the source side, backward for the other
+ * @param other - the opposite side, checked for a meeting
+ * @param backwards - whether graph's edges point against the real direction
+ * @param best - the best meeting found so far, updated in place
+ * @param meet - the vertex where the best meeting joins the two sides
+ */
+void BidirectionalDijkstra::advance(Side& side, const CSRGraph& graph, const Side& other, bool backwards,
+                                    Label& best, VertexId& meet)
+{
+    VertexId u = side.queue.pop();
+    side.settled[u] = 1;
+    settledCount++;
+
+    for (uint32_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++)
+    {
+        VertexId v = graph.target(e);
+        if (side.settled[v])
+            continue;
+
+        // reduced weight of the real edge, which runs v -> u when searching backwards
+        double reduced = backwards ? graph.weight(e) + potential[v] - potential[u]
+                                   : graph.weight(e) + potential[u] - potential[v];
+        Label candidate = std::make_pair(side.label[u].first + std::max(0.0, reduced), side.label[u].second + 1);
+        if (candidate < side.label[v])
+        {
+            if (side.label[v].first == Infinity)
+                side.reached.push_back(v);
+            side.label[v] = candidate;
+            side.pred[v] = u;
+            side.queue.decreaseKey(v, candidate);
+        }
+
+        if (other.label[v].first != Infinity && side.label[v] + other.label[v] < best)
+        {
+            best = side.label[v] + other.label[v];
+            meet = v;
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/**
+ * @file bidirectionalDijkstra.h
+ * Point-to-point safest-path search from both ends at once.
+ */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "csrGraph.h"
+#include "indexedHeap.h"
+
+/**
+ * Answers safest-path queries by running Dijkstra's algorithm forward from
+ * the origin and backward from the destination (over the reversed graph)
+ * at the same time, always advancing the side whose queue is closer.
+ *
+ * Paths are ranked the same way as safeCovid's Dijkstra: by total weight,
+ * then by number of flights. The search stops on the usual meeting
+ * criterion, once the two queue tops together can no longer beat the best
+ * path seen through an edge joining the two sides.
+ *
+ * The meeting criterion needs non-negative weights, so the search runs on
+ * Johnson-reduced weights (see CSRGraph::feasiblePotential). A graph with
+ * a negative cycle has no such reweighting and is reported as unusable.
+ */
+class BidirectionalDijkstra
+{
+  public:
+    /**
+     * Constructs an engine with no graph.
+     */
+    BidirectionalDijkstra();
+
+    /**
+     * Prepares the forward and reversed graphs and the vertex potential.
+     * @param g - the graph to search; it is copied
+     */
+    BidirectionalDijkstra(const CSRGraph& g);
+
+    /**
+     * Whether queries can be answered, which is false if the graph has a
+     * negative cycle.
+     */
+    bool usable() const;
+
+    /**
+     * Finds the safest path between two vertices.
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @param path - filled with the IDs along the path, source first;
+     *               left empty if there is no path
+     * @return - whether a path was found
+     */
+    bool findPath(VertexId source, VertexId destination, std::vector<VertexId>& path);
+
+    /**
+     * Returns the total weight of the path found by the last query.
+     */
+    double getCost() const;
+
+    /**
+     * Returns how many vertices the last query settled, both sides together.
+     */
+    size_t getSettledCount() const;
+
+  private:
+    /** Rank of a path: total weight first, then number of edges. **/
+    typedef std::pair<double, unsigned> Label;
+
+    /**
+     * Search state for one direction, indexed by vertex ID.
+     */
+    struct Side
+    {
+        std::vector<Label> label;
+        std::vector<VertexId> pred;
+        std::vector<char> settled;
+        std::vector<VertexId> reached;
+        IndexedHeap<Label> queue;
+    };
+
+    CSRGraph forward;
+    CSRGraph backward;
+    std::vector<double> potential;
+    bool cycleFree;
+
+    Side fromSource;
+    Side fromDestination;
+    double cost;
+    size_t settledCount;
+
+    /**
+     * Empties one side, resetting only the vertices it reached last time.
+     */
+    void resetSide(Side& side);
+
+    /**
+     * Settles the top of one side's queue and relaxes its edges.
+     * @param side - the side to advance
+     * @param graph - forward for the source side, backward for the other
+     * @param other - the opposite side, checked for a meeting
+     * @param backwards - whether graph's edges point against the real direction
+     * @param best - the best meeting found so far, updated in place
+     * @param meet - the vertex where the best meeting joins the two sides
+     */
+    void advance(Side& side, const CSRGraph& graph, const Side& other, bool backwards, Label& best,
+                 VertexId& meet);
+};
@@ -0,0 +1,698 @@
+#include "contractionHierarchy.h"
+#include "mappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+const uint32_t ContractionHierarchy::Version = 1;
+
+namespace
+{
+
+const double Infinity = std::numeric_limits<double>::infinity();
+
+const char kMagic[8] = {'S', 'C', 'H', 'I', 'E', 'R', 'C', '\0'};
+
+// a witness search gives up after settling this many vertices; giving up
+// early only costs an unnecessary shortcut, never a wrong answer. Ordering
+// only needs an estimate, so it looks less far than contraction does.
+const size_t WitnessSettleLimit = 500;
+const size_t EstimateSettleLimit = 3;
+
+typedef std::pair<double, unsigned> Label;
+
+Label operator+(const Label& a, const Label& b)
+{
+    return std::make_pair(a.first + b.first, a.second + b.second);
+}
+
+/**
+ * Fixed-size start of every hierarchy file.
+ */
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t vertexCount;
+    uint64_t fingerprint;
+    uint32_t upCount;
+    uint32_t downCount;
+    uint64_t shortcuts;
+};
+
+/**
+ * Writes a vector's contents to a file.
+ */
+template <class T>
+bool writeAll(FILE* out, const std::vector<T>& values)
+{
+    return values.empty() || fwrite(values.data(), sizeof(T), values.size(), out) == values.size();
+}
+
+/**
+ * Copies a table out of a mapped file and advances the cursor past it.
+ */
+template <class T>
+void readAll(const char*& cursor, size_t count, std::vector<T>& values)
+{
+    values.resize(count);
+    if (count != 0)
+        memcpy(values.data(), cursor, count * sizeof(T));
+    cursor += count * sizeof(T);
+}
+
+/**
+ * The remaining graph while vertices are being contracted, with edges and
+ * shortcuts kept in both directions.
+ */
+class Contractor
+{
+  public:
+    /**
+     * One edge or shortcut leaving (in out) or entering (in in) a vertex.
+     */
+    struct Edge
+    {
+        VertexId other;
+        Label weight;
+        VertexId middle;
+    };
+
+    std::vector<std::vector<Edge>> up; /**< Edges v -> other kept when v was contracted **/
+    std::vector<std::vector<Edge>> down; /**< Edges other -> v kept when v was contracted **/
+    std::vector<uint32_t> rank;
+    size_t shortcuts;
+
+    /**
+     * Copies a graph's edges with their reduced weights.
+     */
+    Contractor(const CSRGraph& g, const std::vector<double>& potential)
+        : up(g.vertexCount()), down(g.vertexCount()), rank(g.vertexCount(), 0), shortcuts(0), out(g.vertexCount()),
+          in(g.vertexCount()), contractedNeighbors(g.vertexCount(), 0),
+          dist(g.vertexCount(), std::make_pair(Infinity, 0u)), isTarget(g.vertexCount(), 0)
+    {
+        for (VertexId u = 0; u < g.vertexCount(); u++)
+        {
+            for (uint32_t e = g.edgeBegin(u); e < g.edgeEnd(u); e++)
+            {
+                VertexId v = g.target(e);
+                double reduced = std::max(0.0, g.weight(e) + potential[u] - potential[v]);
+                if (u != v)
+                    addEdge(u, v, std::make_pair(reduced, 1u), Graph::InvalidVertexId);
+            }
+        }
+        queue.reset(g.vertexCount());
+    }
+
+    /**
+     * Contracts every vertex, filling rank.
+     */
+    void contractAll()
+    {
+        size_t count = out.size();
+        IndexedHeap<int> order;
+        order.reset(count);
+        for (VertexId v = 0; v < count; v++)
+            order.push(v, priority(v));
+
+        uint32_t next = 0;
+        while (!order.empty())
+        {
+            // priorities go stale as neighbors are contracted; recheck the top
+            VertexId v = order.top();
+            int current = priority(v);
+            if (current > order.topPriority())
+            {
+                order.push(v, current);
+                continue;
+            }
+            order.pop();
+
+            addShortcuts(v, true);
+            rank[v] = next++;
+            for (const std::vector<Edge>* edges : {&out[v], &in[v]})
+            {
+                for (const Edge& edge : *edges)
+                {
+                    // a full recompute per neighbor is too slow around hubs;
+                    // the lazy check above catches the rest of the change
+                    contractedNeighbors[edge.other]++;
+                    order.push(edge.other, order.priority(edge.other) + 1);
+                }
+            }
+            remove(v);
+        }
+    }
+
+  private:
+    std::vector<std::vector<Edge>> out; /**< Edges between remaining vertices, by source **/
+    std::vector<std::vector<Edge>> in; /**< The same edges by target **/
+    std::vector<int> contractedNeighbors;
+    std::vector<Label> dist; /**< Witness search labels **/
+    std::vector<char> isTarget; /**< Out-neighbors of the vertex being contracted **/
+    std::vector<VertexId> touched; /**< Every labeled vertex, for resetting **/
+    IndexedHeap<Label> queue;
+
+    /**
+     * Adds an edge or shortcut, or lowers the weight of the one already
+     * joining the same two vertices.
+     */
+    void addEdge(VertexId from, VertexId to, const Label& weight, VertexId middle)
+    {
+        for (Edge& edge : out[from])
+        {
+            if (edge.other != to)
+                continue;
+            if (weight < edge.weight)
+            {
+                edge.weight = weight;
+                edge.middle = middle;
+                for (Edge& back : in[to])
+                {
+                    if (back.other == from)
+                    {
+                        back.weight = weight;
+                        back.middle = middle;
+                    }
+                }
+            }
+            return;
+        }
+        Edge forward = {to, weight, middle};
+        Edge backward = {from, weight, middle};
+        out[from].push_back(forward);
+        in[to].push_back(backward);
+    }
+
+    /**
+     * Moves a contracted vertex's edges into up and down, and drops them
+     * from its neighbors so later searches don't step over them.
+     */
+    void remove(VertexId v)
+    {
+        for (const Edge& edge : out[v])
+        {
+            std::vector<Edge>& back = in[edge.other];
+            for (size_t i = 0; i < back.size(); i++)
+            {
+                if (back[i].other == v)
+                {
+                    back[i] = back.back();
+                    back.pop_back();
+                    break;
+                }
+            }
+        }
+        for (const Edge& edge : in[v])
+        {
+            std::vector<Edge>& forward = out[edge.other];
+            for (size_t i = 0; i < forward.size(); i++)
+            {
+                if (forward[i].other == v)
+                {
+                    forward[i] = forward.back();
+                    forward.pop_back();
+                    break;
+                }
+            }
+        }
+        up[v].swap(out[v]);
+        down[v].swap(in[v]);
+        std::vector<Edge>().swap(out[v]);
+        std::vector<Edge>().swap(in[v]);
+    }
+
+    /**
+     * Importance of a vertex: shortcuts its contraction would add, minus
+     * the edges it would remove, plus its contracted neighbors.
+     */
+    int priority(VertexId v)
+    {
+        int removed = static_cast<int>(out[v].size() + in[v].size());
+        return addShortcuts(v, false) - removed + contractedNeighbors[v];
+    }
+
+    /**
+     * Finds the shortcuts contracting v needs, adding them if asked.
+     * @return - how many are needed
+     */
+    int addShortcuts(VertexId v, bool apply)
+    {
+        int needed = 0;
+        for (size_t i = 0; i < in[v].size(); i++)
+        {
+            // copied, since adding shortcuts may grow in[v]'s neighbors' lists
+            Edge entering = in[v][i];
+            VertexId u = entering.other;
+
+            Label limit = std::make_pair(0.0, 0u);
+            size_t targets = 0;
+            for (const Edge& leaving : out[v])
+            {
+                if (leaving.other == u)
+                    continue;
+                limit = std::max(limit, entering.weight + leaving.weight);
+                isTarget[leaving.other] = 1;
+                targets++;
+            }
+            if (targets == 0)
+                continue;
+            witnessSearch(u, v, limit, targets, apply ? WitnessSettleLimit : EstimateSettleLimit);
+            for (const Edge& leaving : out[v])
+                isTarget[leaving.other] = 0;
+
+            for (size_t j = 0; j < out[v].size(); j++)
+            {
+                Edge leaving = out[v][j];
+                VertexId x = leaving.other;
+                if (x == u)
+                    continue;
+                Label via = entering.weight + leaving.weight;
+                if (!(via < dist[x]))
+                    continue;
+                needed++;
+                if (apply)
+                {
+                    addEdge(u, x, via, v);
+                    shortcuts++;
+                }
+            }
+        }
+        return needed;
+    }
+
+    /**
+     * Dijkstra from u over the remaining graph without v, until every
+     * target is settled, the queue passes limit or settleLimit vertices
+     * are settled.
+     */
+    void witnessSearch(VertexId u, VertexId v, const Label& limit, size_t targets, size_t settleLimit)
+    {
+        for (VertexId w : touched)
+            dist[w] = std::make_pair(Infinity, 0u);
+        touched.clear();
+        queue.clear();
+
+        dist[u] = std::make_pair(0.0, 0u);
+        touched.push_back(u);
+        queue.push(u, dist[u]);
+        size_t settled = 0;
+        while (!queue.empty() && settled < settleLimit && targets > 0)
+        {
+            if (limit < queue.topPriority())
+                break;
+            VertexId w = queue.pop();
+            settled++;
+            targets -= isTarget[w];
+            for (const Edge& edge : out[w])
+            {
+                VertexId x = edge.other;
+                if (x == v)
+                    continue;
+                // edges only add weight or flights, so nothing past limit
+                // (or at it, other than a target) can lead to a witness
+                Label candidate = dist[w] + edge.weight;
+                if (limit < candidate || (!isTarget[x] && !(candidate < limit)))
+                    continue;
+                if (candidate < dist[x])
+                {
+                    if (dist[x].first == Infinity)
+                        touched.push_back(x);
+                    dist[x] = candidate;
+                    queue.decreaseKey(x, candidate);
+                }
+            }
+        }
+    }
+};
+
+} // namespace
+
+/**
+ * Constructs an empty hierarchy.
+ */
+ContractionHierarchy::ContractionHierarchy()
+    : fingerprint(0), cycleFree(false), upOffsets(1, 0), downOffsets(1, 0), shortcuts(0), cost(Infinity),
+      settledCount(0)
+{
+}
+
+/**
+ * Contracts every vertex of a graph.
+ * @param g - the graph to preprocess
+ */
+ContractionHierarchy::ContractionHierarchy(const CSRGraph& g)
+    : fingerprint(g.fingerprint()), upOffsets(1, 0), downOffsets(1, 0), shortcuts(0), cost(Infinity),
+      settledCount(0)
+{
+    cycleFree = g.feasiblePotential(potential);
+    if (!cycleFree)
+        return;
+
+    Contractor contractor(g, potential);
+    contractor.contractAll();
+    rank.swap(contractor.rank);
+    shortcuts = contractor.shortcuts;
+
+    // every edge was kept at the end contracted first
+    size_t count = g.vertexCount();
+    upOffsets.assign(count + 1, 0);
+    downOffsets.assign(count + 1, 0);
+    for (VertexId v = 0; v < count; v++)
+    {
+        upOffsets[v + 1] = upOffsets[v] + contractor.up[v].size();
+        downOffsets[v + 1] = downOffsets[v] + contractor.down[v].size();
+        for (const Contractor::Edge& edge : contractor.up[v])
+        {
+            Arc arc = {edge.weight.first, edge.weight.second, edge.other, edge.middle, 0};
+            up.push_back(arc);
+        }
+        for (const Contractor::Edge& edge : contractor.down[v])
+        {
+            Arc arc = {edge.weight.first, edge.weight.second, edge.other, edge.middle, 0};
+            down.push_back(arc);
+        }
+    }
+    prepareQueries();
+}
+
+/**
+ * Whether queries can be answered, which is false if the graph has a
+ * negative cycle or nothing was built or loaded.
+ */
+bool ContractionHierarchy::usable() const
+{
+    return cycleFree;
+}
+
+/**
+ * Finds the safest path between two vertices.
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @param path - filled with the IDs along the path, source first;
+ *               left empty if there is no path
+ * @return - whether a path was found
+ */
+bool ContractionHierarchy::findPath(VertexId source, VertexId destination, std::vector<VertexId>& path)
+{
+    path.clear();
+    resetSide(fromSource);
+    resetSide(fromDestination);
+    cost = Infinity;
+    settledCount = 0;
+    if (!cycleFree || source >= rank.size() || destination >= rank.size())
+        return false;
+
+    Label start = std::make_pair(0.0, 0u);
+    fromSource.label[source] = start;
+    fromSource.reached.push_back(source);
+    fromSource.queue.push(source, start);
+    fromDestination.label[destination] = start;
+    fromDestination.reached.push_back(destination);
+    fromDestination.queue.push(destination, start);
+
+    Label best = std::make_pair(Infinity, 0u);
+    VertexId meet = Graph::InvalidVertexId;
+    if (source == destination)
+    {
+        best = start;
+        meet = source;
+    }
+
+    // both sides only climb, so each runs until its queue can't beat best
+    while (true)
+    {
+        bool forwardDone = fromSource.queue.empty() || !(fromSource.queue.topPriority() < best);
+        bool backwardDone = fromDestination.queue.empty() || !(fromDestination.queue.topPriority() < best);
+        if (forwardDone && backwardDone)
+            break;
+        if (!forwardDone && (backwardDone || fromSource.queue.topPriority() < fromDestination.queue.topPriority()))
+            advance(fromSource, upOffsets, up, fromDestination, best, meet);
+        else
+            advance(fromDestination, downOffsets, down, fromSource, best, meet);
+    }
+
+    if (meet == Graph::InvalidVertexId)
+        return false;
+
+    std::vector<VertexId> climb;
+    for (VertexId v = meet; v != Graph::InvalidVertexId; v = fromSource.pred[v])
+        climb.push_back(v);
+    path.push_back(source);
+    for (size_t i = climb.size() - 1; i > 0; i--)
+        unpack(climb[i], climb[i - 1], path);
+    for (VertexId v = meet; fromDestination.pred[v] != Graph::InvalidVertexId; v = fromDestination.pred[v])
+        unpack(v, fromDestination.pred[v], path);
+
+    cost = best.first - potential[source] + potential[destination];
+    return true;
+}
+
+/**
+ * Returns the total weight of the path found by the last query.
+ */
+double ContractionHierarchy::getCost() const
+{
+    return cost;
+}
+
+/**
+ * Returns how many vertices the last query settled, both sides together.
+ */
+size_t ContractionHierarchy::getSettledCount() const
+{
+    return settledCount;
+}
+
+/**
+ * Returns the number of shortcuts the hierarchy added.
+ */
+size_t ContractionHierarchy::shortcutCount() const
+{
+    return shortcuts;
+}
+
+/**
+ * Returns the position of a vertex in the contraction order, 0 for the
+ * first vertex contracted.
+ * @param v - the vertex ID
+ */
+uint32_t ContractionHierarchy::getRank(VertexId v) const
+{
+    return rank[v];
+}
+
+/**
+ * Writes the hierarchy to a file. The file is written next to path and
+ * renamed into place, so readers never see a partial file.
+ * @param path - where to write the hierarchy
+ * @return - whether the file was written
+ */
+bool ContractionHierarchy::save(const std::string& path) const
+{
+    if (!cycleFree)
+        return false;
+
+    Header header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = Version;
+    header.vertexCount = static_cast<uint32_t>(rank.size());
+    header.fingerprint = fingerprint;
+    header.upCount = static_cast<uint32_t>(up.size());
+    header.downCount = static_cast<uint32_t>(down.size());
+    header.shortcuts = shortcuts;
+
+    std::string tmpPath = path + ".tmp";
+    FILE* out = fopen(tmpPath.c_str(), "wb");
+    if (out == NULL)
+        return false;
+
+    // the 8-byte aligned tables go first
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+              && writeAll(out, potential)
+              && writeAll(out, up)
+              && writeAll(out, down)
+              && writeAll(out, rank)
+              && writeAll(out, upOffsets)
+              && writeAll(out, downOffsets);
+    ok = (fclose(out) == 0) && ok;
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Replaces this hierarchy with one read from a file.
+ * @param path - the file to read
+ * @param g - the graph the hierarchy is for; its fingerprint must match
+ *            the one the file was built from
+ * @return - false, leaving the hierarchy unchanged, if the file is
+ *           missing, damaged, of another format version or built for
+ *           another graph
+ */
+bool ContractionHierarchy::load(const std::string& path, const CSRGraph& g)
+{
+    MappedFile file(path);
+    if (file.size() < sizeof(Header))
+        return false;
+
+    Header header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != Version
+        || header.vertexCount != g.vertexCount() || header.fingerprint != g.fingerprint())
+        return false;
+
+    uint64_t V = header.vertexCount;
+    uint64_t expected = sizeof(Header) + V * sizeof(double) + (header.upCount + header.downCount) * sizeof(Arc)
+                        + V * sizeof(uint32_t) + 2 * (V + 1) * sizeof(uint32_t);
+    if (file.size() != expected)
+        return false;
+
+    ContractionHierarchy loaded;
+    const char* cursor = file.data() + sizeof(Header);
+    readAll(cursor, V, loaded.potential);
+    readAll(cursor, header.upCount, loaded.up);
+    readAll(cursor, header.downCount, loaded.down);
+    readAll(cursor, V, loaded.rank);
+    readAll(cursor, V + 1, loaded.upOffsets);
+    readAll(cursor, V + 1, loaded.downOffsets);
+
+    // check every index before trusting any of them
+    if (loaded.upOffsets[0] != 0 || loaded.upOffsets[V] != header.upCount || loaded.downOffsets[0] != 0
+        || loaded.downOffsets[V] != header.downCount)
+        return false;
+    for (uint64_t v = 0; v < V; v++)
+    {
+        if (loaded.upOffsets[v] > loaded.upOffsets[v + 1] || loaded.downOffsets[v] > loaded.downOffsets[v + 1]
+            || loaded.rank[v] >= V)
+            return false;
+    }
+    // every arc must lead to a higher rank and every shortcut bypass a lower
+    // one, or unpacking a damaged file could recurse forever
+    for (uint64_t v = 0; v < V; v++)
+    {
+        for (int side = 0; side < 2; side++)
+        {
+            const std::vector<uint32_t>& offsets = side == 0 ? loaded.upOffsets : loaded.downOffsets;
+            const std::vector<Arc>& arcs = side == 0 ? loaded.up : loaded.down;
+            for (uint32_t a = offsets[v]; a < offsets[v + 1]; a++)
+            {
+                const Arc& arc = arcs[a];
+                if (arc.other >= V || loaded.rank[arc.other] <= loaded.rank[v])
+                    return false;
+                if (arc.middle != Graph::InvalidVertexId
+                    && (arc.middle >= V || loaded.rank[arc.middle] >= loaded.rank[v]))
+                    return false;
+            }
+        }
+    }
+
+    loaded.fingerprint = header.fingerprint;
+    loaded.shortcuts = header.shortcuts;
+    loaded.cycleFree = true;
+    loaded.prepareQueries();
+    *this = loaded;
+    return true;
+}
+
+/**
+ * Sizes the query state for the current vertex count.
+ */
+void ContractionHierarchy::prepareQueries()
+{
+    size_t count = rank.size();
+    for (Side* side : {&fromSource, &fromDestination})
+    {
+        side->label.assign(count, std::make_pair(Infinity, 0u));
+        side->pred.assign(count, Graph::InvalidVertexId);
+        side->reached.clear();
+        side->queue.reset(count);
+    }
+}
+
+/**
+ * Empties one side of the query, resetting only what it reached.
+ */
+void ContractionHierarchy::resetSide(Side& side)
+{
+    for (VertexId v : side.reached)
+    {
+        side.label[v] = std::make_pair(Infinity, 0u);
+        side.pred[v] = Graph::InvalidVertexId;
+    }
+    side.reached.clear();
+    side.queue.clear();
+}
+
+/**
+ * Settles the top of one side's queue and relaxes its upward arcs.
+ * @param side - the side to advance
+ * @param offsets - upOffsets for the source side, downOffsets for the other
+ * @param arcs - up for the source side, down for the other
+ * @param other - the opposite side, checked for a meeting
+ * @param best - the best meeting found so far, updated in place
+ * @param meet - the vertex where the best meeting joins the two sides
+ */
+void ContractionHierarchy::advance(Side& side, const std::vector<uint32_t>& offsets, const std::vector<Arc>& arcs,
+                                   const Side& other, Label& best, VertexId& meet)
+{
+    VertexId u = side.queue.pop();
+    settledCount++;
+    for (uint32_t a = offsets[u]; a < offsets[u + 1]; a++)
+    {
+        const Arc& arc = arcs[a];
+        VertexId v = arc.other;
+        Label candidate = side.label[u] + std::make_pair(arc.weight, arc.hops);
+        if (candidate < side.label[v])
+        {
+            if (side.label[v].first == Infinity)
+                side.reached.push_back(v);
+            side.label[v] = candidate;
+            side.pred[v] = u;
+            side.queue.decreaseKey(v, candidate);
+        }
+        if (other.label[v].first != Infinity && side.label[v] + other.label[v] < best)
+        {
+            best = side.label[v] + other.label[v];
+            meet = v;
+        }
+    }
+}
+
+/**
+ * Appends the original edges a hierarchy arc stands for, without its
+ * first vertex.
+ * @param from - where the arc starts
+ * @param to - where the arc ends
+ * @param path - the path to extend
+ */
+void ContractionHierarchy::unpack(VertexId from, VertexId to, std::vector<VertexId>& path) const
+{
+    // an arc is stored at its lower-ranked end
+    bool goingUp = rank[from] < rank[to];
+    VertexId low = goingUp ? from : to;
+    VertexId high = goingUp ? to : from;
+    const std::vector<uint32_t>& offsets = goingUp ? upOffsets : downOffsets;
+    const std::vector<Arc>& arcs = goingUp ? up : down;
+    for (uint32_t a = offsets[low]; a < offsets[low + 1]; a++)
+    {
+        if (arcs[a].other != high)
+            continue;
+        if (arcs[a].middle == Graph::InvalidVertexId)
+        {
+            path.push_back(to);
+        }
+        else
+        {
+            unpack(from, arcs[a].middle, path);
+            unpack(arcs[a].middle, to, path);
+        }
+        return;
+    }
+}
@@ -0,0 +1,195 @@
+/**
+ * @file contractionHierarchy.h
+ * Contraction hierarchy over the airport graph for fast safest-path queries.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "csrGraph.h"
+#include "indexedHeap.h"
+
+/**
+ * Answers safest-path queries on a contraction hierarchy.
+ *
+ * Preprocessing contracts the vertices one at a time, least important
+ * first. Contracting v removes it from the remaining graph and, for every
+ * pair of remaining neighbors u -> v -> x whose best route runs through v,
+ * adds a shortcut u -> x remembering v as its middle vertex. Importance is
+ * the usual lazily updated edge difference (shortcuts added minus edges
+ * removed) plus the number of neighbors already contracted. A shortcut is
+ * skipped when a bounded local search (the witness search) finds a route
+ * from u to x that is at least as good without v.
+ *
+ * Every original edge and shortcut then leads either up (to a vertex
+ * contracted later) or down. A query runs Dijkstra upward from the origin
+ * and, over reversed down edges, upward from the destination; the best
+ * vertex where the two searches meet lies on a best path, and shortcuts
+ * are unpacked recursively into original edges.
+ *
+ * Paths are ranked like safeCovid's Dijkstra, by total weight and then by
+ * number of flights, and the search runs on Johnson-reduced weights (see
+ * CSRGraph::feasiblePotential). A graph with a negative cycle is reported
+ * as unusable.
+ *
+ * The hierarchy can be saved to a binary file and loaded back for a graph
+ * with the same fingerprint (see CSRGraph::fingerprint), so it only has to
+ * be built once per dataset and set of weights.
+ */
+class ContractionHierarchy
+{
+  public:
+    /**
+     * Constructs an empty hierarchy.
+     */
+    ContractionHierarchy();
+
+    /**
+     * Contracts every vertex of a graph.
+     * @param g - the graph to preprocess
+     */
+    ContractionHierarchy(const CSRGraph& g);
+
+    /**
+     * Whether queries can be answered, which is false if the graph has a
+     * negative cycle or nothing was built or loaded.
+     */
+    bool usable() const;
+
+    /**
+     * Finds the safest path between two vertices.
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @param path - filled with the IDs along the path, source first;
+     *               left empty if there is no path
+     * @return - whether a path was found
+     */
+    bool findPath(VertexId source, VertexId destination, std::vector<VertexId>& path);
+
+    /**
+     * Returns the total weight of the path found by the last query.
+     */
+    double getCost() const;
+
+    /**
+     * Returns how many vertices the last query settled, both sides together.
+     */
+    size_t getSettledCount() const;
+
+    /**
+     * Returns the number of shortcuts the hierarchy added.
+     */
+    size_t shortcutCount() const;
+
+    /**
+     * Returns the position of a vertex in the contraction order, 0 for the
+     * first vertex contracted.
+     * @param v - the vertex ID
+     */
+    uint32_t getRank(VertexId v) const;
+
+    /**
+     * Writes the hierarchy to a file. The file is written next to path and
+     * renamed into place, so readers never see a partial file.
+     * @param path - where to write the hierarchy
+     * @return - whether the file was written
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * Replaces this hierarchy with one read from a file.
+     * @param path - the file to read
+     * @param g - the graph the hierarchy is for; its fingerprint must match
+     *            the one the file was built from
+     * @return - false, leaving the hierarchy unchanged, if the file is
+     *           missing, damaged, of another format version or built for
+     *           another graph
+     */
+    bool load(const std::string& path, const CSRGraph& g);
+
+    /** Current file format version; bump it whenever the layout changes. */
+    const static uint32_t Version;
+
+  private:
+    /** Fills the tables directly after applying new weights. */
+    friend class CustomizableHierarchy;
+
+    /** Reads the arcs to fill many-to-many tables. */
+    friend class DistanceTable;
+
+    /** A path's total reduced weight and its number of edges. */
+    typedef std::pair<double, unsigned> Label;
+
+    /**
+     * One edge or shortcut of the hierarchy, stored at its lower-ranked end.
+     */
+    struct Arc
+    {
+        double weight; /**< Reduced weight **/
+        uint32_t hops; /**< Number of original edges it stands for **/
+        VertexId other; /**< The higher-ranked end **/
+        VertexId middle; /**< Vertex a shortcut bypasses, InvalidVertexId for an edge **/
+        uint32_t padding;
+    };
+
+    /**
+     * Search state for one direction of a query, indexed by vertex ID.
+     */
+    struct Side
+    {
+        std::vector<Label> label;
+        std::vector<VertexId> pred;
+        std::vector<VertexId> reached; /**< Every labeled vertex, for resetting **/
+        IndexedHeap<Label> queue;
+    };
+
+    uint64_t fingerprint;
+    bool cycleFree;
+    std::vector<double> potential;
+    std::vector<uint32_t> rank;
+    std::vector<uint32_t> upOffsets; /**< Up arcs of v are [upOffsets[v], upOffsets[v + 1]) **/
+    std::vector<Arc> up; /**< Arcs v -> other, where other was contracted after v **/
+    std::vector<uint32_t> downOffsets; /**< Down arcs of v are [downOffsets[v], downOffsets[v + 1]) **/
+    std::vector<Arc> down; /**< Arcs other -> v, where other was contracted after v **/
+    size_t shortcuts;
+
+    Side fromSource;
+    Side fromDestination;
+    double cost;
+    size_t settledCount;
+
+    /**
+     * Sizes the query state for the current vertex count.
+     */
+    void prepareQueries();
+
+    /**
+     * Empties one side of the query, resetting only what it reached.
+     */
+    void resetSide(Side& side);
+
+    /**
+     * Settles the top of one side's queue and relaxes its upward arcs.
+     * @param side - the side to advance
+     * @param offsets - upOffsets for the source side, downOffsets for the other
+     * @param arcs - up for the source side, down for the other
+     * @param other - the opposite side, checked for a meeting
+     * @param best - the best meeting found so far, updated in place
+     * @param meet - the vertex where the best meeting joins the two sides
+     */
+    void advance(Side& side, const std::vector<uint32_t>& offsets, const std::vector<Arc>& arcs, const Side& other,
+                 Label& best, VertexId& meet);
+
+    /**
+     * Appends the original edges a hierarchy arc stands for, without its
+     * first vertex.
+     * @param from - where the arc starts
+     * @param to - where the arc ends
+     * @param path - the path to extend
+     */
+    void unpack(VertexId from, VertexId to, std::vector<VertexId>& path) const;
+};
@@ -0,0 +1,174 @@
+#include "csrGraph.h"
+
+#include <algorithm>
+
+const uint32_t CSRGraph::InvalidEdgeIndex = UINT32_MAX;
+
+/**
+ * Constructs an empty view.
+ */
+CSRGraph::CSRGraph() : offsets(1, 0)
+{
+}
+
+/**
+ * Freezes a graph into CSR form.
+ * @param g - the graph to copy
+ */
+CSRGraph::CSRGraph(const Graph& g) : names(g.vertex_names)
+{
+    offsets.reserve(names.size() + 1);
+    offsets.push_back(0);
+
+    vector<pair<VertexId, double>> row;
+    for (const Vertex& name : names)
+    {
+        auto lookup = g.adjacency_list.find(name);
+        if (lookup != g.adjacency_list.end())
+        {
+            row.clear();
+            for (const auto& out : lookup->second)
+                row.push_back(make_pair(g.vertex_ids.find(out.first)->second, out.second.getWeight()));
+            sort(row.begin(), row.end());
+            for (const auto& edge : row)
+            {
+                targets.push_back(edge.first);
+                weights.push_back(edge.second);
+            }
+        }
+        offsets.push_back(static_cast<uint32_t>(targets.size()));
+    }
+}
+
+/**
+ * Finds the edge between two vertices.
+ * @param source - ID of the vertex the edge leaves
+ * @param destination - ID of the vertex the edge enters
+ * @return - if the edge exists, its index
+ *         - if not, InvalidEdgeIndex
+ */
+uint32_t CSRGraph::findEdge(VertexId source, VertexId destination) const
+{
+    if (source >= vertexCount())
+        return InvalidEdgeIndex;
+    auto begin = targets.begin() + offsets[source];
+    auto end = targets.begin() + offsets[source + 1];
+    auto found = std::lower_bound(begin, end, destination);
+    if (found == end || *found != destination)
+        return InvalidEdgeIndex;
+    return static_cast<uint32_t>(found - targets.begin());
+}
+
+/**
+ * Builds the transpose of this graph: every edge u -> v becomes
+ * v -> u with the same weight. Rows stay sorted by target ID.
+ */
+CSRGraph CSRGraph::reversed() const
+{
+    CSRGraph r;
+    r.names = names;
+    r.offsets.assign(vertexCount() + 1, 0);
+    r.targets.resize(edgeCount());
+    r.weights.resize(edgeCount());
+
+    for (VertexId target : targets)
+        r.offsets[target + 1]++;
+    for (size_t v = 0; v < vertexCount(); v++)
+        r.offsets[v + 1] += r.offsets[v];
+
+    // sources are visited in ID order, so every reversed row comes out sorted
+    std::vector<uint32_t> next(r.offsets.begin(), r.offsets.end() - 1);
+    for (VertexId v = 0; v < vertexCount(); v++)
+    {
+        for (uint32_t e = offsets[v]; e < offsets[v + 1]; e++)
+        {
+            uint32_t slot = next[targets[e]]++;
+            r.targets[slot] = v;
+            r.weights[slot] = weights[e];
+        }
+    }
+    return r;
+}
+
+/**
+ * Computes a vertex potential p for Johnson's reweighting, so that
+ * w(u, v) + p[u] - p[v] >= 0 for every edge. Searches that need
+ * non-negative weights can run on these reduced weights; a path's
+ * reduced cost is its real cost plus p[source] - p[destination].
+ * @param potential - filled with one value per vertex
+ * @return - false if the graph has a negative cycle, in which case
+ *           no such potential exists
+ */
+bool CSRGraph::feasiblePotential(std::vector<double>& potential) const
+{
+    // Bellman-Ford from a virtual source joined to every vertex by a
+    // zero-weight edge. Without negative cycles it settles within V rounds.
+    potential.assign(vertexCount(), 0.0);
+    for (size_t round = 0; round <= vertexCount(); round++)
+    {
+        bool changed = false;
+        for (VertexId v = 0; v < vertexCount(); v++)
+        {
+            for (uint32_t e = offsets[v]; e < offsets[v + 1]; e++)
+            {
+                double candidate = potential[v] + weights[e];
+                if (candidate < potential[targets[e]])
+                {
+                    potential[targets[e]] = candidate;
+                    changed = true;
+                }
+            }
+        }
+        if (!changed)
+            return true;
+    }
+    return false;
+}
+
+namespace
+{
+
+/**
+ * Folds a run of bytes into an FNV-1a hash.
+ */
+void hashBytes(uint64_t& hash, const void* data, size_t length)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+} // namespace
+
+/**
+ * Computes a 64-bit FNV-1a hash of the vertex names and edges, ignoring
+ * weights, used to tell whether something that only depends on the
+ * shape of the graph, such as a CustomizableHierarchy's order, still fits.
+ */
+uint64_t CSRGraph::topologyFingerprint() const
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (const Vertex& name : names)
+    {
+        // the terminating zero keeps "AB","C" apart from "A","BC"
+        hashBytes(hash, name.c_str(), name.size() + 1);
+    }
+    hashBytes(hash, offsets.data(), offsets.size() * sizeof(uint32_t));
+    hashBytes(hash, targets.data(), targets.size() * sizeof(VertexId));
+    return hash;
+}
+
+/**
+ * Computes a 64-bit FNV-1a hash of the vertex names, edges and
+ * weights, used to tell whether something derived from the graph,
+ * such as a saved ContractionHierarchy, still belongs to it.
+ */
+uint64_t CSRGraph::fingerprint() const
+{
+    uint64_t hash = topologyFingerprint();
+    hashBytes(hash, weights.data(), weights.size() * sizeof(double));
+    return hash;
+}
@@ -0,0 +1,259 @@
+/**
+ * @file csrGraph.h
+ * Read-only compressed sparse row (CSR) view of a Graph.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "airportGraph.h"
+
+/**
+ * One outgoing edge as seen from its source: the vertex it leads to and
+ * its weight.
+ */
+struct Neighbor
+{
+    VertexId id; /**< ID of the neighboring vertex **/
+    double weight; /**< Weight of the edge to it **/
+};
+
+/**
+ * Iterates over the parallel target/weight arrays of a CSRGraph.
+ */
+class NeighborIterator
+{
+  public:
+    NeighborIterator(const VertexId* target, const double* weight) : target(target), weight(weight)
+    {
+    }
+
+    Neighbor operator*() const
+    {
+        Neighbor n = {*target, *weight};
+        return n;
+    }
+
+    NeighborIterator& operator++()
+    {
+        ++target;
+        ++weight;
+        return *this;
+    }
+
+    bool operator!=(const NeighborIterator& other) const
+    {
+        return target != other.target;
+    }
+
+  private:
+    const VertexId* target;
+    const double* weight;
+};
+
+/**
+ * Non-owning range over the outgoing edges of one vertex, usable in a
+ * range-based for loop. Only valid while the CSRGraph it came from lives.
+ */
+class NeighborRange
+{
+  public:
+    NeighborRange(NeighborIterator first, NeighborIterator last, uint32_t count)
+        : first(first), last(last), count(count)
+    {
+    }
+
+    NeighborIterator begin() const
+    {
+        return first;
+    }
+
+    NeighborIterator end() const
+    {
+        return last;
+    }
+
+    uint32_t size() const
+    {
+        return count;
+    }
+
+  private:
+    NeighborIterator first;
+    NeighborIterator last;
+    uint32_t count;
+};
+
+/**
+ * An immutable copy of a Graph's adjacency in compressed sparse row form,
+ * for read-only query workloads.
+ *
+ * Vertices are indexed by their Graph IDs. The outgoing edges of vertex v
+ * are the slots [edgeBegin(v), edgeEnd(v)) of two parallel arrays holding
+ * the target ID and the weight of each edge, so walking a vertex's
+ * neighbors reads contiguous memory instead of chasing hash map nodes.
+ * Each vertex's edges are sorted by target ID, which makes traversals
+ * independent of hash map iteration order.
+ *
+ * The view does not follow later changes to the Graph; build a new one
+ * after inserting, removing or reweighting edges.
+ */
+class CSRGraph
+{
+  public:
+    /**
+     * Constructs an empty view.
+     */
+    CSRGraph();
+
+    /**
+     * Freezes a graph into CSR form.
+     * @param g - the graph to copy
+     */
+    CSRGraph(const Graph& g);
+
+    /**
+     * Returns the number of vertex slots, which is the Graph's ID count.
+     * IDs of removed vertices have a slot with no edges.
+     */
+    size_t vertexCount() const
+    {
+        return names.size();
+    }
+
+    /**
+     * Returns the number of edges.
+     */
+    size_t edgeCount() const
+    {
+        return targets.size();
+    }
+
+    /**
+     * Returns the index of the first outgoing edge of a vertex.
+     * @param v - the vertex ID
+     */
+    uint32_t edgeBegin(VertexId v) const
+    {
+        return offsets[v];
+    }
+
+    /**
+     * Returns one past the index of the last outgoing edge of a vertex.
+     * @param v - the vertex ID
+     */
+    uint32_t edgeEnd(VertexId v) const
+    {
+        return offsets[v + 1];
+    }
+
+    /**
+     * Returns the number of outgoing edges of a vertex.
+     * @param v - the vertex ID
+     */
+    uint32_t degree(VertexId v) const
+    {
+        return offsets[v + 1] - offsets[v];
+    }
+
+    /**
+     * Returns the outgoing edges of a vertex without copying them.
+     * @param v - the vertex ID
+     * @return a range of Neighbor values
+     */
+    NeighborRange neighbors(VertexId v) const
+    {
+        return NeighborRange(NeighborIterator(targets.data() + offsets[v], weights.data() + offsets[v]),
+                             NeighborIterator(targets.data() + offsets[v + 1], weights.data() + offsets[v + 1]),
+                             degree(v));
+    }
+
+    /**
+     * Calls visit(neighbor, weight) for every outgoing edge of a vertex.
+     * @param v - the vertex ID
+     * @param visit - callable taking a VertexId and a double
+     */
+    template <class Callback>
+    void forEachNeighbor(VertexId v, Callback visit) const
+    {
+        for (uint32_t e = offsets[v]; e < offsets[v + 1]; e++)
+            visit(targets[e], weights[e]);
+    }
+
+    /**
+     * Returns the vertex an edge points to.
+     * @param e - the edge index
+     */
+    VertexId target(uint32_t e) const
+    {
+        return targets[e];
+    }
+
+    /**
+     * Returns the weight of an edge.
+     * @param e - the edge index
+     */
+    double weight(uint32_t e) const
+    {
+        return weights[e];
+    }
+
+    /**
+     * Returns the name of a vertex.
+     * @param v - the vertex ID
+     */
+    const Vertex& getVertexName(VertexId v) const
+    {
+        return names[v];
+    }
+
+    /**
+     * Finds the edge between two vertices.
+     * @param source - ID of the vertex the edge leaves
+     * @param destination - ID of the vertex the edge enters
+     * @return - if the edge exists, its index
+     *         - if not, InvalidEdgeIndex
+     */
+    uint32_t findEdge(VertexId source, VertexId destination) const;
+
+    /**
+     * Builds the transpose of this graph: every edge u -> v becomes
+     * v -> u with the same weight. Rows stay sorted by target ID.
+     */
+    CSRGraph reversed() const;
+
+    /**
+     * Computes a vertex potential p for Johnson's reweighting, so that
+     * w(u, v) + p[u] - p[v] >= 0 for every edge. Searches that need
+     * non-negative weights can run on these reduced weights; a path's
+     * reduced cost is its real cost plus p[source] - p[destination].
+     * @param potential - filled with one value per vertex
+     * @return - false if the graph has a negative cycle, in which case
+     *           no such potential exists
+     */
+    bool feasiblePotential(std::vector<double>& potential) const;
+
+    /**
+     * Computes a 64-bit FNV-1a hash of the vertex names and edges, ignoring
+     * weights, used to tell whether something that only depends on the
+     * shape of the graph, such as a CustomizableHierarchy's order, still fits.
+     */
+    uint64_t topologyFingerprint() const;
+
+    /**
+     * Computes a 64-bit FNV-1a hash of the vertex names, edges and
+     * weights, used to tell whether something derived from the graph,
+     * such as a saved ContractionHierarchy, still belongs to it.
+     */
+    uint64_t fingerprint() const;
+
+    /** Returned by findEdge when there is no such edge. */
+    const static uint32_t InvalidEdgeIndex;
+
+  private:
+    std::vector<uint32_t> offsets; /**< Vertex v's edges are [offsets[v], offsets[v + 1]) **/
+    std::vector<VertexId> targets; /**< Target of each edge **/
+    std::vector<double> weights; /**< Weight of each edge **/
+    std::vector<Vertex> names; /**< Name of each vertex ID **/
+};
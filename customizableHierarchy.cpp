@@ -0,0 +1,348 @@
+#include "customizableHierarchy.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+#include "indexedHeap.h"
+
+const uint32_t CustomizableHierarchy::InvalidArc = UINT32_MAX;
+
+namespace
+{
+
+const double Infinity = std::numeric_limits<double>::infinity();
+
+typedef std::pair<double, unsigned> Label;
+
+Label operator+(const Label& a, const Label& b)
+{
+    return std::make_pair(a.first + b.first, a.second + b.second);
+}
+
+} // namespace
+
+/**
+ * Constructs an empty hierarchy.
+ */
+CustomizableHierarchy::CustomizableHierarchy() : topology(0), arcOffsets(1, 0)
+{
+}
+
+/**
+ * Computes the order and arcs for a graph's topology; its weights are
+ * not used until customize is called.
+ * @param topology - the graph to preprocess
+ */
+CustomizableHierarchy::CustomizableHierarchy(const CSRGraph& topology)
+    : topology(topology.topologyFingerprint()), arcOffsets(1, 0)
+{
+    eliminate(topology);
+
+    // find the arc under every edge; a vertex's arcs are sorted by rank
+    edgeArc.assign(topology.edgeCount(), InvalidArc);
+    for (VertexId u = 0; u < topology.vertexCount(); u++)
+    {
+        for (uint32_t e = topology.edgeBegin(u); e < topology.edgeEnd(u); e++)
+        {
+            VertexId v = topology.target(e);
+            if (u == v)
+                continue;
+            VertexId low = rank[u] < rank[v] ? u : v;
+            VertexId high = rank[u] < rank[v] ? v : u;
+            const VertexId* first = head.data() + arcOffsets[low];
+            const VertexId* last = head.data() + arcOffsets[low + 1];
+            const VertexId* found = std::lower_bound(first, last, high, [this](VertexId a, VertexId b) {
+                return rank[a] < rank[b];
+            });
+            edgeArc[e] = static_cast<uint32_t>(found - head.data());
+        }
+    }
+
+    slot.assign(rank.size(), InvalidArc);
+    upward.resize(head.size());
+    downward.resize(head.size());
+    upMiddle.resize(head.size());
+    downMiddle.resize(head.size());
+}
+
+/**
+ * Whether a graph has the topology the hierarchy was built for, so
+ * customize can apply its weights.
+ * @param g - the graph to check
+ */
+bool CustomizableHierarchy::fits(const CSRGraph& g) const
+{
+    return g.vertexCount() == rank.size() && g.topologyFingerprint() == topology;
+}
+
+/**
+ * Applies a graph's weights to the arcs.
+ * @param g - a graph with the same vertices and edges as the one the
+ *            hierarchy was built for, in the same order
+ * @return - false, leaving the hierarchy unusable, if the graph has
+ *           another topology or a negative cycle
+ */
+bool CustomizableHierarchy::customize(const CSRGraph& g)
+{
+    hierarchy.cycleFree = false;
+    if (!fits(g))
+        return false;
+    std::vector<double> potential;
+    if (!g.feasiblePotential(potential))
+        return false;
+
+    Label unreachable = std::make_pair(Infinity, 0u);
+    std::fill(upward.begin(), upward.end(), unreachable);
+    std::fill(downward.begin(), downward.end(), unreachable);
+    std::fill(upMiddle.begin(), upMiddle.end(), Graph::InvalidVertexId);
+    std::fill(downMiddle.begin(), downMiddle.end(), Graph::InvalidVertexId);
+    for (VertexId u = 0; u < g.vertexCount(); u++)
+    {
+        for (uint32_t e = g.edgeBegin(u); e < g.edgeEnd(u); e++)
+        {
+            if (edgeArc[e] == InvalidArc)
+                continue;
+            VertexId v = g.target(e);
+            Label weight = std::make_pair(std::max(0.0, g.weight(e) + potential[u] - potential[v]), 1u);
+            Label& arc = rank[u] < rank[v] ? upward[edgeArc[e]] : downward[edgeArc[e]];
+            arc = std::min(arc, weight);
+        }
+    }
+
+    // lower triangles: when v is swept, the arcs to its higher neighbors
+    // are final, and x -> v -> y may improve the arc between x and y
+    for (VertexId v : order)
+    {
+        for (uint32_t i = arcOffsets[v]; i < arcOffsets[v + 1]; i++)
+        {
+            VertexId x = head[i];
+            for (uint32_t a = arcOffsets[x]; a < arcOffsets[x + 1]; a++)
+                slot[head[a]] = a;
+            for (uint32_t j = i + 1; j < arcOffsets[v + 1]; j++)
+            {
+                // elimination joined every pair of v's higher neighbors
+                uint32_t between = slot[head[j]];
+                Label through = downward[i] + upward[j];
+                if (through < upward[between])
+                {
+                    upward[between] = through;
+                    upMiddle[between] = v;
+                }
+                through = downward[j] + upward[i];
+                if (through < downward[between])
+                {
+                    downward[between] = through;
+                    downMiddle[between] = v;
+                }
+            }
+            for (uint32_t a = arcOffsets[x]; a < arcOffsets[x + 1]; a++)
+                slot[head[a]] = InvalidArc;
+        }
+    }
+
+    // upper and intermediate triangles, going down the order: once the
+    // arcs between v's higher neighbors are exact, so are v's own arcs
+    exactUp = upward;
+    exactDown = downward;
+    for (size_t r = order.size(); r-- > 0;)
+    {
+        VertexId v = order[r];
+        for (uint32_t i = arcOffsets[v]; i < arcOffsets[v + 1]; i++)
+        {
+            VertexId x = head[i];
+            for (uint32_t a = arcOffsets[x]; a < arcOffsets[x + 1]; a++)
+                slot[head[a]] = a;
+            for (uint32_t j = i + 1; j < arcOffsets[v + 1]; j++)
+            {
+                uint32_t between = slot[head[j]];
+                exactUp[j] = std::min(exactUp[j], exactUp[i] + exactUp[between]);
+                exactDown[j] = std::min(exactDown[j], exactDown[between] + exactDown[i]);
+                exactUp[i] = std::min(exactUp[i], exactUp[j] + exactDown[between]);
+                exactDown[i] = std::min(exactDown[i], exactUp[between] + exactDown[j]);
+            }
+            for (uint32_t a = arcOffsets[x]; a < arcOffsets[x + 1]; a++)
+                slot[head[a]] = InvalidArc;
+        }
+    }
+
+    publish(g, potential);
+    return true;
+}
+
+/**
+ * Whether queries can be answered, which is false until a customize
+ * call succeeds.
+ */
+bool CustomizableHierarchy::usable() const
+{
+    return hierarchy.usable();
+}
+
+/**
+ * Finds the safest path between two vertices.
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @param path - filled with the IDs along the path, source first;
+ *               left empty if there is no path
+ * @return - whether a path was found
+ */
+bool CustomizableHierarchy::findPath(VertexId source, VertexId destination, std::vector<VertexId>& path)
+{
+    return hierarchy.findPath(source, destination, path);
+}
+
+/**
+ * Returns the total weight of the path found by the last query.
+ */
+double CustomizableHierarchy::getCost() const
+{
+    return hierarchy.getCost();
+}
+
+/**
+ * Returns how many vertices the last query settled, both sides together.
+ */
+size_t CustomizableHierarchy::getSettledCount() const
+{
+    return hierarchy.getSettledCount();
+}
+
+/**
+ * Returns the number of arcs between pairs of vertices, which depends
+ * only on the topology; each can be used in both directions.
+ */
+size_t CustomizableHierarchy::arcCount() const
+{
+    return head.size();
+}
+
+/**
+ * Returns the position of a vertex in the elimination order, 0 for the
+ * first vertex eliminated.
+ * @param v - the vertex ID
+ */
+uint32_t CustomizableHierarchy::getRank(VertexId v) const
+{
+    return rank[v];
+}
+
+/**
+ * Returns the hierarchy the last customize call produced, for example
+ * to save it.
+ */
+const ContractionHierarchy& CustomizableHierarchy::getHierarchy() const
+{
+    return hierarchy;
+}
+
+/**
+ * Eliminates the vertices by fewest remaining neighbors first.
+ * @param topology - the graph being preprocessed
+ */
+void CustomizableHierarchy::eliminate(const CSRGraph& topology)
+{
+    size_t count = topology.vertexCount();
+    std::vector<std::vector<VertexId>> neighbors(count);
+    for (VertexId u = 0; u < count; u++)
+    {
+        for (uint32_t e = topology.edgeBegin(u); e < topology.edgeEnd(u); e++)
+        {
+            VertexId v = topology.target(e);
+            if (u == v)
+                continue;
+            neighbors[u].push_back(v);
+            neighbors[v].push_back(u);
+        }
+    }
+
+    IndexedHeap<size_t> remaining;
+    remaining.reset(count);
+    for (VertexId v = 0; v < count; v++)
+    {
+        std::sort(neighbors[v].begin(), neighbors[v].end());
+        neighbors[v].erase(std::unique(neighbors[v].begin(), neighbors[v].end()), neighbors[v].end());
+        remaining.push(v, neighbors[v].size());
+    }
+
+    rank.assign(count, 0);
+    order.clear();
+    std::vector<std::vector<VertexId>> arcs(count);
+    std::vector<VertexId> merged;
+    while (!remaining.empty())
+    {
+        VertexId v = remaining.pop();
+        rank[v] = static_cast<uint32_t>(order.size());
+        order.push_back(v);
+
+        // the remaining neighbors become a clique, and v keeps an arc to each
+        const std::vector<VertexId>& clique = neighbors[v];
+        for (VertexId u : clique)
+        {
+            merged.clear();
+            std::set_union(neighbors[u].begin(), neighbors[u].end(), clique.begin(), clique.end(),
+                           std::back_inserter(merged));
+            merged.erase(std::remove_if(merged.begin(), merged.end(), [u, v](VertexId w) {
+                return w == u || w == v;
+            }), merged.end());
+            neighbors[u].swap(merged);
+            remaining.push(u, neighbors[u].size());
+        }
+        arcs[v].swap(neighbors[v]);
+    }
+
+    arcOffsets.assign(count + 1, 0);
+    head.clear();
+    for (VertexId v = 0; v < count; v++)
+    {
+        std::sort(arcs[v].begin(), arcs[v].end(), [this](VertexId a, VertexId b) {
+            return rank[a] < rank[b];
+        });
+        head.insert(head.end(), arcs[v].begin(), arcs[v].end());
+        arcOffsets[v + 1] = static_cast<uint32_t>(head.size());
+    }
+}
+
+/**
+ * Copies the arcs a best path can use into the hierarchy's query tables.
+ * @param g - the graph that was customized
+ * @param potential - its Johnson potential
+ */
+void CustomizableHierarchy::publish(const CSRGraph& g, std::vector<double>& potential)
+{
+    ContractionHierarchy& h = hierarchy;
+    size_t count = rank.size();
+    bool resized = h.rank.size() != count;
+    h.fingerprint = g.fingerprint();
+    h.potential.swap(potential);
+    h.rank = rank;
+    h.upOffsets.assign(count + 1, 0);
+    h.downOffsets.assign(count + 1, 0);
+    h.up.clear();
+    h.down.clear();
+    h.shortcuts = 0;
+    for (VertexId v = 0; v < count; v++)
+    {
+        for (uint32_t a = arcOffsets[v]; a < arcOffsets[v + 1]; a++)
+        {
+            // an arc beaten by a route over higher vertices is never on a best path
+            if (upward[a].first != Infinity && !(exactUp[a] < upward[a]))
+            {
+                ContractionHierarchy::Arc arc = {upward[a].first, upward[a].second, head[a], upMiddle[a], 0};
+                h.up.push_back(arc);
+                h.shortcuts += upMiddle[a] != Graph::InvalidVertexId;
+            }
+            if (downward[a].first != Infinity && !(exactDown[a] < downward[a]))
+            {
+                ContractionHierarchy::Arc arc = {downward[a].first, downward[a].second, head[a], downMiddle[a], 0};
+                h.down.push_back(arc);
+                h.shortcuts += downMiddle[a] != Graph::InvalidVertexId;
+            }
+        }
+        h.upOffsets[v + 1] = static_cast<uint32_t>(h.up.size());
+        h.downOffsets[v + 1] = static_cast<uint32_t>(h.down.size());
+    }
+    h.cycleFree = true;
+    if (resized)
+        h.prepareQueries();
+}
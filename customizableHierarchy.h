@@ -0,0 +1,148 @@
+/**
+ * @file customizableHierarchy.h
+ * Contraction hierarchy whose order ignores the weights, so new weights
+ * can be applied without contracting again.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "contractionHierarchy.h"
+#include "csrGraph.h"
+
+/**
+ * Answers safest-path queries on a customizable contraction hierarchy.
+ *
+ * Building one only looks at which airports are connected. It eliminates
+ * the vertices least connected first, ignoring edge direction, and joins
+ * the remaining neighbors of every eliminated vertex to each other. The
+ * arcs this leaves are exactly the ones any later weights can need, since
+ * for each pair of neighbors u, x of an eliminated vertex v the arc u - x
+ * is there to stand for u -> v -> x.
+ *
+ * customize then applies one set of weights in a single sweep: every arc
+ * starts at the weight of the edge it copies, or unreachable, and going up
+ * the order each vertex v lowers the arcs between its higher neighbors to
+ * the best of the routes through v. A second sweep down the order finds
+ * each arc's true best weight and drops the arcs some route over higher
+ * vertices beats, since no best path uses them. No witness searches are
+ * needed, so this takes milliseconds, where contracting the graph again
+ * would take a good part of a second. The result is handed to a ContractionHierarchy,
+ * which answers the queries, so paths are ranked and reported the same
+ * way, by total weight and then by number of flights.
+ */
+class CustomizableHierarchy
+{
+  public:
+    /**
+     * Constructs an empty hierarchy.
+     */
+    CustomizableHierarchy();
+
+    /**
+     * Computes the order and arcs for a graph's topology; its weights are
+     * not used until customize is called.
+     * @param topology - the graph to preprocess
+     */
+    CustomizableHierarchy(const CSRGraph& topology);
+
+    /**
+     * Whether a graph has the topology the hierarchy was built for, so
+     * customize can apply its weights.
+     * @param g - the graph to check
+     */
+    bool fits(const CSRGraph& g) const;
+
+    /**
+     * Applies a graph's weights to the arcs.
+     * @param g - a graph with the same vertices and edges as the one the
+     *            hierarchy was built for, in the same order
+     * @return - false, leaving the hierarchy unusable, if the graph has
+     *           another topology or a negative cycle
+     */
+    bool customize(const CSRGraph& g);
+
+    /**
+     * Whether queries can be answered, which is false until a customize
+     * call succeeds.
+     */
+    bool usable() const;
+
+    /**
+     * Finds the safest path between two vertices.
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @param path - filled with the IDs along the path, source first;
+     *               left empty if there is no path
+     * @return - whether a path was found
+     */
+    bool findPath(VertexId source, VertexId destination, std::vector<VertexId>& path);
+
+    /**
+     * Returns the total weight of the path found by the last query.
+     */
+    double getCost() const;
+
+    /**
+     * Returns how many vertices the last query settled, both sides together.
+     */
+    size_t getSettledCount() const;
+
+    /**
+     * Returns the number of arcs between pairs of vertices, which depends
+     * only on the topology; each can be used in both directions.
+     */
+    size_t arcCount() const;
+
+    /**
+     * Returns the position of a vertex in the elimination order, 0 for the
+     * first vertex eliminated.
+     * @param v - the vertex ID
+     */
+    uint32_t getRank(VertexId v) const;
+
+    /**
+     * Returns the hierarchy the last customize call produced, for example
+     * to save it.
+     */
+    const ContractionHierarchy& getHierarchy() const;
+
+  private:
+    /** A path's total reduced weight and its number of edges. */
+    typedef std::pair<double, unsigned> Label;
+
+    uint64_t topology;
+    std::vector<uint32_t> rank;
+    std::vector<VertexId> order; /**< Vertices by rank **/
+    std::vector<uint32_t> arcOffsets; /**< Arcs of v are [arcOffsets[v], arcOffsets[v + 1]) **/
+    std::vector<VertexId> head; /**< Higher end of each arc, by increasing rank **/
+    std::vector<uint32_t> edgeArc; /**< Arc each graph edge lies on, InvalidArc for a loop **/
+    std::vector<uint32_t> slot; /**< Scratch: arc from the neighbor being swept to each of its higher neighbors **/
+
+    std::vector<Label> upward; /**< Best weight from the lower end to the higher end **/
+    std::vector<Label> downward; /**< Best weight from the higher end to the lower end **/
+    std::vector<VertexId> upMiddle; /**< Vertex the upward route bypasses, InvalidVertexId for an edge **/
+    std::vector<VertexId> downMiddle;
+    std::vector<Label> exactUp; /**< Best weight from the lower end to the higher end over any vertices **/
+    std::vector<Label> exactDown;
+    ContractionHierarchy hierarchy;
+
+    /** Marks edgeArc entries and slot entries that lead nowhere. */
+    const static uint32_t InvalidArc;
+
+    /**
+     * Eliminates the vertices by fewest remaining neighbors first.
+     * @param topology - the graph being preprocessed
+     */
+    void eliminate(const CSRGraph& topology);
+
+    /**
+     * Copies the arcs a best path can use into the hierarchy's query tables.
+     * @param g - the graph that was customized
+     * @param potential - its Johnson potential
+     */
+    void publish(const CSRGraph& g, std::vector<double>& potential);
+};
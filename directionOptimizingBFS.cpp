@@ -0,0 +1,169 @@
+#include "directionOptimizingBFS.h"
+
+#include <algorithm>
+#include <climits>
+
+const unsigned DirectionOptimizingBFS::Unreached = UINT_MAX;
+const size_t DirectionOptimizingBFS::Alpha = 14;
+const size_t DirectionOptimizingBFS::Beta = 24;
+
+/**
+ * Constructs an engine with no graph.
+ */
+DirectionOptimizingBFS::DirectionOptimizingBFS() : topDownLevels(0), bottomUpLevels(0), edgesExamined(0)
+{
+}
+
+/**
+ * Prepares the forward and reversed graphs.
+ * @param g - the graph to search; it is copied
+ */
+DirectionOptimizingBFS::DirectionOptimizingBFS(const CSRGraph& g)
+    : forward(g), backward(g.reversed()), topDownLevels(0), bottomUpLevels(0), edgesExamined(0)
+{
+    size_t words = (forward.vertexCount() + 63) / 64;
+    visited.assign(words, 0);
+    inFrontier.assign(words, 0);
+}
+
+/**
+ * Finds the fewest edges from one vertex to every vertex.
+ * @param root - ID of the vertex to start from
+ * @param hops - filled with the number of edges to each vertex, indexed
+ *               by vertex ID, Unreached for vertices the root cannot
+ *               reach; all Unreached if root is not a vertex
+ * @param strategy - how to build the levels
+ */
+void DirectionOptimizingBFS::run(VertexId root, std::vector<unsigned>& hops, Strategy strategy)
+{
+    size_t count = forward.vertexCount();
+    hops.assign(count, Unreached);
+    topDownLevels = 0;
+    bottomUpLevels = 0;
+    edgesExamined = 0;
+    if (root >= count)
+        return;
+
+    std::fill(visited.begin(), visited.end(), 0);
+    frontier.clear();
+    next.clear();
+    reach(root, 0, hops);
+    frontier.swap(next);
+
+    // in-edges of the unvisited vertices, which a bottom-up level may scan
+    size_t unvisitedEdges = backward.edgeCount() - backward.degree(root);
+    size_t frontierEdges = forward.degree(root);
+    bool bottomUp = strategy == BottomUpOnly;
+    for (unsigned depth = 1; !frontier.empty(); depth++)
+    {
+        if (strategy == Adaptive)
+        {
+            if (!bottomUp && frontierEdges > unvisitedEdges / Alpha)
+                bottomUp = true;
+            else if (bottomUp && frontier.size() < count / Beta)
+                bottomUp = false;
+        }
+
+        if (bottomUp)
+            stepBottomUp(depth, hops);
+        else
+            stepTopDown(depth, hops);
+
+        frontierEdges = 0;
+        for (VertexId v : next)
+        {
+            frontierEdges += forward.degree(v);
+            unvisitedEdges -= backward.degree(v);
+        }
+        frontier.swap(next);
+        next.clear();
+    }
+}
+
+/**
+ * Returns how many levels the last run built top-down.
+ */
+unsigned DirectionOptimizingBFS::getTopDownLevels() const
+{
+    return topDownLevels;
+}
+
+/**
+ * Returns how many levels the last run built bottom-up.
+ */
+unsigned DirectionOptimizingBFS::getBottomUpLevels() const
+{
+    return bottomUpLevels;
+}
+
+/**
+ * Returns how many edges the last run looked at.
+ */
+size_t DirectionOptimizingBFS::getEdgesExamined() const
+{
+    return edgesExamined;
+}
+
+/**
+ * Marks a vertex reached at the given depth and queues it for the next
+ * level.
+ */
+void DirectionOptimizingBFS::reach(VertexId v, unsigned depth, std::vector<unsigned>& hops)
+{
+    visited[v / 64] |= uint64_t(1) << (v % 64);
+    hops[v] = depth;
+    next.push_back(v);
+}
+
+/**
+ * Builds the next level from the frontier's out-edges.
+ */
+void DirectionOptimizingBFS::stepTopDown(unsigned depth, std::vector<unsigned>& hops)
+{
+    topDownLevels++;
+    for (VertexId u : frontier)
+    {
+        edgesExamined += forward.degree(u);
+        for (uint32_t e = forward.edgeBegin(u); e < forward.edgeEnd(u); e++)
+        {
+            VertexId v = forward.target(e);
+            if (!(visited[v / 64] & (uint64_t(1) << (v % 64))))
+                reach(v, depth, hops);
+        }
+    }
+}
+
+/**
+ * Builds the next level from the unvisited vertices' in-edges.
+ */
+void DirectionOptimizingBFS::stepBottomUp(unsigned depth, std::vector<unsigned>& hops)
+{
+    bottomUpLevels++;
+    std::fill(inFrontier.begin(), inFrontier.end(), 0);
+    for (VertexId u : frontier)
+        inFrontier[u / 64] |= uint64_t(1) << (u % 64);
+
+    size_t count = forward.vertexCount();
+    for (size_t word = 0; word < visited.size(); word++)
+    {
+        uint64_t unvisited = ~visited[word];
+        while (unvisited != 0)
+        {
+            unsigned bit = __builtin_ctzll(unvisited);
+            unvisited &= unvisited - 1;
+            VertexId v = static_cast<VertexId>(word * 64 + bit);
+            if (v >= count)
+                break;
+            for (uint32_t e = backward.edgeBegin(v); e < backward.edgeEnd(v); e++)
+            {
+                edgesExamined++;
+                VertexId u = backward.target(e);
+                if (inFrontier[u / 64] & (uint64_t(1) << (u % 64)))
+                {
+                    reach(v, depth, hops);
+                    break;
+                }
+            }
+        }
+    }
+}
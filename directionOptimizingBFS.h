@@ -0,0 +1,118 @@
+/**
+ * @file directionOptimizingBFS.h
+ * Whole-graph hop distances by breadth-first search that switches between
+ * expanding the frontier and scanning the unvisited vertices.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "csrGraph.h"
+
+/**
+ * Computes the number of flights from one airport to every other one,
+ * level by level.
+ *
+ * A level can be built two ways. Top-down, every frontier vertex checks
+ * its out-edges for unvisited neighbors, which is cheap while the frontier
+ * is small. Bottom-up, every unvisited vertex checks its in-edges for a
+ * frontier vertex and stops at the first one, which is cheap once the
+ * frontier holds a good part of the graph: around a hub such as ATL or FRA
+ * most airports are found within three or four levels, and the levels in
+ * the middle would otherwise look at nearly every edge. The search starts
+ * top-down, turns bottom-up when the frontier's out-edges outnumber the
+ * unvisited vertices' in-edges divided by Alpha, and turns back once the
+ * frontier holds fewer than 1 / Beta of the vertices (the usual
+ * direction-optimizing rule).
+ *
+ * The visited set and, in bottom-up levels, the frontier are bitmaps with
+ * one bit per vertex, so a bottom-up level skips 64 visited vertices at a
+ * time and its frontier checks stay in cache.
+ */
+class DirectionOptimizingBFS
+{
+  public:
+    /**
+     * How run builds each level.
+     */
+    enum Strategy
+    {
+        Adaptive, /**< Switch as described above */
+        TopDownOnly, /**< Always expand the frontier, like a plain queue BFS */
+        BottomUpOnly /**< Always scan the unvisited vertices */
+    };
+
+    /**
+     * Constructs an engine with no graph.
+     */
+    DirectionOptimizingBFS();
+
+    /**
+     * Prepares the forward and reversed graphs.
+     * @param g - the graph to search; it is copied
+     */
+    DirectionOptimizingBFS(const CSRGraph& g);
+
+    /**
+     * Finds the fewest edges from one vertex to every vertex.
+     * @param root - ID of the vertex to start from
+     * @param hops - filled with the number of edges to each vertex, indexed
+     *               by vertex ID, Unreached for vertices the root cannot
+     *               reach; all Unreached if root is not a vertex
+     * @param strategy - how to build the levels
+     */
+    void run(VertexId root, std::vector<unsigned>& hops, Strategy strategy = Adaptive);
+
+    /**
+     * Returns how many levels the last run built top-down.
+     */
+    unsigned getTopDownLevels() const;
+
+    /**
+     * Returns how many levels the last run built bottom-up.
+     */
+    unsigned getBottomUpLevels() const;
+
+    /**
+     * Returns how many edges the last run looked at.
+     */
+    size_t getEdgesExamined() const;
+
+    /** hops entry of a vertex the root cannot reach. */
+    const static unsigned Unreached;
+
+    /** Go bottom-up once frontier out-edges exceed unvisited in-edges / Alpha. */
+    const static size_t Alpha;
+
+    /** Go top-down again once the frontier holds under 1 / Beta of the vertices. */
+    const static size_t Beta;
+
+  private:
+    CSRGraph forward;
+    CSRGraph backward;
+    std::vector<uint64_t> visited; /**< Bit v % 64 of word v / 64 is set once v is reached **/
+    std::vector<uint64_t> inFrontier; /**< Same layout, used by bottom-up levels **/
+    std::vector<VertexId> frontier;
+    std::vector<VertexId> next;
+    unsigned topDownLevels;
+    unsigned bottomUpLevels;
+    size_t edgesExamined;
+
+    /**
+     * Marks a vertex reached at the given depth and queues it for the next
+     * level.
+     */
+    void reach(VertexId v, unsigned depth, std::vector<unsigned>& hops);
+
+    /**
+     * Builds the next level from the frontier's out-edges.
+     */
+    void stepTopDown(unsigned depth, std::vector<unsigned>& hops);
+
+    /**
+     * Builds the next level from the unvisited vertices' in-edges.
+     */
+    void stepBottomUp(unsigned depth, std::vector<unsigned>& hops);
+};
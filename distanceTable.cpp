@@ -0,0 +1,177 @@
+#include "distanceTable.h"
+#include "parallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+namespace
+{
+
+const double Infinity = std::numeric_limits<double>::infinity();
+
+typedef std::pair<double, unsigned> Label;
+
+Label operator+(const Label& a, const Label& b)
+{
+    return std::make_pair(a.first + b.first, a.second + b.second);
+}
+
+} // namespace
+
+/**
+ * Constructs an engine that has filled no table yet.
+ */
+DistanceTable::DistanceTable() : settledCount(0)
+{
+}
+
+/**
+ * Fills the table of least total weights from each source to each
+ * target.
+ * @param hierarchy - a hierarchy built or loaded for the graph
+ * @param sources - IDs of the vertices the rows start from
+ * @param targets - IDs of the vertices the columns end at
+ * @param table - filled with sources.size() rows of targets.size()
+ *                weights, row-major; infinity where there is no path or
+ *                an ID is not a vertex
+ * @param threads - how many threads to use, 0 for one per core
+ * @return - false, leaving every cell infinite, if the hierarchy is not
+ *           usable
+ */
+bool DistanceTable::fill(const ContractionHierarchy& hierarchy, const std::vector<VertexId>& sources,
+                         const std::vector<VertexId>& targets, std::vector<double>& table, unsigned threads)
+{
+    size_t rows = sources.size();
+    size_t columns = targets.size();
+    table.assign(rows * columns, Infinity);
+    bucketOffsets.clear();
+    buckets.clear();
+    settledCount = 0;
+    if (!hierarchy.usable())
+        return false;
+
+    size_t count = hierarchy.rank.size();
+    threads = resolveThreads(threads);
+    Search prototype;
+    prototype.label.assign(count, std::make_pair(Infinity, 0u));
+    prototype.queue.reset(count);
+    std::atomic<size_t> settled(0);
+
+    // one backward search per target, keeping the label of every vertex
+    // it settled
+    std::vector<std::vector<std::pair<VertexId, Label>>> spaces(columns);
+    parallelFor(columns, threads, prototype, [&](size_t column, Search& search) {
+        if (targets[column] >= count)
+            return;
+        climb(hierarchy, targets[column], false, search);
+        for (VertexId v : search.settled)
+            spaces[column].push_back(std::make_pair(v, search.label[v]));
+        settled += search.settled.size();
+    });
+
+    // merged in target order, so the table doesn't depend on the threads
+    bucketOffsets.assign(count + 1, 0);
+    for (const std::vector<std::pair<VertexId, Label>>& space : spaces)
+        for (const std::pair<VertexId, Label>& reached : space)
+            bucketOffsets[reached.first + 1]++;
+    for (size_t v = 0; v < count; v++)
+        bucketOffsets[v + 1] += bucketOffsets[v];
+    buckets.resize(bucketOffsets[count]);
+    std::vector<uint32_t> fillAt(bucketOffsets.begin(), bucketOffsets.end() - 1);
+    for (size_t column = 0; column < columns; column++)
+    {
+        for (const std::pair<VertexId, Label>& reached : spaces[column])
+        {
+            Entry& entry = buckets[fillAt[reached.first]++];
+            entry.weight = reached.second.first;
+            entry.hops = reached.second.second;
+            entry.column = static_cast<uint32_t>(column);
+        }
+    }
+    spaces.clear();
+
+    // one forward search per source, meeting every target in the buckets
+    parallelFor(rows, threads, prototype, [&](size_t row, Search& search) {
+        VertexId source = sources[row];
+        if (source >= count)
+            return;
+        climb(hierarchy, source, true, search);
+        settled += search.settled.size();
+        std::vector<Label> best(columns, std::make_pair(Infinity, 0u));
+        for (VertexId v : search.settled)
+        {
+            for (uint32_t b = bucketOffsets[v]; b < bucketOffsets[v + 1]; b++)
+            {
+                const Entry& entry = buckets[b];
+                Label candidate = search.label[v] + std::make_pair(entry.weight, entry.hops);
+                if (candidate < best[entry.column])
+                    best[entry.column] = candidate;
+            }
+        }
+        double* cells = &table[row * columns];
+        for (size_t column = 0; column < columns; column++)
+            if (best[column].first != Infinity)
+                cells[column] = best[column].first - hierarchy.potential[source] + hierarchy.potential[targets[column]];
+    });
+
+    settledCount = settled;
+    return true;
+}
+
+/**
+ * Returns how many bucket entries the target searches of the last table
+ * left behind.
+ */
+size_t DistanceTable::getBucketEntries() const
+{
+    return buckets.size();
+}
+
+/**
+ * Returns how many vertices the last table's searches settled, both
+ * phases together.
+ */
+size_t DistanceTable::getSettledCount() const
+{
+    return settledCount;
+}
+
+/**
+ * Runs an upward search from a vertex until its queue is empty,
+ * first clearing whatever the last search in this state labeled.
+ * @param hierarchy - the hierarchy to climb
+ * @param root - ID of the vertex to start from
+ * @param forward - whether to follow up arcs, as a source does, or
+ *                  reversed down arcs, as a target does
+ * @param search - the state to search in, sized for the hierarchy
+ */
+void DistanceTable::climb(const ContractionHierarchy& hierarchy, VertexId root, bool forward, Search& search)
+{
+    // the searches run until their queues empty, so everything labeled
+    // was settled
+    for (VertexId v : search.settled)
+        search.label[v] = std::make_pair(Infinity, 0u);
+    search.settled.clear();
+    search.queue.clear();
+
+    const std::vector<uint32_t>& offsets = forward ? hierarchy.upOffsets : hierarchy.downOffsets;
+    const std::vector<ContractionHierarchy::Arc>& arcs = forward ? hierarchy.up : hierarchy.down;
+    search.label[root] = std::make_pair(0.0, 0u);
+    search.queue.push(root, search.label[root]);
+    while (!search.queue.empty())
+    {
+        VertexId u = search.queue.pop();
+        search.settled.push_back(u);
+        for (uint32_t a = offsets[u]; a < offsets[u + 1]; a++)
+        {
+            const ContractionHierarchy::Arc& arc = arcs[a];
+            Label candidate = search.label[u] + std::make_pair(arc.weight, arc.hops);
+            if (candidate < search.label[arc.other])
+            {
+                search.label[arc.other] = candidate;
+                search.queue.decreaseKey(arc.other, candidate);
+            }
+        }
+    }
+}
@@ -0,0 +1,111 @@
+/**
+ * @file distanceTable.h
+ * Safest-path weights from many airports to many airports at once.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "contractionHierarchy.h"
+#include "csrGraph.h"
+#include "indexedHeap.h"
+
+/**
+ * Fills many-to-many tables of least total weight on a contraction
+ * hierarchy, sharing the work of the searches between all the cells.
+ *
+ * Every target runs one upward search over reversed down arcs and leaves
+ * an entry (target, weight from v to the target) in the bucket of each
+ * vertex v it settles. Every source then runs one upward search over up
+ * arcs, and at each vertex it settles reads the bucket: the best sum over
+ * all the vertices the two searches share is the cell's value, exactly as
+ * in a point query, but a table of S x T cells costs S + T searches
+ * instead of S x T. Upward search spaces on the airport network are a few
+ * hundred vertices, so the buckets stay small.
+ *
+ * The target searches are spread over several threads and merged into the
+ * buckets in target order, then the source searches are spread over the
+ * threads, each filling its own rows. Weights are ranked like the point
+ * queries, by total weight and then by number of flights, on the
+ * hierarchy's reduced weights; a hierarchy built for a graph with a
+ * negative cycle can't fill a table.
+ */
+class DistanceTable
+{
+  public:
+    /**
+     * Constructs an engine that has filled no table yet.
+     */
+    DistanceTable();
+
+    /**
+     * Fills the table of least total weights from each source to each
+     * target.
+     * @param hierarchy - a hierarchy built or loaded for the graph
+     * @param sources - IDs of the vertices the rows start from
+     * @param targets - IDs of the vertices the columns end at
+     * @param table - filled with sources.size() rows of targets.size()
+     *                weights, row-major; infinity where there is no path or
+     *                an ID is not a vertex
+     * @param threads - how many threads to use, 0 for one per core
+     * @return - false, leaving every cell infinite, if the hierarchy is not
+     *           usable
+     */
+    bool fill(const ContractionHierarchy& hierarchy, const std::vector<VertexId>& sources,
+              const std::vector<VertexId>& targets, std::vector<double>& table, unsigned threads = 0);
+
+    /**
+     * Returns how many bucket entries the target searches of the last table
+     * left behind.
+     */
+    size_t getBucketEntries() const;
+
+    /**
+     * Returns how many vertices the last table's searches settled, both
+     * phases together.
+     */
+    size_t getSettledCount() const;
+
+  private:
+    /** A path's total reduced weight and its number of edges. */
+    typedef std::pair<double, unsigned> Label;
+
+    /**
+     * State of one upward search, indexed by vertex ID.
+     */
+    struct Search
+    {
+        std::vector<Label> label;
+        std::vector<VertexId> settled; /**< In the order they were settled **/
+        IndexedHeap<Label> queue;
+    };
+
+    /**
+     * What a target search leaves at a vertex it settles.
+     */
+    struct Entry
+    {
+        double weight; /**< Reduced weight from the vertex to the target **/
+        unsigned hops; /**< Edges on that path **/
+        uint32_t column; /**< Index of the target in the table **/
+    };
+
+    std::vector<uint32_t> bucketOffsets; /**< Bucket of v is [bucketOffsets[v], bucketOffsets[v + 1]) **/
+    std::vector<Entry> buckets;
+    size_t settledCount;
+
+    /**
+     * Runs an upward search from a vertex until its queue is empty,
+     * first clearing whatever the last search in this state labeled.
+     * @param hierarchy - the hierarchy to climb
+     * @param root - ID of the vertex to start from
+     * @param forward - whether to follow up arcs, as a source does, or
+     *                  reversed down arcs, as a target does
+     * @param search - the state to search in, sized for the hierarchy
+     */
+    static void climb(const ContractionHierarchy& hierarchy, VertexId root, bool forward, Search& search);
+};
@@ -7,11 +7,17 @@
 
 #include <string>
 #include <limits.h>
+#include <stdint.h>
 
 using std::string;
 
 typedef string Vertex;
 
+/**
+ * Dense integer name of a vertex, handed out by Graph in insertion order.
+ */
+typedef uint32_t VertexId;
+
 /**
  * Represents an edge in a graph; used by the Graph class.
  *
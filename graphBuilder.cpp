@@ -0,0 +1,140 @@
+#include "graphBuilder.h"
+
+/**
+ * Constructs an empty builder.
+ */
+GraphBuilder::GraphBuilder()
+{
+}
+
+/**
+ * Reserves room for the expected input so queuing does not reallocate.
+ * @param vertexHint - expected number of addVertex calls
+ * @param edgeHint - expected number of addEdge calls
+ */
+void GraphBuilder::reserve(size_t vertexHint, size_t edgeHint)
+{
+    vertices.reserve(vertexHint);
+    edges.reserve(edgeHint);
+}
+
+/**
+ * Queues a vertex. Duplicates are allowed and ignored by build().
+ * @param v - the name for the vertex
+ */
+void GraphBuilder::addVertex(const Vertex& v)
+{
+    vertices.push_back(intern(v));
+}
+
+/**
+ * Queues an edge. Both endpoints are added as vertices when the graph
+ * is built. Duplicate edges are ignored by build().
+ * @param source - one vertex the edge is connected to
+ * @param destination - the other vertex the edge is connected to
+ */
+void GraphBuilder::addEdge(const Vertex& source, const Vertex& destination)
+{
+    uint32_t from = intern(source);
+    edges.push_back(make_pair(from, intern(destination)));
+}
+
+/**
+ * Queues everything another builder queued, after what this one has
+ * queued.
+ * @param other - the builder to copy the queue of
+ */
+void GraphBuilder::append(const GraphBuilder& other)
+{
+    std::vector<uint32_t> remap(other.names.size());
+    for (size_t i = 0; i < other.names.size(); i++)
+        remap[i] = intern(other.names[i]);
+
+    vertices.reserve(vertices.size() + other.vertices.size());
+    for (uint32_t v : other.vertices)
+        vertices.push_back(remap[v]);
+    edges.reserve(edges.size() + other.edges.size());
+    for (const auto& e : other.edges)
+        edges.push_back(make_pair(remap[e.first], remap[e.second]));
+}
+
+/**
+ * Returns the number of queued vertices (including duplicates).
+ */
+size_t GraphBuilder::vertexCount() const
+{
+    return vertices.size();
+}
+
+/**
+ * Returns the number of queued edges (including duplicates).
+ */
+size_t GraphBuilder::edgeCount() const
+{
+    return edges.size();
+}
+
+/**
+ * Inserts everything that was queued into the graph. Vertices and
+ * edges already in the graph are kept as they are, so build() can
+ * be called on a graph that already holds part of the data.
+ * @param g - the graph to insert into
+ */
+void GraphBuilder::build(Graph& g) const
+{
+    auto& adjacency = g.adjacency_list;
+    adjacency.reserve(adjacency.size() + names.size());
+
+    // each name is looked up in the graph once; unlike insertVertex, this
+    // leaves an existing vertex's edges alone
+    std::vector<unordered_map<Vertex, Edge>*> entries(names.size(), NULL);
+    auto vertexEntry = [&](uint32_t id) -> unordered_map<Vertex, Edge>& {
+        if (entries[id] == NULL)
+        {
+            auto inserted = adjacency.emplace(names[id], unordered_map<Vertex, Edge>());
+            if (inserted.second)
+                g.intern(names[id]);
+            entries[id] = &inserted.first->second;
+        }
+        return *entries[id];
+    };
+
+    for (uint32_t v : vertices)
+        vertexEntry(v);
+
+    for (const auto& e : edges)
+    {
+        const Vertex& source = names[e.first];
+        const Vertex& destination = names[e.second];
+        // emplace does not overwrite, matching insertEdge on an existing edge
+        vertexEntry(e.first).emplace(destination, Edge(source, destination));
+        if (g.directed)
+            vertexEntry(e.second);
+        else
+            vertexEntry(e.second).emplace(source, Edge(source, destination));
+    }
+}
+
+/**
+ * Drops everything that was queued.
+ */
+void GraphBuilder::clear()
+{
+    ids.clear();
+    names.clear();
+    vertices.clear();
+    edges.clear();
+}
+
+/**
+ * Returns the index of a name in names, adding it if it is new.
+ * @param v - the name to look up
+ * @return - its index
+ */
+uint32_t GraphBuilder::intern(const Vertex& v)
+{
+    auto found = ids.emplace(v, static_cast<uint32_t>(names.size()));
+    if (found.second)
+        names.push_back(v);
+    return found.first->second;
+}
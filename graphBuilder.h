@@ -0,0 +1,99 @@
+/**
+ * @file graphBuilder.h
+ * Bulk construction of a Graph from a list of vertices and edges.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "airportGraph.h"
+
+/**
+ * Collects vertices and edges and inserts them into a Graph all at once.
+ *
+ * Graph::insertVertex removes the vertex before inserting it, and removing
+ * a vertex from a directed graph walks the whole adjacency list. Loading a
+ * dataset one insertVertex call at a time is therefore quadratic. The
+ * builder only queues the input and touches every vertex and edge once
+ * when build() is called.
+ *
+ * Names are interned as they are queued, so the builder knows how many
+ * distinct vertices there are and build() can size the graph's table
+ * for exactly those.
+ */
+class GraphBuilder
+{
+  public:
+    /**
+     * Constructs an empty builder.
+     */
+    GraphBuilder();
+
+    /**
+     * Reserves room for the expected input so queuing does not reallocate.
+     * @param vertexHint - expected number of addVertex calls
+     * @param edgeHint - expected number of addEdge calls
+     */
+    void reserve(size_t vertexHint, size_t edgeHint);
+
+    /**
+     * Queues a vertex. Duplicates are allowed and ignored by build().
+     * @param v - the name for the vertex
+     */
+    void addVertex(const Vertex& v);
+
+    /**
+     * Queues an edge. Both endpoints are added as vertices when the graph
+     * is built. Duplicate edges are ignored by build().
+     * @param source - one vertex the edge is connected to
+     * @param destination - the other vertex the edge is connected to
+     */
+    void addEdge(const Vertex& source, const Vertex& destination);
+
+    /**
+     * Queues everything another builder queued, after what this one has
+     * queued, so builders filled from consecutive parts of the input can
+     * be merged in order. Only the other builder's distinct names are
+     * looked up.
+     * @param other - the builder to copy the queue of
+     */
+    void append(const GraphBuilder& other);
+
+    /**
+     * Returns the number of queued vertices (including duplicates).
+     */
+    size_t vertexCount() const;
+
+    /**
+     * Returns the number of queued edges (including duplicates).
+     */
+    size_t edgeCount() const;
+
+    /**
+     * Inserts everything that was queued into the graph. Vertices and
+     * edges already in the graph are kept as they are, so build() can
+     * be called on a graph that already holds part of the data.
+     * @param g - the graph to insert into
+     */
+    void build(Graph& g) const;
+
+    /**
+     * Drops everything that was queued.
+     */
+    void clear();
+
+  private:
+    std::unordered_map<Vertex, uint32_t> ids; /**< Index of each name in names **/
+    std::vector<Vertex> names; /**< Every distinct name, in the order first queued **/
+    std::vector<uint32_t> vertices;
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+
+    /**
+     * Returns the index of a name in names, adding it if it is new.
+     */
+    uint32_t intern(const Vertex& v);
+};
@@ -0,0 +1,206 @@
+#include "graphSnapshot.h"
+#include "mappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+
+const uint32_t GraphSnapshot::Version = 2;
+
+namespace
+{
+
+const char kMagic[8] = {'S', 'C', 'G', 'R', 'A', 'P', 'H', '\0'};
+
+const uint32_t kDirected = 1;
+const uint32_t kWeighted = 2;
+
+/**
+ * Fixed-size start of every snapshot file.
+ */
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t fingerprint;
+    uint32_t vertexCount;
+    uint32_t edgeCount;
+    uint64_t nameBytes;
+    uint64_t labelBytes;
+};
+
+/**
+ * Writes a vector's contents to a file.
+ */
+template <class T>
+bool writeAll(FILE* out, const vector<T>& values)
+{
+    return values.empty() || fwrite(values.data(), sizeof(T), values.size(), out) == values.size();
+}
+
+} // namespace
+
+/**
+ * Writes the graph to a snapshot file. The file is written next to
+ * path and renamed into place, so readers never see a partial file.
+ * @param g - the graph to save
+ * @param path - where to write the snapshot
+ * @param fingerprint - fingerprint of the dataset g was built from
+ * @return whether the snapshot was written
+ */
+bool GraphSnapshot::save(const Graph& g, const std::string& path, uint64_t fingerprint)
+{
+    const auto& adjacency = g.adjacency_list;
+
+    // vertices are written in ID order, so IDs survive a round trip
+    // (compacted if vertices were removed)
+    vector<const Vertex*> order;
+    unordered_map<Vertex, uint32_t> index;
+    index.reserve(adjacency.size());
+    vector<uint32_t> nameOffsets(1, 0);
+    string names;
+    for (const Vertex& v : g.vertex_names)
+    {
+        if (adjacency.find(v) == adjacency.end())
+            continue;
+        index.emplace(v, static_cast<uint32_t>(order.size()));
+        order.push_back(&v);
+        names += v;
+        nameOffsets.push_back(static_cast<uint32_t>(names.size()));
+    }
+
+    vector<uint32_t> adjOffsets(1, 0);
+    vector<uint32_t> targets;
+    vector<double> weights;
+    vector<uint32_t> labelOffsets(1, 0);
+    string labels;
+    for (const Vertex* v : order)
+    {
+        for (const auto& out : adjacency.find(*v)->second)
+        {
+            targets.push_back(index[out.first]);
+            weights.push_back(out.second.getWeight());
+            labels += out.second.getLabel();
+            labelOffsets.push_back(static_cast<uint32_t>(labels.size()));
+        }
+        adjOffsets.push_back(static_cast<uint32_t>(targets.size()));
+    }
+
+    Header header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = Version;
+    header.flags = (g.directed ? kDirected : 0) | (g.weighted ? kWeighted : 0);
+    header.fingerprint = fingerprint;
+    header.vertexCount = static_cast<uint32_t>(order.size());
+    header.edgeCount = static_cast<uint32_t>(targets.size());
+    header.nameBytes = names.size();
+    header.labelBytes = labels.size();
+
+    string tmpPath = path + ".tmp";
+    FILE* out = fopen(tmpPath.c_str(), "wb");
+    if (out == NULL)
+        return false;
+
+    // the weights go first so they stay 8-byte aligned in the mapping
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+              && writeAll(out, weights)
+              && writeAll(out, nameOffsets)
+              && writeAll(out, adjOffsets)
+              && writeAll(out, targets)
+              && writeAll(out, labelOffsets)
+              && fwrite(names.data(), 1, names.size(), out) == names.size()
+              && fwrite(labels.data(), 1, labels.size(), out) == labels.size();
+    ok = (fclose(out) == 0) && ok;
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Replaces the contents of a graph with a snapshot.
+ * @param g - the graph to load into; left unchanged on failure
+ * @param path - the snapshot to read
+ * @param fingerprint - fingerprint of the dataset the caller expects
+ * @return - if the snapshot exists, is intact, has the current format
+ *  version and the expected fingerprint, true
+ *         - otherwise false
+ */
+bool GraphSnapshot::load(Graph& g, const std::string& path, uint64_t fingerprint)
+{
+    MappedFile file(path);
+    if (file.size() < sizeof(Header))
+        return false;
+
+    Header header;
+    memcpy(&header, file.data(), sizeof(header));
+    uint32_t flags = (g.directed ? kDirected : 0) | (g.weighted ? kWeighted : 0);
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != Version
+        || header.flags != flags || header.fingerprint != fingerprint)
+        return false;
+
+    uint64_t V = header.vertexCount;
+    uint64_t E = header.edgeCount;
+    uint64_t expected = sizeof(Header) + E * sizeof(double) + (V + 1) * sizeof(uint32_t)
+                        + (V + 1) * sizeof(uint32_t) + E * sizeof(uint32_t)
+                        + (E + 1) * sizeof(uint32_t) + header.nameBytes + header.labelBytes;
+    if (file.size() != expected)
+        return false;
+
+    const char* cursor = file.data() + sizeof(Header);
+    const double* weights = reinterpret_cast<const double*>(cursor);
+    cursor += E * sizeof(double);
+    const uint32_t* nameOffsets = reinterpret_cast<const uint32_t*>(cursor);
+    cursor += (V + 1) * sizeof(uint32_t);
+    const uint32_t* adjOffsets = reinterpret_cast<const uint32_t*>(cursor);
+    cursor += (V + 1) * sizeof(uint32_t);
+    const uint32_t* targets = reinterpret_cast<const uint32_t*>(cursor);
+    cursor += E * sizeof(uint32_t);
+    const uint32_t* labelOffsets = reinterpret_cast<const uint32_t*>(cursor);
+    cursor += (E + 1) * sizeof(uint32_t);
+    const char* names = cursor;
+    const char* labels = names + header.nameBytes;
+
+    // check every offset before trusting any of them
+    if (nameOffsets[0] != 0 || nameOffsets[V] != header.nameBytes || adjOffsets[0] != 0
+        || adjOffsets[V] != E || labelOffsets[0] != 0 || labelOffsets[E] != header.labelBytes)
+        return false;
+    for (uint64_t v = 0; v < V; v++)
+    {
+        if (nameOffsets[v] > nameOffsets[v + 1] || adjOffsets[v] > adjOffsets[v + 1])
+            return false;
+    }
+    for (uint64_t e = 0; e < E; e++)
+    {
+        if (targets[e] >= V || labelOffsets[e] > labelOffsets[e + 1])
+            return false;
+    }
+
+    vector<Vertex> vertices;
+    vertices.reserve(V);
+    for (uint64_t v = 0; v < V; v++)
+        vertices.push_back(Vertex(names + nameOffsets[v], nameOffsets[v + 1] - nameOffsets[v]));
+
+    unordered_map<Vertex, unordered_map<Vertex, Edge>> adjacency;
+    adjacency.reserve(V);
+    for (uint64_t v = 0; v < V; v++)
+    {
+        unordered_map<Vertex, Edge>& out = adjacency[vertices[v]];
+        out.reserve(adjOffsets[v + 1] - adjOffsets[v]);
+        for (uint32_t e = adjOffsets[v]; e < adjOffsets[v + 1]; e++)
+        {
+            const Vertex& dest = vertices[targets[e]];
+            string label(labels + labelOffsets[e], labelOffsets[e + 1] - labelOffsets[e]);
+            out.emplace(dest, Edge(vertices[v], dest, weights[e], label));
+        }
+    }
+
+    g.clear();
+    g.adjacency_list.swap(adjacency);
+    for (const Vertex& v : vertices)
+        g.intern(v);
+    return true;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file graphSnapshot.h
+ * Versioned binary snapshots of a Graph.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "airportGraph.h"
+
+/**
+ * Saves a Graph to a compact binary file and loads it back through a
+ * memory mapping, so a dataset only has to be parsed once.
+ *
+ * The file holds a header (magic, format version, directed/weighted flags,
+ * a fingerprint of the dataset the graph was built from and the table
+ * sizes), then the edge weights, the vertex name offsets, the adjacency
+ * offsets and targets, the edge label offsets, and finally the vertex name
+ * and edge label characters. All integers are stored in host byte order.
+ */
+class GraphSnapshot
+{
+  public:
+    /**
+     * Writes the graph to a snapshot file. The file is written next to
+     * path and renamed into place, so readers never see a partial file.
+     * @param g - the graph to save
+     * @param path - where to write the snapshot
+     * @param fingerprint - fingerprint of the dataset g was built from
+     * @return whether the snapshot was written
+     */
+    static bool save(const Graph& g, const std::string& path, uint64_t fingerprint);
+
+    /**
+     * Replaces the contents of a graph with a snapshot.
+     * @param g - the graph to load into; left unchanged on failure
+     * @param path - the snapshot to read
+     * @param fingerprint - fingerprint of the dataset the caller expects
+     * @return - if the snapshot exists, is intact, has the current format
+     *  version and the expected fingerprint, true
+     *         - otherwise false
+     */
+    static bool load(Graph& g, const std::string& path, uint64_t fingerprint);
+
+    /** Current snapshot format version; bump it whenever the layout changes. */
+    const static uint32_t Version;
+};
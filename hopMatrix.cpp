@@ -0,0 +1,208 @@
+#include "hopMatrix.h"
+#include "mappedFile.h"
+#include "multiSourceBFS.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+const unsigned HopMatrix::Unreached = UINT_MAX;
+const uint32_t HopMatrix::Version = 1;
+
+namespace
+{
+
+const char kMagic[8] = {'S', 'C', 'H', 'O', 'P', 'M', 'X', '\0'};
+
+/**
+ * Fixed-size start of every matrix file.
+ */
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t vertexCount;
+    uint64_t topology;
+};
+
+} // namespace
+
+/**
+ * Constructs an empty matrix.
+ */
+HopMatrix::HopMatrix() : topology(0), vertexCount(0)
+{
+}
+
+/**
+ * Fills the matrix for a graph.
+ * @param g - the graph to measure
+ * @param threads - how many threads to use, 0 for one per core
+ */
+HopMatrix::HopMatrix(const CSRGraph& g, unsigned threads)
+    : topology(g.topologyFingerprint()), vertexCount(static_cast<uint32_t>(g.vertexCount()))
+{
+    MultiSourceBFS batch(g);
+    if (!batch.allPairs(matrix, threads))
+    {
+        topology = 0;
+        vertexCount = 0;
+        matrix.clear();
+    }
+}
+
+/**
+ * Whether the matrix holds the distances of some graph, which is false
+ * if nothing was built or loaded, or a route was too long for a byte.
+ */
+bool HopMatrix::usable() const
+{
+    return vertexCount != 0;
+}
+
+/**
+ * Whether a graph has the topology the matrix was built for.
+ * @param g - the graph to check
+ */
+bool HopMatrix::fits(const CSRGraph& g) const
+{
+    return usable() && g.vertexCount() == vertexCount && g.topologyFingerprint() == topology;
+}
+
+/**
+ * Returns the fewest edges from one vertex to another.
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @return - the count, or Unreached if there is no route or either ID
+ *           is not a vertex
+ */
+unsigned HopMatrix::hops(VertexId source, VertexId destination) const
+{
+    if (source >= vertexCount || destination >= vertexCount)
+        return Unreached;
+    uint8_t entry = matrix[static_cast<size_t>(source) * vertexCount + destination];
+    return entry == MultiSourceBFS::Unreached ? Unreached : entry;
+}
+
+/**
+ * Whether one vertex can be reached from another within some number
+ * of edges.
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @param maxHops - the most edges the route may use
+ */
+bool HopMatrix::withinHops(VertexId source, VertexId destination, unsigned maxHops) const
+{
+    unsigned count = hops(source, destination);
+    return count != Unreached && count <= maxHops;
+}
+
+/**
+ * Finds a route with the fewest edges by walking down the matrix.
+ * @param g - the graph the matrix was built for
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @param path - filled with the IDs along the route, source first;
+ *               left empty if there is no route within the limit
+ * @param maxHops - the most edges the route may use
+ * @return - PathFound, NoPathWithinHops or NoPath
+ */
+HopSearchResult HopMatrix::findPath(const CSRGraph& g, VertexId source, VertexId destination,
+                                    std::vector<VertexId>& path, unsigned maxHops) const
+{
+    path.clear();
+    unsigned remaining = hops(source, destination);
+    if (remaining == Unreached)
+        return NoPath;
+    if (remaining > maxHops)
+        return NoPathWithinHops;
+
+    path.push_back(source);
+    for (VertexId u = source; remaining > 0; remaining--)
+    {
+        uint32_t e = g.edgeBegin(u);
+        while (e < g.edgeEnd(u) && hops(g.target(e), destination) != remaining - 1)
+            e++;
+        // only possible if g is not the graph the matrix was built for
+        if (e == g.edgeEnd(u))
+        {
+            path.clear();
+            return NoPath;
+        }
+        u = g.target(e);
+        path.push_back(u);
+    }
+    return PathFound;
+}
+
+/**
+ * Returns the bytes taken by the matrix.
+ */
+size_t HopMatrix::bytes() const
+{
+    return matrix.size();
+}
+
+/**
+ * Writes the matrix to a file. The file is written next to path and
+ * renamed into place, so readers never see a partial file.
+ * @param path - where to write the matrix
+ * @return - whether the file was written
+ */
+bool HopMatrix::save(const std::string& path) const
+{
+    if (!usable())
+        return false;
+
+    Header header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = Version;
+    header.vertexCount = vertexCount;
+    header.topology = topology;
+
+    std::string tmpPath = path + ".tmp";
+    FILE* out = fopen(tmpPath.c_str(), "wb");
+    if (out == NULL)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+              && fwrite(matrix.data(), 1, matrix.size(), out) == matrix.size();
+    ok = (fclose(out) == 0) && ok;
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Replaces this matrix with one read from a file.
+ * @param path - the file to read
+ * @param g - the graph the matrix is for; its topology must match the
+ *            one the file was built from
+ * @return - false, leaving the matrix unchanged, if the file is
+ *           missing, damaged, of another format version or built for
+ *           another graph
+ */
+bool HopMatrix::load(const std::string& path, const CSRGraph& g)
+{
+    MappedFile file(path);
+    if (file.size() < sizeof(Header))
+        return false;
+
+    Header header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != Version || header.vertexCount == 0
+        || header.vertexCount != g.vertexCount() || header.topology != g.topologyFingerprint())
+        return false;
+    uint64_t entries = static_cast<uint64_t>(header.vertexCount) * header.vertexCount;
+    if (file.size() != sizeof(Header) + entries)
+        return false;
+
+    const uint8_t* first = reinterpret_cast<const uint8_t*>(file.data() + sizeof(Header));
+    matrix.assign(first, first + entries);
+    topology = header.topology;
+    vertexCount = header.vertexCount;
+    return true;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file hopMatrix.h
+ * Fewest-flight counts between every pair of airports, one byte each.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bidirectionalBFS.h"
+#include "csrGraph.h"
+
+/**
+ * Stores the fewest number of edges from every vertex to every other, so
+ * "how many flights from s to d" and "is d within k flights of s" are a
+ * single array read.
+ *
+ * The matrix is filled by MultiSourceBFS, 64 sources per traversal spread
+ * over several threads, and takes one byte per pair: about 12 MB for the
+ * 3425 OpenFlights airports. It only depends on which airports are
+ * connected, not on the weights, so it stays valid across setPerson and
+ * can be saved to a file and loaded back for a graph with the same
+ * topology (see CSRGraph::topologyFingerprint).
+ *
+ * With the matrix a fewest-flight route needs no search at all: from s,
+ * step to any out-neighbor one flight closer to d, and repeat. Every
+ * neighbor that is not exactly one flight closer is pruned, so finding a
+ * route takes time proportional to its length times the degree.
+ */
+class HopMatrix
+{
+  public:
+    /**
+     * Constructs an empty matrix.
+     */
+    HopMatrix();
+
+    /**
+     * Fills the matrix for a graph.
+     * @param g - the graph to measure
+     * @param threads - how many threads to use, 0 for one per core
+     */
+    HopMatrix(const CSRGraph& g, unsigned threads = 0);
+
+    /**
+     * Whether the matrix holds the distances of some graph, which is false
+     * if nothing was built or loaded, or a route was too long for a byte.
+     */
+    bool usable() const;
+
+    /**
+     * Whether a graph has the topology the matrix was built for.
+     * @param g - the graph to check
+     */
+    bool fits(const CSRGraph& g) const;
+
+    /**
+     * Returns the fewest edges from one vertex to another.
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @return - the count, or Unreached if there is no route or either ID
+     *           is not a vertex
+     */
+    unsigned hops(VertexId source, VertexId destination) const;
+
+    /**
+     * Whether one vertex can be reached from another within some number
+     * of edges.
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @param maxHops - the most edges the route may use
+     */
+    bool withinHops(VertexId source, VertexId destination, unsigned maxHops) const;
+
+    /**
+     * Finds a route with the fewest edges by walking down the matrix.
+     * @param g - the graph the matrix was built for
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @param path - filled with the IDs along the route, source first;
+     *               left empty if there is no route within the limit
+     * @param maxHops - the most edges the route may use
+     * @return - PathFound, NoPathWithinHops or NoPath
+     */
+    HopSearchResult findPath(const CSRGraph& g, VertexId source, VertexId destination, std::vector<VertexId>& path,
+                             unsigned maxHops = BidirectionalBFS::NoHopLimit) const;
+
+    /**
+     * Returns the bytes taken by the matrix.
+     */
+    size_t bytes() const;
+
+    /**
+     * Writes the matrix to a file. The file is written next to path and
+     * renamed into place, so readers never see a partial file.
+     * @param path - where to write the matrix
+     * @return - whether the file was written
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * Replaces this matrix with one read from a file.
+     * @param path - the file to read
+     * @param g - the graph the matrix is for; its topology must match the
+     *            one the file was built from
+     * @return - false, leaving the matrix unchanged, if the file is
+     *           missing, damaged, of another format version or built for
+     *           another graph
+     */
+    bool load(const std::string& path, const CSRGraph& g);
+
+    /** hops result for a vertex that cannot be reached. */
+    const static unsigned Unreached;
+
+    /** Current file format version; bump it whenever the layout changes. */
+    const static uint32_t Version;
+
+  private:
+    uint64_t topology;
+    uint32_t vertexCount;
+    std::vector<uint8_t> matrix; /**< Edges from s to v at [s * vertexCount + v] **/
+};
@@ -0,0 +1,330 @@
+#include "hubLabels.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "indexedHeap.h"
+
+namespace
+{
+
+const double Infinity = std::numeric_limits<double>::infinity();
+
+typedef std::pair<double, unsigned> Label;
+
+Label operator+(const Label& a, const Label& b)
+{
+    return std::make_pair(a.first + b.first, a.second + b.second);
+}
+
+/**
+ * The labels while they are being built, one growing list per vertex.
+ */
+class Labeler
+{
+  public:
+    /**
+     * One label entry: a hub, the distance to or from it, and the
+     * neighbor the search reached the vertex from.
+     */
+    struct Hub
+    {
+        uint32_t rank;
+        Label distance;
+        VertexId via;
+    };
+
+    std::vector<std::vector<Hub>> out; /**< Hubs v reaches, with distance from v **/
+    std::vector<std::vector<Hub>> in; /**< Hubs that reach v, with distance to v **/
+
+    Labeler(const CSRGraph& g, const std::vector<double>& potential)
+        : out(g.vertexCount()), in(g.vertexCount()), forward(g), backward(g.reversed()), potential(potential),
+          dist(g.vertexCount(), std::make_pair(Infinity, 0u)), parent(g.vertexCount(), Graph::InvalidVertexId),
+          hubDistance(g.vertexCount(), std::make_pair(Infinity, 0u))
+    {
+        queue.reset(g.vertexCount());
+    }
+
+    /**
+     * Runs the pruned searches from one hub, forward and then backward.
+     * @param h - the hub's vertex ID
+     * @param rank - how many hubs came before it
+     */
+    void addHub(VertexId h, uint32_t rank)
+    {
+        search(h, rank, forward, false, out[h], in);
+        search(h, rank, backward, true, in[h], out);
+    }
+
+  private:
+    const CSRGraph& forward;
+    CSRGraph backward;
+    const std::vector<double>& potential;
+
+    std::vector<Label> dist;
+    std::vector<VertexId> parent;
+    std::vector<VertexId> touched;
+    std::vector<Label> hubDistance; /**< The hub's own label, spread out by rank **/
+    IndexedHeap<Label> queue;
+
+    /**
+     * Dijkstra from a hub that labels every vertex the earlier hubs do
+     * not already cover, and does not expand past the covered ones.
+     * @param own - the hub's label on the other side, which covered
+     *              distances go through
+     * @param labels - the labels this search extends
+     */
+    void search(VertexId h, uint32_t rank, const CSRGraph& graph, bool backwards, const std::vector<Hub>& own,
+                std::vector<std::vector<Hub>>& labels)
+    {
+        for (const Hub& hub : own)
+            hubDistance[hub.rank] = hub.distance;
+        for (VertexId v : touched)
+        {
+            dist[v] = std::make_pair(Infinity, 0u);
+            parent[v] = Graph::InvalidVertexId;
+        }
+        touched.clear();
+        queue.clear();
+
+        dist[h] = std::make_pair(0.0, 0u);
+        touched.push_back(h);
+        queue.push(h, dist[h]);
+        while (!queue.empty())
+        {
+            VertexId v = queue.pop();
+            bool covered = false;
+            for (const Hub& hub : labels[v])
+            {
+                if (!(dist[v] < hubDistance[hub.rank] + hub.distance))
+                {
+                    covered = true;
+                    break;
+                }
+            }
+            if (covered)
+                continue;
+            Hub entry = {rank, dist[v], parent[v]};
+            labels[v].push_back(entry);
+
+            for (uint32_t e = graph.edgeBegin(v); e < graph.edgeEnd(v); e++)
+            {
+                VertexId x = graph.target(e);
+                // reduced weight of the real edge, which runs x -> v when searching backwards
+                double reduced = backwards ? graph.weight(e) + potential[x] - potential[v]
+                                           : graph.weight(e) + potential[v] - potential[x];
+                Label candidate = dist[v] + std::make_pair(std::max(0.0, reduced), 1u);
+                if (candidate < dist[x])
+                {
+                    if (dist[x].first == Infinity)
+                        touched.push_back(x);
+                    dist[x] = candidate;
+                    parent[x] = v;
+                    queue.decreaseKey(x, candidate);
+                }
+            }
+        }
+
+        for (const Hub& hub : own)
+            hubDistance[hub.rank] = std::make_pair(Infinity, 0u);
+    }
+};
+
+} // namespace
+
+/**
+ * Constructs an engine with no labels.
+ */
+HubLabels::HubLabels() : cycleFree(false), outOffsets(1, 0), inOffsets(1, 0), cost(Infinity)
+{
+}
+
+/**
+ * Builds the labels of every vertex of a graph.
+ * @param g - the graph to index
+ */
+HubLabels::HubLabels(const CSRGraph& g) : outOffsets(1, 0), inOffsets(1, 0), cost(Infinity)
+{
+    cycleFree = g.feasiblePotential(potential);
+    if (!cycleFree)
+        return;
+
+    // busy airports lie on the most best paths, so they go first
+    size_t count = g.vertexCount();
+    std::vector<uint32_t> degree(count, 0);
+    for (VertexId u = 0; u < count; u++)
+    {
+        degree[u] += g.degree(u);
+        for (uint32_t e = g.edgeBegin(u); e < g.edgeEnd(u); e++)
+            degree[g.target(e)]++;
+    }
+    hubs.resize(count);
+    for (VertexId v = 0; v < count; v++)
+        hubs[v] = v;
+    std::stable_sort(hubs.begin(), hubs.end(), [&degree](VertexId a, VertexId b) {
+        return degree[a] > degree[b];
+    });
+
+    Labeler labeler(g, potential);
+    for (uint32_t rank = 0; rank < count; rank++)
+        labeler.addHub(hubs[rank], rank);
+
+    // hubs were added in rank order, so every list is already sorted
+    outOffsets.assign(count + 1, 0);
+    inOffsets.assign(count + 1, 0);
+    for (VertexId v = 0; v < count; v++)
+    {
+        for (const Labeler::Hub& hub : labeler.out[v])
+        {
+            Entry entry = {hub.rank, hub.distance.second, hub.distance.first};
+            out.push_back(entry);
+            outNext.push_back(hub.via);
+        }
+        for (const Labeler::Hub& hub : labeler.in[v])
+        {
+            Entry entry = {hub.rank, hub.distance.second, hub.distance.first};
+            in.push_back(entry);
+            inPrevious.push_back(hub.via);
+        }
+        outOffsets[v + 1] = static_cast<uint32_t>(out.size());
+        inOffsets[v + 1] = static_cast<uint32_t>(in.size());
+    }
+}
+
+/**
+ * Whether lookups can be answered, which is false if the graph has a
+ * negative cycle or nothing was built.
+ */
+bool HubLabels::usable() const
+{
+    return cycleFree;
+}
+
+/**
+ * Looks up the total weight of the safest path between two vertices.
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @return - the weight, or infinity if there is no path
+ */
+double HubLabels::distance(VertexId source, VertexId destination) const
+{
+    if (!cycleFree || source >= hubs.size() || destination >= hubs.size())
+        return Infinity;
+    uint32_t hub;
+    Label best = lookup(source, destination, hub);
+    if (best.first == Infinity)
+        return Infinity;
+    return best.first - potential[source] + potential[destination];
+}
+
+/**
+ * Finds the safest path between two vertices.
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @param path - filled with the IDs along the path, source first;
+ *               left empty if there is no path
+ * @return - whether a path was found
+ */
+bool HubLabels::findPath(VertexId source, VertexId destination, std::vector<VertexId>& path)
+{
+    path.clear();
+    cost = Infinity;
+    if (!cycleFree || source >= hubs.size() || destination >= hubs.size())
+        return false;
+    uint32_t rank;
+    Label best = lookup(source, destination, rank);
+    if (best.first == Infinity)
+        return false;
+
+    // every vertex on a labeled path was labeled by the same search
+    VertexId hub = hubs[rank];
+    path.push_back(source);
+    for (VertexId v = source; v != hub;)
+    {
+        v = outNext[find(outOffsets, out, v, rank)];
+        path.push_back(v);
+    }
+    size_t middle = path.size();
+    for (VertexId v = destination; v != hub; v = inPrevious[find(inOffsets, in, v, rank)])
+        path.push_back(v);
+    std::reverse(path.begin() + middle, path.end());
+
+    cost = best.first - potential[source] + potential[destination];
+    return true;
+}
+
+/**
+ * Returns the total weight of the path found by the last findPath.
+ */
+double HubLabels::getCost() const
+{
+    return cost;
+}
+
+/**
+ * Returns the number of label entries over all vertices, both directions.
+ */
+size_t HubLabels::entryCount() const
+{
+    return out.size() + in.size();
+}
+
+/**
+ * Returns the bytes taken by the labels, including what path
+ * unpacking needs.
+ */
+size_t HubLabels::indexBytes() const
+{
+    return entryCount() * (sizeof(Entry) + sizeof(VertexId)) + (outOffsets.size() + inOffsets.size()) * sizeof(uint32_t)
+           + hubs.size() * sizeof(VertexId) + potential.size() * sizeof(double);
+}
+
+/**
+ * Merges the out-label of one vertex with the in-label of another.
+ * @param hub - set to the rank of the best common hub, if there is one
+ * @return - the best reduced distance, infinite if there is no path
+ */
+HubLabels::Label HubLabels::lookup(VertexId source, VertexId destination, uint32_t& hub) const
+{
+    Label best = std::make_pair(Infinity, 0u);
+    uint32_t i = outOffsets[source];
+    uint32_t j = inOffsets[destination];
+    while (i < outOffsets[source + 1] && j < inOffsets[destination + 1])
+    {
+        if (out[i].hub < in[j].hub)
+        {
+            i++;
+        }
+        else if (in[j].hub < out[i].hub)
+        {
+            j++;
+        }
+        else
+        {
+            Label through = std::make_pair(out[i].weight + in[j].weight, out[i].hops + in[j].hops);
+            if (through < best)
+            {
+                best = through;
+                hub = out[i].hub;
+            }
+            i++;
+            j++;
+        }
+    }
+    return best;
+}
+
+/**
+ * Finds the entry for a hub in one vertex's label.
+ * @return - its index in out or in
+ */
+uint32_t HubLabels::find(const std::vector<uint32_t>& offsets, const std::vector<Entry>& entries, VertexId v,
+                         uint32_t hub) const
+{
+    const Entry* first = entries.data() + offsets[v];
+    const Entry* last = entries.data() + offsets[v + 1];
+    const Entry* found = std::lower_bound(first, last, hub, [](const Entry& entry, uint32_t rank) {
+        return entry.hub < rank;
+    });
+    return static_cast<uint32_t>(found - entries.data());
+}
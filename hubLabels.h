@@ -0,0 +1,131 @@
+/**
+ * @file hubLabels.h
+ * Hub labels over the airport graph for safest-path distance lookups.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "csrGraph.h"
+
+/**
+ * Answers safest-path distance lookups from precomputed hub labels.
+ *
+ * Every vertex v gets an out-label, a list of (hub, distance from v to the
+ * hub) pairs, and an in-label of (hub, distance from the hub to v) pairs,
+ * chosen so that for any s and t some best path from s to t passes a hub
+ * in both the out-label of s and the in-label of t. dist(s, t) is then the
+ * smallest out(s) + in(t) over their common hubs, found by merging the two
+ * lists, which are sorted by hub.
+ *
+ * The labels come from pruned landmark labeling. The vertices take turns
+ * as hub, busiest airports first, and each runs Dijkstra forward and
+ * backward. The search stops expanding a vertex as soon as the labels
+ * built so far already give a distance at least as good, so busy airports
+ * cover most pairs and later searches stay small.
+ *
+ * Each label entry also remembers the next vertex toward its hub, so the
+ * path behind a distance can be unpacked in time linear in its length
+ * times the log of the label size.
+ *
+ * Paths are ranked like safeCovid's Dijkstra, by total weight and then by
+ * number of flights, and the labels hold Johnson-reduced weights (see
+ * CSRGraph::feasiblePotential). A graph with a negative cycle is reported
+ * as unusable.
+ */
+class HubLabels
+{
+  public:
+    /**
+     * Constructs an engine with no labels.
+     */
+    HubLabels();
+
+    /**
+     * Builds the labels of every vertex of a graph.
+     * @param g - the graph to index
+     */
+    HubLabels(const CSRGraph& g);
+
+    /**
+     * Whether lookups can be answered, which is false if the graph has a
+     * negative cycle or nothing was built.
+     */
+    bool usable() const;
+
+    /**
+     * Looks up the total weight of the safest path between two vertices.
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @return - the weight, or infinity if there is no path
+     */
+    double distance(VertexId source, VertexId destination) const;
+
+    /**
+     * Finds the safest path between two vertices.
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @param path - filled with the IDs along the path, source first;
+     *               left empty if there is no path
+     * @return - whether a path was found
+     */
+    bool findPath(VertexId source, VertexId destination, std::vector<VertexId>& path);
+
+    /**
+     * Returns the total weight of the path found by the last findPath.
+     */
+    double getCost() const;
+
+    /**
+     * Returns the number of label entries over all vertices, both directions.
+     */
+    size_t entryCount() const;
+
+    /**
+     * Returns the bytes taken by the labels, including what path
+     * unpacking needs.
+     */
+    size_t indexBytes() const;
+
+  private:
+    /** A path's total reduced weight and its number of edges. */
+    typedef std::pair<double, unsigned> Label;
+
+    /**
+     * One hub of a label, with the distance to or from it.
+     */
+    struct Entry
+    {
+        uint32_t hub; /**< Rank of the hub; entries are sorted by it **/
+        uint32_t hops;
+        double weight; /**< Reduced weight **/
+    };
+
+    bool cycleFree;
+    std::vector<double> potential;
+    std::vector<VertexId> hubs; /**< Vertex of each rank, busiest first **/
+    std::vector<uint32_t> outOffsets; /**< Out-label of v is [outOffsets[v], outOffsets[v + 1]) **/
+    std::vector<Entry> out;
+    std::vector<VertexId> outNext; /**< Next vertex from v toward the hub, per out entry **/
+    std::vector<uint32_t> inOffsets; /**< In-label of v is [inOffsets[v], inOffsets[v + 1]) **/
+    std::vector<Entry> in;
+    std::vector<VertexId> inPrevious; /**< Vertex before v on the way from the hub, per in entry **/
+    double cost;
+
+    /**
+     * Merges the out-label of one vertex with the in-label of another.
+     * @param hub - set to the rank of the best common hub, if there is one
+     * @return - the best reduced distance, infinite if there is no path
+     */
+    Label lookup(VertexId source, VertexId destination, uint32_t& hub) const;
+
+    /**
+     * Finds the entry for a hub in one vertex's label.
+     * @return - its index in out or in
+     */
+    uint32_t find(const std::vector<uint32_t>& offsets, const std::vector<Entry>& entries, VertexId v,
+                  uint32_t hub) const;
+};
@@ -0,0 +1,331 @@
+/**
+ * @file indexedHeap.h
+ * Definition of an indexed d-ary heap with decrease-key.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * IndexedHeap: a priority queue over the integer keys [0, keyCount)
+ * that can change the priority of a key already in the queue.
+ *
+ * Unlike heap, every key remembers where it sits in the heap array, so
+ * contains() is O(1) and decreaseKey() is O(log n) without searching.
+ * Each heap slot holds the key together with its priority, so sifting
+ * only ever compares entries that are already next to each other in
+ * memory. Keys are meant to be dense, like the VertexIds of a Graph.
+ *
+ * @tparam Priority - the priority type
+ * @tparam Arity - children per node; 4 is usually fastest, 2 and 8 also work
+ * @tparam Compare - returns true if the first priority should come out first;
+ *  std::less makes a min-heap
+ */
+template <class Priority = double, unsigned Arity = 4, class Compare = std::less<Priority>>
+class IndexedHeap
+{
+    static_assert(Arity >= 2, "IndexedHeap needs at least two children per node");
+
+  public:
+    typedef uint32_t Key;
+
+    /**
+     * Position of a key that is not in the heap.
+     */
+    const static uint32_t NotInHeap = UINT32_MAX;
+
+    /**
+     * Constructs an empty heap that can hold no keys until reset.
+     */
+    IndexedHeap();
+
+    /**
+     * Constructs an empty heap for the keys [0, keyCount).
+     * @param keyCount - one past the largest key that will be pushed
+     */
+    explicit IndexedHeap(size_t keyCount);
+
+    /**
+     * Empties the heap and makes room for the keys [0, keyCount).
+     * @param keyCount - one past the largest key that will be pushed
+     */
+    void reset(size_t keyCount);
+
+    /**
+     * Empties the heap. Only the keys still in the heap are touched, so
+     * this is cheap after the heap has been popped dry.
+     */
+    void clear();
+
+    /**
+     * Inserts a key, or moves it to the given priority if it is
+     * already in the heap.
+     * @param key - the key to insert
+     * @param priority - the priority of the key
+     */
+    void push(Key key, const Priority& priority);
+
+    /**
+     * Inserts a key, or raises it to the given priority if it is already
+     * in the heap with a lower one. This is the relaxation step of
+     * Dijkstra's algorithm.
+     * @param key - the key to insert or update
+     * @param priority - the new priority of the key
+     * @return true if the key was inserted or its priority changed
+     */
+    bool decreaseKey(Key key, const Priority& priority);
+
+    /**
+     * Removes the key with the highest priority.
+     * The heap must not be empty.
+     * @return the removed key
+     */
+    Key pop();
+
+    /**
+     * Returns, but does not remove, the key with the highest priority.
+     * The heap must not be empty.
+     */
+    Key top() const;
+
+    /**
+     * Returns the priority of the key returned by top().
+     * The heap must not be empty.
+     */
+    const Priority& topPriority() const;
+
+    /**
+     * Checks whether a key is currently in the heap.
+     * @param key - the key to look for
+     */
+    bool contains(Key key) const;
+
+    /**
+     * Returns the priority of a key in the heap.
+     * The key must be in the heap.
+     * @param key - the key to look up
+     */
+    const Priority& priority(Key key) const;
+
+    /**
+     * Determines if the heap is empty.
+     */
+    bool empty() const;
+
+    /**
+     * Returns the number of keys in the heap.
+     */
+    size_t size() const;
+
+    /**
+     * Returns one past the largest key the heap can hold.
+     */
+    size_t keyCount() const;
+
+  private:
+    struct Entry
+    {
+        Key key;
+        Priority priority;
+    };
+
+    /**
+     * The heap array, rooted at index 0.
+     */
+    std::vector<Entry> entries;
+
+    /**
+     * For every key, its index in entries or NotInHeap.
+     */
+    std::vector<uint32_t> positions;
+
+    Compare higherPriority;
+
+    /**
+     * Moves the entry at idx towards the root until its parent comes first.
+     * @param idx - index of the entry in entries
+     */
+    void siftUp(size_t idx);
+
+    /**
+     * Moves the entry at idx away from the root until it comes before all
+     * of its children.
+     * @param idx - index of the entry in entries
+     */
+    void siftDown(size_t idx);
+};
+
+template <class Priority, unsigned Arity, class Compare>
+const uint32_t IndexedHeap<Priority, Arity, Compare>::NotInHeap;
+
+template <class Priority, unsigned Arity, class Compare>
+IndexedHeap<Priority, Arity, Compare>::IndexedHeap()
+{
+}
+
+template <class Priority, unsigned Arity, class Compare>
+IndexedHeap<Priority, Arity, Compare>::IndexedHeap(size_t keyCount) : positions(keyCount, NotInHeap)
+{
+}
+
+template <class Priority, unsigned Arity, class Compare>
+void IndexedHeap<Priority, Arity, Compare>::reset(size_t keyCount)
+{
+    clear();
+    positions.assign(keyCount, NotInHeap);
+}
+
+template <class Priority, unsigned Arity, class Compare>
+void IndexedHeap<Priority, Arity, Compare>::clear()
+{
+    for (const Entry& entry : entries)
+        positions[entry.key] = NotInHeap;
+    entries.clear();
+}
+
+template <class Priority, unsigned Arity, class Compare>
+void IndexedHeap<Priority, Arity, Compare>::push(Key key, const Priority& priority)
+{
+    uint32_t idx = positions[key];
+    if (idx == NotInHeap)
+    {
+        idx = static_cast<uint32_t>(entries.size());
+        entries.push_back(Entry{key, priority});
+        positions[key] = idx;
+        siftUp(idx);
+        return;
+    }
+
+    bool up = higherPriority(priority, entries[idx].priority);
+    entries[idx].priority = priority;
+    if (up)
+        siftUp(idx);
+    else
+        siftDown(idx);
+}
+
+template <class Priority, unsigned Arity, class Compare>
+bool IndexedHeap<Priority, Arity, Compare>::decreaseKey(Key key, const Priority& priority)
+{
+    uint32_t idx = positions[key];
+    if (idx == NotInHeap)
+    {
+        push(key, priority);
+        return true;
+    }
+    if (!higherPriority(priority, entries[idx].priority))
+        return false;
+    entries[idx].priority = priority;
+    siftUp(idx);
+    return true;
+}
+
+template <class Priority, unsigned Arity, class Compare>
+typename IndexedHeap<Priority, Arity, Compare>::Key IndexedHeap<Priority, Arity, Compare>::pop()
+{
+    Key key = entries[0].key;
+    positions[key] = NotInHeap;
+    if (entries.size() > 1)
+    {
+        entries[0] = entries.back();
+        positions[entries[0].key] = 0;
+        entries.pop_back();
+        siftDown(0);
+    }
+    else
+    {
+        entries.pop_back();
+    }
+    return key;
+}
+
+template <class Priority, unsigned Arity, class Compare>
+typename IndexedHeap<Priority, Arity, Compare>::Key IndexedHeap<Priority, Arity, Compare>::top() const
+{
+    return entries[0].key;
+}
+
+template <class Priority, unsigned Arity, class Compare>
+const Priority& IndexedHeap<Priority, Arity, Compare>::topPriority() const
+{
+    return entries[0].priority;
+}
+
+template <class Priority, unsigned Arity, class Compare>
+bool IndexedHeap<Priority, Arity, Compare>::contains(Key key) const
+{
+    return key < positions.size() && positions[key] != NotInHeap;
+}
+
+template <class Priority, unsigned Arity, class Compare>
+const Priority& IndexedHeap<Priority, Arity, Compare>::priority(Key key) const
+{
+    return entries[positions[key]].priority;
+}
+
+template <class Priority, unsigned Arity, class Compare>
+bool IndexedHeap<Priority, Arity, Compare>::empty() const
+{
+    return entries.empty();
+}
+
+template <class Priority, unsigned Arity, class Compare>
+size_t IndexedHeap<Priority, Arity, Compare>::size() const
+{
+    return entries.size();
+}
+
+template <class Priority, unsigned Arity, class Compare>
+size_t IndexedHeap<Priority, Arity, Compare>::keyCount() const
+{
+    return positions.size();
+}
+
+template <class Priority, unsigned Arity, class Compare>
+void IndexedHeap<Priority, Arity, Compare>::siftUp(size_t idx)
+{
+    // carry the entry up and write it once instead of swapping each level
+    Entry moving = entries[idx];
+    while (idx > 0)
+    {
+        size_t parent = (idx - 1) / Arity;
+        if (!higherPriority(moving.priority, entries[parent].priority))
+            break;
+        entries[idx] = entries[parent];
+        positions[entries[idx].key] = static_cast<uint32_t>(idx);
+        idx = parent;
+    }
+    entries[idx] = moving;
+    positions[moving.key] = static_cast<uint32_t>(idx);
+}
+
+template <class Priority, unsigned Arity, class Compare>
+void IndexedHeap<Priority, Arity, Compare>::siftDown(size_t idx)
+{
+    Entry moving = entries[idx];
+    size_t count = entries.size();
+    while (true)
+    {
+        size_t first = idx * Arity + 1;
+        if (first >= count)
+            break;
+        size_t last = std::min(first + Arity, count);
+        size_t best = first;
+        for (size_t child = first + 1; child < last; child++)
+        {
+            if (higherPriority(entries[child].priority, entries[best].priority))
+                best = child;
+        }
+        if (!higherPriority(entries[best].priority, moving.priority))
+            break;
+        entries[idx] = entries[best];
+        positions[entries[idx].key] = static_cast<uint32_t>(idx);
+        idx = best;
+    }
+    entries[idx] = moving;
+    positions[moving.key] = static_cast<uint32_t>(idx);
+}
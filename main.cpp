@@ -1,8 +1,10 @@
 #include "safecovid.h"
 #include <iostream>
 int main() {
-  std::cout << "Getting data....This may take a couple minutes." << std::endl;
-  safeCovid s ("data/edges.txt");
+  std::cout << "Getting data...." << std::endl;
+  // the graph is read from the snapshot when it matches the route file,
+  // so only the first run parses the CSV
+  safeCovid s ("data/edges.txt", person(), 0, "data/edges.txt.graph");
 
   std::cout << "Welcome to SAFECOVID, a patent-pending tool for safe international travel!" << std::endl;
 
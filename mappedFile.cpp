@@ -0,0 +1,125 @@
+#include "mappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Constructs a MappedFile with nothing mapped.
+ */
+MappedFile::MappedFile() : bytes(NULL), length(0), mapped(false)
+{
+}
+
+/**
+ * Maps the given file.
+ * @param filename - the file to map
+ */
+MappedFile::MappedFile(const std::string& filename) : bytes(NULL), length(0), mapped(false)
+{
+    open(filename);
+}
+
+/**
+ * Unmaps the file.
+ */
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+/**
+ * Maps a file, unmapping any previous one.
+ * @param filename - the file to map
+ * @return whether the file could be opened
+ */
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // an empty file cannot be mapped, but it is still a valid (empty) file
+    if (info.st_size > 0)
+    {
+        void* region = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (region == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+        madvise(region, info.st_size, MADV_SEQUENTIAL);
+        bytes = static_cast<const char*>(region);
+        length = info.st_size;
+    }
+    ::close(fd);
+    mapped = true;
+    return true;
+}
+
+/**
+ * Unmaps the file. Pointers into it handed out before are no longer valid.
+ */
+void MappedFile::close()
+{
+    if (bytes != NULL)
+        munmap(const_cast<char*>(bytes), length);
+    bytes = NULL;
+    length = 0;
+    mapped = false;
+}
+
+/**
+ * Returns whether a file is open.
+ */
+bool MappedFile::isOpen() const
+{
+    return mapped;
+}
+
+/**
+ * Returns the first byte of the file.
+ */
+const char* MappedFile::data() const
+{
+    return bytes;
+}
+
+/**
+ * Returns the size of the file in bytes.
+ */
+size_t MappedFile::size() const
+{
+    return length;
+}
+
+/**
+ * Computes a 64-bit FNV-1a hash of the file contents, used to tell
+ * whether a file changed since something was derived from it.
+ * @return the hash, or 0 if no file is open
+ */
+uint64_t MappedFile::fingerprint() const
+{
+    if (!mapped)
+        return 0;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= static_cast<unsigned char>(bytes[i]);
+        hash *= 1099511628211ULL;
+    }
+    // fold in the length so truncations never collide with the original
+    hash ^= length;
+    hash *= 1099511628211ULL;
+    return hash;
+}
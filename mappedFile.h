@@ -0,0 +1,75 @@
+/**
+ * @file mappedFile.h
+ * Read-only memory mapping of a whole file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Maps a file into memory read-only. Used for the route files and for
+ * binary graph snapshots, which are both read straight out of the mapping.
+ */
+class MappedFile
+{
+  public:
+    /**
+     * Constructs a MappedFile with nothing mapped.
+     */
+    MappedFile();
+
+    /**
+     * Maps the given file.
+     * @param filename - the file to map
+     */
+    MappedFile(const std::string& filename);
+
+    /**
+     * Unmaps the file.
+     */
+    ~MappedFile();
+
+    /**
+     * Maps a file, unmapping any previous one.
+     * @param filename - the file to map
+     * @return whether the file could be opened
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * Unmaps the file. Pointers into it handed out before are no longer valid.
+     */
+    void close();
+
+    /**
+     * Returns whether a file is open.
+     */
+    bool isOpen() const;
+
+    /**
+     * Returns the first byte of the file.
+     */
+    const char* data() const;
+
+    /**
+     * Returns the size of the file in bytes.
+     */
+    size_t size() const;
+
+    /**
+     * Computes a 64-bit FNV-1a hash of the file contents, used to tell
+     * whether a file changed since something was derived from it.
+     * @return the hash, or 0 if no file is open
+     */
+    uint64_t fingerprint() const;
+
+  private:
+    MappedFile(const MappedFile& other);
+    MappedFile& operator=(const MappedFile& other);
+
+    const char* bytes;
+    size_t length;
+    bool mapped;
+};
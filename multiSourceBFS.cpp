@@ -0,0 +1,126 @@
+#include "multiSourceBFS.h"
+#include "parallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+const size_t MultiSourceBFS::Width = 64;
+const uint8_t MultiSourceBFS::Unreached = UINT8_MAX;
+const unsigned MultiSourceBFS::MaxHops = UINT8_MAX - 1;
+
+/**
+ * Constructs an engine with no graph.
+ */
+MultiSourceBFS::MultiSourceBFS()
+{
+}
+
+/**
+ * Prepares to search a graph.
+ * @param g - the graph to search; it is copied
+ */
+MultiSourceBFS::MultiSourceBFS(const CSRGraph& g) : graph(g)
+{
+}
+
+/**
+ * Finds the fewest edges from each of several sources to every vertex.
+ * @param sources - IDs of the vertices to start from, at most Width
+ * @param count - how many sources there are
+ * @param rows - filled with count rows of vertexCount bytes; entry
+ *               rows[i * vertexCount + v] is the number of edges from
+ *               sources[i] to v, or Unreached
+ * @return - false if some vertex is more than MaxHops edges from a
+ *           source, or a source is not a vertex
+ */
+bool MultiSourceBFS::run(const VertexId* sources, size_t count, uint8_t* rows)
+{
+    return search(sources, count, rows, lanes);
+}
+
+/**
+ * Finds the fewest edges between every pair of vertices, Width sources
+ * per traversal, spreading the traversals over several threads.
+ * @param matrix - filled with vertexCount rows of vertexCount bytes;
+ *                 entry matrix[s * vertexCount + v] is the number of
+ *                 edges from s to v, or Unreached
+ * @param threads - how many threads to use, 0 for one per core
+ * @return - false if some vertex is more than MaxHops edges from another
+ */
+bool MultiSourceBFS::allPairs(std::vector<uint8_t>& matrix, unsigned threads) const
+{
+    size_t count = graph.vertexCount();
+    matrix.assign(count * count, Unreached);
+    std::vector<VertexId> sources(count);
+    for (VertexId v = 0; v < count; v++)
+        sources[v] = v;
+
+    size_t batches = (count + Width - 1) / Width;
+    // batches are handed out one at a time, since their costs differ
+    std::atomic<bool> ok(true);
+    parallelFor(batches, threads, Lanes(), [&](size_t b, Lanes& state) {
+        size_t first = b * Width;
+        size_t width = std::min(Width, count - first);
+        if (!search(&sources[first], width, &matrix[first * count], state))
+            ok = false;
+    });
+    return ok;
+}
+
+/**
+ * The traversal behind run and allPairs, using the given words so that
+ * threads can each bring their own.
+ */
+bool MultiSourceBFS::search(const VertexId* sources, size_t count, uint8_t* rows, Lanes& state) const
+{
+    size_t vertices = graph.vertexCount();
+    if (count > Width)
+        return false;
+    memset(rows, Unreached, count * vertices);
+    state.seen.assign(vertices, 0);
+    state.frontier.assign(vertices, 0);
+    state.next.assign(vertices, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (sources[i] >= vertices)
+            return false;
+        state.seen[sources[i]] |= uint64_t(1) << i;
+        state.frontier[sources[i]] |= uint64_t(1) << i;
+        rows[i * vertices + sources[i]] = 0;
+    }
+
+    for (unsigned depth = 1;; depth++)
+    {
+        for (VertexId u = 0; u < vertices; u++)
+        {
+            uint64_t bits = state.frontier[u];
+            if (bits == 0)
+                continue;
+            for (uint32_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++)
+                state.next[graph.target(e)] |= bits;
+        }
+
+        bool grew = false;
+        for (VertexId v = 0; v < vertices; v++)
+        {
+            uint64_t fresh = state.next[v] & ~state.seen[v];
+            state.next[v] = 0;
+            state.frontier[v] = fresh;
+            if (fresh == 0)
+                continue;
+            if (depth > MaxHops)
+                return false;
+            grew = true;
+            state.seen[v] |= fresh;
+            while (fresh != 0)
+            {
+                unsigned i = __builtin_ctzll(fresh);
+                fresh &= fresh - 1;
+                rows[i * vertices + v] = static_cast<uint8_t>(depth);
+            }
+        }
+        if (!grew)
+            return true;
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * @file multiSourceBFS.h
+ * Fewest-hop distances from many airports at once, one bit per search.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "csrGraph.h"
+
+/**
+ * Runs up to Width breadth-first searches in one traversal of the graph.
+ *
+ * Every vertex keeps a machine word of seen bits and one of frontier bits,
+ * bit i belonging to the search from the i-th source. Expanding a level
+ * ORs each frontier word into the next-level words of the vertex's
+ * out-neighbors, and a neighbor joins search i's next frontier if bit i
+ * is set there and not yet seen. The searches share every edge scan, so
+ * 64 of them cost about as much as one whenever their frontiers overlap,
+ * which on the airport network (a few hubs, short paths) is nearly always.
+ *
+ * Distances are stored one byte each, which is enough for any network
+ * whose routes need at most MaxHops flights; the longest fewest-flight
+ * route in the OpenFlights data takes 14.
+ */
+class MultiSourceBFS
+{
+  public:
+    /**
+     * Constructs an engine with no graph.
+     */
+    MultiSourceBFS();
+
+    /**
+     * Prepares to search a graph.
+     * @param g - the graph to search; it is copied
+     */
+    MultiSourceBFS(const CSRGraph& g);
+
+    /**
+     * Finds the fewest edges from each of several sources to every vertex.
+     * @param sources - IDs of the vertices to start from, at most Width
+     * @param count - how many sources there are
+     * @param rows - filled with count rows of vertexCount bytes; entry
+     *               rows[i * vertexCount + v] is the number of edges from
+     *               sources[i] to v, or Unreached
+     * @return - false if some vertex is more than MaxHops edges from a
+     *           source, or a source is not a vertex
+     */
+    bool run(const VertexId* sources, size_t count, uint8_t* rows);
+
+    /**
+     * Finds the fewest edges between every pair of vertices, Width sources
+     * per traversal, spreading the traversals over several threads.
+     * @param matrix - filled with vertexCount rows of vertexCount bytes;
+     *                 entry matrix[s * vertexCount + v] is the number of
+     *                 edges from s to v, or Unreached
+     * @param threads - how many threads to use, 0 for one per core
+     * @return - false if some vertex is more than MaxHops edges from another
+     */
+    bool allPairs(std::vector<uint8_t>& matrix, unsigned threads = 0) const;
+
+    /** Number of searches one traversal runs, one per bit of a word. */
+    const static size_t Width;
+
+    /** Entry for a vertex that cannot be reached. */
+    const static uint8_t Unreached;
+
+    /** Largest distance an entry can hold. */
+    const static unsigned MaxHops;
+
+  private:
+    /**
+     * Per-vertex words for one traversal, indexed by vertex ID.
+     */
+    struct Lanes
+    {
+        std::vector<uint64_t> seen;
+        std::vector<uint64_t> frontier;
+        std::vector<uint64_t> next;
+    };
+
+    CSRGraph graph;
+    Lanes lanes;
+
+    /**
+     * The traversal behind run and allPairs, using the given words so that
+     * threads can each bring their own.
+     */
+    bool search(const VertexId* sources, size_t count, uint8_t* rows, Lanes& state) const;
+};
@@ -0,0 +1,64 @@
+/**
+ * @file parallelFor.h
+ * Spreads independent pieces of work over a few threads.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * Turns a requested number of threads into the number to run with.
+ * @param threads - the number asked for, 0 for one per core
+ * @return - threads, or the number of cores if it is 0, and at least 1
+ */
+inline unsigned resolveThreads(unsigned threads)
+{
+    if (threads != 0)
+        return threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Calls work(i, state) for i from 0 to count - 1, handing the indices out
+ * one at a time, so pieces of uneven cost still balance, to several
+ * threads that each work on their own copy of a state. The calling
+ * thread is one of them, and no thread is started for a single one.
+ * @param count - number of pieces
+ * @param threads - most threads to use, 0 for one per core
+ * @param prototype - the state each thread copies
+ * @param work - callable taking the index and the thread's State&
+ */
+template <typename State, typename Work>
+void parallelFor(size_t count, unsigned threads, const State& prototype, const Work& work)
+{
+    threads = static_cast<unsigned>(std::min<size_t>(resolveThreads(threads), count));
+    std::atomic<size_t> next(0);
+    auto run = [&]() {
+        State state(prototype);
+        for (size_t i = next++; i < count; i = next++)
+            work(i, state);
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; i++)
+        workers.push_back(std::thread(run));
+    run();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+/**
+ * Same as above for work without a state of its own: calls work(i).
+ */
+template <typename Work>
+void parallelFor(size_t count, unsigned threads, const Work& work)
+{
+    struct NoState
+    {
+    };
+    parallelFor(count, threads, NoState(), [&work](size_t i, NoState&) { work(i); });
+}
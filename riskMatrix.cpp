@@ -0,0 +1,240 @@
+#include "riskMatrix.h"
+#include "parallelFor.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+const size_t RiskMatrix::BlockSize = 64;
+const float RiskMatrix::Unreachable = std::numeric_limits<float>::infinity();
+
+namespace
+{
+
+// BlockSize, known at compile time so that the row loops unroll
+const size_t kBlock = 64;
+
+#if defined(__AVX__)
+typedef __m256 Lanes;
+const size_t kLanes = 8;
+inline Lanes splat(float x) { return _mm256_set1_ps(x); }
+inline Lanes load(const float* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, Lanes x) { _mm256_storeu_ps(p, x); }
+inline Lanes minPlus(Lanes c, Lanes a, const float* b) { return _mm256_min_ps(c, _mm256_add_ps(a, _mm256_loadu_ps(b))); }
+#elif defined(__SSE__)
+typedef __m128 Lanes;
+const size_t kLanes = 4;
+inline Lanes splat(float x) { return _mm_set1_ps(x); }
+inline Lanes load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, Lanes x) { _mm_storeu_ps(p, x); }
+inline Lanes minPlus(Lanes c, Lanes a, const float* b) { return _mm_min_ps(c, _mm_add_ps(a, _mm_loadu_ps(b))); }
+#else
+typedef float Lanes;
+const size_t kLanes = 1;
+inline Lanes splat(float x) { return x; }
+inline Lanes load(const float* p) { return *p; }
+inline void store(float* p, Lanes x) { *p = x; }
+inline Lanes minPlus(Lanes c, Lanes a, const float* b) { return std::min(c, a + *b); }
+#endif
+
+/**
+ * Relaxes a tile through every k of one block,
+ * c[i][j] = min(c[i][j], a[i][k] + b[k][j]), with k outermost so that c
+ * may be the same tile as a or b.
+ */
+void relaxDependent(float* c, const float* a, const float* b, size_t stride)
+{
+    for (size_t k = 0; k < kBlock; k++)
+    {
+        const float* out = b + k * stride;
+        for (size_t i = 0; i < kBlock; i++)
+        {
+            float through = a[i * stride + k];
+            if (through == RiskMatrix::Unreachable)
+                continue;
+            Lanes into = splat(through);
+            float* row = c + i * stride;
+            for (size_t j = 0; j < kBlock; j += kLanes)
+                store(row + j, minPlus(load(row + j), into, out + j));
+        }
+    }
+}
+
+/**
+ * Relaxes a tile through every k of one block when c is neither a nor b.
+ * Four registers of a row of c are held while k runs over the block, so
+ * the inner loop only loads from b.
+ */
+void relaxIndependent(float* c, const float* a, const float* b, size_t stride)
+{
+    for (size_t i = 0; i < kBlock; i++)
+    {
+        float* row = c + i * stride;
+        const float* into = a + i * stride;
+        for (size_t j = 0; j < kBlock; j += 4 * kLanes)
+        {
+            Lanes c0 = load(row + j);
+            Lanes c1 = load(row + j + kLanes);
+            Lanes c2 = load(row + j + 2 * kLanes);
+            Lanes c3 = load(row + j + 3 * kLanes);
+            for (size_t k = 0; k < kBlock; k++)
+            {
+                if (into[k] == RiskMatrix::Unreachable)
+                    continue;
+                Lanes through = splat(into[k]);
+                const float* out = b + k * stride + j;
+                c0 = minPlus(c0, through, out);
+                c1 = minPlus(c1, through, out + kLanes);
+                c2 = minPlus(c2, through, out + 2 * kLanes);
+                c3 = minPlus(c3, through, out + 3 * kLanes);
+            }
+            store(row + j, c0);
+            store(row + j + kLanes, c1);
+            store(row + j + 2 * kLanes, c2);
+            store(row + j + 3 * kLanes, c3);
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * Constructs an empty matrix.
+ */
+RiskMatrix::RiskMatrix() : vertices(0), stride(0), negativeCycle(false)
+{
+}
+
+/**
+ * Fills the matrix for a graph.
+ * @param g - the graph to measure
+ * @param threads - how many threads to use, 0 for one per core
+ */
+RiskMatrix::RiskMatrix(const CSRGraph& g, unsigned threads)
+    : vertices(g.vertexCount()), stride((vertices + BlockSize - 1) / BlockSize * BlockSize), negativeCycle(false),
+      matrix(stride * stride, Unreachable)
+{
+    for (VertexId u = 0; u < vertices; u++)
+    {
+        float* row = &matrix[u * stride];
+        row[u] = 0;
+        for (uint32_t e = g.edgeBegin(u); e < g.edgeEnd(u); e++)
+            row[g.target(e)] = std::min(row[g.target(e)], static_cast<float>(g.weight(e)));
+    }
+
+    if (!close(threads))
+    {
+        negativeCycle = true;
+        matrix.clear();
+    }
+}
+
+/**
+ * Whether the matrix holds the least risks of some graph, which is
+ * false if nothing was built or the graph has a negative cycle.
+ */
+bool RiskMatrix::usable() const
+{
+    return !matrix.empty();
+}
+
+/**
+ * Whether the graph the matrix was built for has a cycle of negative
+ * total weight, in which case no least risk exists.
+ */
+bool RiskMatrix::hasNegativeCycle() const
+{
+    return negativeCycle;
+}
+
+/**
+ * Returns the least total weight of a path from one vertex to another.
+ * @param source - ID of the vertex to start from
+ * @param destination - ID of the vertex to reach
+ * @return - the weight, or Unreachable if there is no path, either ID
+ *           is not a vertex or the matrix is not usable
+ */
+float RiskMatrix::risk(VertexId source, VertexId destination) const
+{
+    if (!usable() || source >= vertices || destination >= vertices)
+        return Unreachable;
+    return matrix[source * stride + destination];
+}
+
+/**
+ * Returns how many vertices the matrix covers.
+ */
+size_t RiskMatrix::vertexCount() const
+{
+    return vertices;
+}
+
+/**
+ * Returns the bytes taken by the matrix, padding included.
+ */
+size_t RiskMatrix::bytes() const
+{
+    return matrix.size() * sizeof(float);
+}
+
+/**
+ * Runs every round of the blocked Floyd-Warshall over the matrix.
+ * @return - false if a negative cycle was found
+ */
+bool RiskMatrix::close(unsigned threads)
+{
+    size_t blocks = stride / BlockSize;
+    for (size_t round = 0; round < blocks; round++)
+    {
+        float* pivot = tile(round, round);
+        relaxDependent(pivot, pivot, pivot, stride);
+        // a negative cycle through these vertices; stop before the
+        // entries run off towards minus infinity
+        for (size_t i = 0; i < BlockSize; i++)
+            if (pivot[i * stride + i] < 0)
+                return false;
+
+        // the tiles in the pivot's row and column only depend on the pivot
+        parallelFor(2 * blocks, threads, [&](size_t task) {
+            size_t other = task / 2;
+            if (other == round)
+                return;
+            if (task % 2 == 0)
+            {
+                float* c = tile(round, other);
+                relaxDependent(c, pivot, c, stride);
+            }
+            else
+            {
+                float* c = tile(other, round);
+                relaxDependent(c, c, pivot, stride);
+            }
+        });
+
+        // every other tile depends only on those, one block row per task
+        parallelFor(blocks, threads, [&](size_t row) {
+            if (row == round)
+                return;
+            const float* into = tile(row, round);
+            for (size_t column = 0; column < blocks; column++)
+                if (column != round)
+                    relaxIndependent(tile(row, column), into, tile(round, column), stride);
+        });
+    }
+
+    for (size_t v = 0; v < vertices; v++)
+        if (matrix[v * stride + v] < 0)
+            return false;
+    return true;
+}
+
+/**
+ * Returns the first float of the tile in the given block row and column.
+ */
+float* RiskMatrix::tile(size_t row, size_t column)
+{
+    return &matrix[(row * stride + column) * BlockSize];
+}
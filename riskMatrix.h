@@ -0,0 +1,103 @@
+/**
+ * @file riskMatrix.h
+ * Least total risk between every pair of airports, by blocked Floyd-Warshall.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "csrGraph.h"
+
+/**
+ * Stores the least total edge weight from every vertex to every other, as
+ * a float, for drawing risk heatmaps over the whole network.
+ *
+ * The matrix is filled by Floyd-Warshall in min-plus form: for every k,
+ * d[i][j] = min(d[i][j], d[i][k] + d[k][j]). Unlike the single-pair
+ * engines it needs no feasible potential, so the negative weights that
+ * initializeWeights gives edges into sinks are fine as they are. A
+ * negative cycle shows up as a negative entry on the diagonal, and the
+ * build stops as soon as it sees one.
+ *
+ * The rows are padded to a multiple of BlockSize and the relaxations run
+ * on BlockSize x BlockSize tiles, so the three tiles an update reads stay
+ * in cache. Each round of k first closes the diagonal tile, then the tiles
+ * in its row and column, then every other tile; the tiles of the last two
+ * steps do not depend on each other and are spread over several threads.
+ * The innermost loop is a min of sums over one contiguous tile row, done
+ * with SSE or AVX when the compiler targets them.
+ *
+ * A full matrix for the 3425 OpenFlights airports takes about 48 MB and
+ * some 80 billion floating-point operations to build.
+ */
+class RiskMatrix
+{
+  public:
+    /**
+     * Constructs an empty matrix.
+     */
+    RiskMatrix();
+
+    /**
+     * Fills the matrix for a graph.
+     * @param g - the graph to measure
+     * @param threads - how many threads to use, 0 for one per core
+     */
+    RiskMatrix(const CSRGraph& g, unsigned threads = 0);
+
+    /**
+     * Whether the matrix holds the least risks of some graph, which is
+     * false if nothing was built or the graph has a negative cycle.
+     */
+    bool usable() const;
+
+    /**
+     * Whether the graph the matrix was built for has a cycle of negative
+     * total weight, in which case no least risk exists.
+     */
+    bool hasNegativeCycle() const;
+
+    /**
+     * Returns the least total weight of a path from one vertex to another.
+     * @param source - ID of the vertex to start from
+     * @param destination - ID of the vertex to reach
+     * @return - the weight, or Unreachable if there is no path, either ID
+     *           is not a vertex or the matrix is not usable
+     */
+    float risk(VertexId source, VertexId destination) const;
+
+    /**
+     * Returns how many vertices the matrix covers.
+     */
+    size_t vertexCount() const;
+
+    /**
+     * Returns the bytes taken by the matrix, padding included.
+     */
+    size_t bytes() const;
+
+    /** Width and height of the tiles the relaxations run on. */
+    const static size_t BlockSize;
+
+    /** risk result for a vertex that cannot be reached. */
+    const static float Unreachable;
+
+  private:
+    size_t vertices;
+    size_t stride; /**< Floats per row, vertices rounded up to BlockSize **/
+    bool negativeCycle;
+    std::vector<float> matrix; /**< Least weight from s to v at [s * stride + v] **/
+
+    /**
+     * Runs every round of the blocked Floyd-Warshall over the matrix.
+     * @return - false if a negative cycle was found
+     */
+    bool close(unsigned threads);
+
+    /**
+     * Returns the first float of the tile in the given block row and column.
+     */
+    float* tile(size_t row, size_t column);
+};
@@ -0,0 +1,43 @@
+#include "routeFile.h"
+
+/**
+ * Constructs a RouteFile with nothing mapped.
+ */
+RouteFile::RouteFile()
+{
+}
+
+/**
+ * Maps the given file.
+ * @param filename - the route file to map
+ */
+RouteFile::RouteFile(const std::string& filename) : MappedFile(filename)
+{
+}
+
+/**
+ * Splits the file into at most the given number of chunks of similar
+ * size. Every chunk starts at the beginning of a row.
+ * @param chunks - the number of chunks wanted
+ * @return chunk boundaries; chunk i is [result[i], result[i + 1])
+ */
+std::vector<const char*> RouteFile::splitRows(unsigned chunks) const
+{
+    const char* bytes = data();
+    size_t length = size();
+    const char* end = bytes + length;
+    std::vector<const char*> bounds;
+    bounds.push_back(bytes);
+    for (unsigned i = 1; i < chunks; i++)
+    {
+        const char* cut = bytes + length / chunks * i;
+        if (cut <= bounds.back())
+            continue;
+        const char* newline = static_cast<const char*>(memchr(cut, '\n', end - cut));
+        if (newline == NULL)
+            break;
+        bounds.push_back(newline + 1);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file routeFile.h
+ * Memory-mapped reader for OpenFlights route files.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mappedFile.h"
+#include "parallelFor.h"
+
+/**
+ * A non-owning view of a run of characters inside a RouteFile.
+ * Only valid while the RouteFile it came from is open.
+ */
+struct Field
+{
+    const char* data; /**< First character of the field **/
+    size_t size; /**< Number of characters in the field **/
+
+    /**
+     * Copies the field into a string.
+     */
+    std::string str() const
+    {
+        return std::string(data, size);
+    }
+};
+
+/**
+ * Maps a route file into memory and walks its rows without copying them.
+ *
+ * Each row of an OpenFlights route file looks like
+ *   airline,airline ID,source,source ID,destination,destination ID,codeshare,stops,equipment
+ * and only the source and destination IATA codes are used by SAFECOVID.
+ */
+class RouteFile : public MappedFile
+{
+  public:
+    /**
+     * Constructs a RouteFile with nothing mapped.
+     */
+    RouteFile();
+
+    /**
+     * Maps the given file.
+     * @param filename - the route file to map
+     */
+    RouteFile(const std::string& filename);
+
+    /**
+     * Calls visit(source, destination) with the IATA code fields of every
+     * route row. Rows with fewer than five fields are skipped.
+     * @param visit - callable taking two Fields
+     * @return the number of rows visited
+     */
+    template <class Visitor>
+    size_t forEachRoute(Visitor visit) const;
+
+    /**
+     * Same as forEachRoute, but only for the rows inside [begin, end).
+     * begin should point at the start of a row.
+     * @param begin - first byte to look at
+     * @param end - one past the last byte to look at
+     * @param visit - callable taking two Fields
+     * @return the number of rows visited
+     */
+    template <class Visitor>
+    static size_t forEachRoute(const char* begin, const char* end, Visitor visit);
+
+    /**
+     * Same as forEachRoute, but the file is split at row boundaries into
+     * one chunk per thread and the chunks are parsed concurrently into
+     * per-thread buffers. visit is then called on the calling thread in
+     * file order, so the result does not depend on the thread count.
+     * @param threads - number of threads to parse with; 0 uses one per core
+     * @param visit - callable taking two Fields
+     * @return the number of rows visited
+     */
+    template <class Visitor>
+    size_t forEachRouteParallel(unsigned threads, Visitor visit) const;
+
+    /**
+     * Same as forEachRoute, but the file is split at row boundaries into
+     * one chunk per thread and every chunk is visited on its own thread
+     * with its own state: chunks is resized to the number of chunks and
+     * visit(chunks[i], source, destination) is called for the rows of
+     * chunk i in file order. Chunks are numbered in file order too, so
+     * merging the states by index gives a result that does not depend on
+     * the thread count.
+     * @param threads - number of threads to parse with; 0 uses one per core
+     * @param chunks - filled with one default-constructed State per chunk
+     * @param visit - callable taking a State& and two Fields
+     * @return the number of rows visited
+     */
+    template <class State, class Visitor>
+    size_t forEachRouteParallel(unsigned threads, std::vector<State>& chunks, Visitor visit) const;
+
+    /**
+     * Splits the file into at most the given number of chunks of similar
+     * size. Every chunk starts at the beginning of a row.
+     * @param chunks - the number of chunks wanted
+     * @return chunk boundaries; chunk i is [result[i], result[i + 1])
+     */
+    std::vector<const char*> splitRows(unsigned chunks) const;
+};
+
+template <class Visitor>
+size_t RouteFile::forEachRoute(Visitor visit) const
+{
+    return forEachRoute(data(), data() + size(), visit);
+}
+
+template <class Visitor>
+size_t RouteFile::forEachRoute(const char* begin, const char* end, Visitor visit)
+{
+    size_t rows = 0;
+    const char* line = begin;
+    while (line < end)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (lineEnd == NULL)
+            lineEnd = end;
+
+        // fields 2 and 4 of the row are the source and destination codes
+        Field fields[5];
+        int found = 0;
+        const char* fieldStart = line;
+        while (found < 5)
+        {
+            const char* comma = static_cast<const char*>(memchr(fieldStart, ',', lineEnd - fieldStart));
+            const char* fieldEnd = (comma == NULL) ? lineEnd : comma;
+            if (fieldEnd > fieldStart && fieldEnd[-1] == '\r')
+                fieldEnd--;
+            fields[found].data = fieldStart;
+            fields[found].size = fieldEnd - fieldStart;
+            found++;
+            if (comma == NULL)
+                break;
+            fieldStart = comma + 1;
+        }
+
+        if (found == 5)
+        {
+            visit(fields[2], fields[4]);
+            rows++;
+        }
+        line = lineEnd + 1;
+    }
+    return rows;
+}
+
+template <class Visitor>
+size_t RouteFile::forEachRouteParallel(unsigned threads, Visitor visit) const
+{
+    if (resolveThreads(threads) == 1)
+        return forEachRoute(visit);
+
+    typedef std::vector<std::pair<Field, Field>> Routes;
+    std::vector<Routes> parsed;
+    size_t rows = forEachRouteParallel(threads, parsed, [](Routes& local, const Field& source, const Field& dest) {
+        local.push_back(std::make_pair(source, dest));
+    });
+    for (const Routes& local : parsed)
+        for (const std::pair<Field, Field>& route : local)
+            visit(route.first, route.second);
+    return rows;
+}
+
+template <class State, class Visitor>
+size_t RouteFile::forEachRouteParallel(unsigned threads, std::vector<State>& chunks, Visitor visit) const
+{
+    std::vector<const char*> bounds = splitRows(resolveThreads(threads));
+    chunks.clear();
+    chunks.resize(bounds.size() - 1);
+    std::vector<size_t> rows(chunks.size(), 0);
+    // one thread per chunk
+    parallelFor(chunks.size(), static_cast<unsigned>(chunks.size()), [&](size_t i) {
+        State& local = chunks[i];
+        rows[i] = forEachRoute(bounds[i], bounds[i + 1], [&local, &visit](const Field& source, const Field& dest) {
+            visit(local, source, dest);
+        });
+    });
+
+    size_t total = 0;
+    for (size_t count : rows)
+        total += count;
+    return total;
+}
@@ -1,12 +1,13 @@
 #include "safecovid.h"
+#include "graphBuilder.h"
+#include "routeFile.h"
+#include "graphSnapshot.h"
 
 #include <algorithm>
 #include <iostream>
-#include <fstream>
 #include <queue>
 #include <limits>
 
-using std::ifstream;
 using std::string;
 using std::vector;
 
@@ -15,25 +16,99 @@ using std::vector;
 * This will use a default Person instead of user-provided information
 * @param filename the name of the input file to establish vertices/edges
 */
-safeCovid::safeCovid(const std::string &filename) : airportGraph(true, true), dijkstraGraph(true, true)
+safeCovid::safeCovid(const std::string &filename) : airportGraph(true, true)
 {
   // initialize weighted and directed graph
-    initializeVertices(filename);
-    initializeEdges(filename);
-    initializeLabels();
+    loadGraph(filename);
+    freezeNetwork();
+}
+
+/**
+* Constructor that takes in a file to initialize graph
+* This will use custom Person generated by having a provided age
+* @param filename - Name of the input file to establish vertices/edges
+*/
+safeCovid::safeCovid(const std::string& filename, person pers) : airportGraph(true, true), person_(pers)
+{
+    loadGraph(filename);
+    freezeNetwork();
 }
 
 /**
 * Constructor that takes in a file to initialize graph
 * This will use custom Person generated by having a provided age
 * @param filename - Name of the input file to establish vertices/edges
+* @param loadThreads - Number of threads used to parse the file, 0 for one per core
+*/
+safeCovid::safeCovid(const std::string& filename, person pers, unsigned loadThreads) : airportGraph(true, true),
+                                                                  person_(pers)
+{
+    loadGraph(filename, loadThreads);
+    freezeNetwork();
+}
+
+/**
+* Constructor that takes in a file to initialize graph and keeps a
+* binary snapshot of it at the given path, see loadGraph
+* @param filename - Name of the input file to establish vertices/edges
+* @param loadThreads - Number of threads used to parse the file, 0 for one per core
+* @param snapshot - Path of the snapshot to load from or write to
 */
-safeCovid::safeCovid(const std::string& filename, person pers) : airportGraph(true, true), person_(pers),
-                                                                  dijkstraGraph(true, true)
+safeCovid::safeCovid(const std::string& filename, person pers, unsigned loadThreads, const std::string& snapshot)
+    : airportGraph(true, true), person_(pers)
 {
-    initializeVertices(filename);
-    initializeEdges(filename);
+    loadGraph(filename, loadThreads, snapshot);
+    freezeNetwork();
+}
+
+/**
+* Loads the airport graph for a route file. Snapshots are opt-in:
+* when a snapshot path is given, the graph is read from it if its
+* fingerprint matches the route file's contents, and otherwise built
+* from the route file and written there.
+* @param filename - Name of the input file to establish vertices/edges
+* @param threads - Number of threads used to parse the file, 0 for one per core
+* @param snapshot - Path of the snapshot to use, empty for none
+*/
+void safeCovid::loadGraph(const std::string& filename, unsigned threads, const std::string& snapshot) {
+    RouteFile routes(filename);
+    // the fingerprint comes from the same mapping the graph is built from
+    uint64_t fingerprint = snapshot.empty() ? 0 : routes.fingerprint();
+    if (fingerprint != 0 && GraphSnapshot::load(airportGraph, snapshot, fingerprint))
+        return;
+
+    initializeGraph(routes, threads);
     initializeLabels();
+    if (fingerprint != 0)
+        GraphSnapshot::save(airportGraph, snapshot, fingerprint);
+}
+
+/**
+* Generates all vertices and edges based on airport data.
+* The route file is memory-mapped and split into chunks; every thread
+* copies and interns the codes of its own chunk, and the chunks are
+* merged into the graph in file order.
+* @param filename - Name of the input file to establish vertices/edges
+* @param threads - Number of threads used to parse the file, 0 for one per core
+*/
+void safeCovid::initializeGraph(const std::string& filename, unsigned threads) {
+    initializeGraph(RouteFile(filename), threads);
+}
+
+/**
+* Generates all vertices and edges from a route file that is already mapped.
+* @param routes - the mapped route file
+* @param threads - Number of threads used to parse the file, 0 for one per core
+*/
+void safeCovid::initializeGraph(const RouteFile& routes, unsigned threads) {
+    std::vector<GraphBuilder> chunks;
+    routes.forEachRouteParallel(threads, chunks, [](GraphBuilder& chunk, const Field& source, const Field& dest) {
+        chunk.addEdge(source.str(), dest.str());
+    });
+    GraphBuilder builder;
+    for (const GraphBuilder& chunk : chunks)
+        builder.append(chunk);
+    builder.build(airportGraph);
 }
 
 /**
@@ -41,37 +116,13 @@ safeCovid::safeCovid(const std::string& filename, person pers) : airportGraph(tr
 * @param filename - Name of the input file to establish vertices/edges
 */
 void safeCovid::initializeVertices(const std::string& filename) {
-    ifstream edgesFile(filename);
-    string line;
-    //insert vertices
-    if (edgesFile.is_open())
-    {
-        int count = 0;
-        while (getline(edgesFile, line))
-        {
-            count++;
-            vector<string> words;
-
-            string delim = ",";
-            size_t pos = 0;
-            string word;
-            while (true) // get the words from line and push to vector
-            {
-                pos = line.find(delim);
-                if (pos == std::string::npos)
-                {
-                    words.push_back(line);
-                    break;
-                }
-                word = line.substr(0, pos);
-                line = line.substr(pos + 1);
-                words.push_back(word);
-            }
-            // Add vertices to the graph
-            airportGraph.insertVertex(words[2]);
-            airportGraph.insertVertex(words[4]);
-        }
-    }
+    RouteFile routes(filename);
+    GraphBuilder builder;
+    routes.forEachRoute([&builder](const Field& source, const Field& dest) {
+        builder.addVertex(source.str());
+        builder.addVertex(dest.str());
+    });
+    builder.build(airportGraph);
 }
 
 /**
@@ -79,37 +130,12 @@ void safeCovid::initializeVertices(const std::string& filename) {
 * @param filename - Name of the input file to establish vertices/edges
 */
 void safeCovid::initializeEdges(const std::string& filename) {
-    // insert edges
-    ifstream edgesFile1(filename);
-    string line1;
-
-    if (edgesFile1.is_open())
-    {
-        int count = 0;
-        while (getline(edgesFile1, line1))
-        {
-            count++;
-            vector<string> words;
-
-            string delim = ",";
-            size_t pos = 0;
-            string word;
-            while (true) // get the words from line and push to vector
-            {
-                pos = line1.find(delim);
-                if (pos == std::string::npos)
-                {
-                    words.push_back(line1);
-                    break;
-                }
-                word = line1.substr(0, pos);
-                line1 = line1.substr(pos + 1);
-                words.push_back(word);
-            }
-            // Add vertices to the graph
-            airportGraph.insertEdge(words[2], words[4]);
-        }
-    }
+    RouteFile routes(filename);
+    GraphBuilder builder;
+    routes.forEachRoute([&builder](const Field& source, const Field& dest) {
+        builder.addEdge(source.str(), dest.str());
+    });
+    builder.build(airportGraph);
 }
 
 /**
@@ -131,20 +157,68 @@ void safeCovid::initializeLabels() {
 * a low negative weight indicates a small decrease in COVID rates
 */
 void safeCovid::initializeWeights() {
-  vector<Edge> edges = airportGraph.getEdges();
-  double rate1;
-  double rate2;
-  for (unsigned i = 0; i < edges.size(); i++) {
-    if (airportGraph.getAdjacent(edges[i].source).size() != 0) {
-      person_.rate(airportGraph.getAdjacent(edges[i].source).size());
-      rate1 = person_.getRate();
-    } else continue;
-    if (airportGraph.getAdjacent(edges[i].dest).size() != 0) {
-      person_.rate(airportGraph.getAdjacent(edges[i].dest).size());
-      rate2 = person_.getRate();
-    } else continue;
-    airportGraph.setEdgeWeight(edges[i].source, edges[i].dest, rate2-rate1);
+  for (VertexId source = 0; source < network.vertexCount(); source++) {
+    network.forEachNeighbor(source, [&](VertexId dest, double) {
+      // person::rate builds on every earlier call, so the source's rate is
+      // taken again for each flight, in the original order; a source with
+      // a flight out always has a non-zero degree
+      person_.rate(network.degree(source));
+      double rate1 = person_.getRate();
+      if (network.degree(dest) == 0)
+        return;
+      person_.rate(network.degree(dest));
+      double rate2 = person_.getRate();
+      airportGraph.setEdgeWeight(network.getVertexName(source), network.getVertexName(dest), rate2-rate1);
+    });
   }
+  freezeNetwork();
+}
+
+/**
+* Rebuilds the read-only CSR copy of the airport graph that the
+* traversals run on. Must be called whenever airportGraph changes.
+*/
+void safeCovid::freezeNetwork() {
+  network = CSRGraph(airportGraph);
+  bidirectionalReady = false;
+  hopSearchReady = false;
+  hopLayersReady = false;
+  hopMatrixReady = hopMatrixReady && hopMatrix.fits(network);
+  aStarReady = false;
+  altReady = false;
+  hierarchyReady = false;
+  customizableReady = false;
+  hubLabelsReady = false;
+  potentialReady = false;
+  trees.clear();
+  trees.reserve(treeSlots);
+  nextTree = 0;
+}
+
+/**
+* Reads airport coordinates for the AStar query mode.
+* @param filename - OpenFlights airport file, e.g. data/airportcodes.txt
+* @return - false if the file could not be read
+*/
+bool safeCovid::loadCoordinates(const std::string& filename) {
+  aStarReady = false;
+  return locations.load(filename, airportGraph);
+}
+
+/**
+* Return the coordinates read by loadCoordinates
+* @return - airport coordinates indexed by VertexId
+*/
+const AirportLocations& safeCovid::getLocations() const {
+  return locations;
+}
+
+/**
+* Return the read-only CSR copy of the airport graph
+* @return - the frozen airports and flight paths graph
+*/
+const CSRGraph& safeCovid::getNetwork() const {
+  return network;
 }
 
 /**
@@ -179,20 +253,12 @@ void safeCovid::setPerson(float age) {
 * @param v - Vertex that indicated the airport where traversal begins.
 */
 void safeCovid::BFSstart(Vertex v) {
-    vector<Vertex> all_vertices = airportGraph.getVertices();
-    vector<Edge> all_edges = airportGraph.getEdges();
-    for (unsigned i = 0; i < all_vertices.size(); i++) {
-        std::string temp = all_vertices[i];
-        explore_vertices.insert({temp, "UNEXPLORED"});
-    }
-    for (unsigned i = 0; i < all_edges.size(); i++) {
-        std::string temp = all_edges[i].getLabel();
-        explore_edges.insert({temp, "UNEXPLORED"});
-    }
+    explored.assign(network.vertexCount(), 0);
+    bfsPred.assign(network.vertexCount(), Graph::InvalidVertexId);
     BFS(v);
-    for (unsigned i = 0; i < all_vertices.size(); i++) {
-        if (explore_vertices[all_vertices[i]] == "UNEXPLORED") {
-            BFS(all_vertices[i]);
+    for (VertexId id = 0; id < network.vertexCount(); id++) {
+        if (!explored[id]) {
+            BFS(network.getVertexName(id));
         }
     }
 }
@@ -205,61 +271,301 @@ void safeCovid::BFSstart(Vertex v) {
 * @param v - Vertex that indicated the airport where traversal begins.
 */
 void safeCovid::BFS(Vertex v) {
-    std::queue<Vertex> q;
-    explore_vertices[v] = "EXPLORED";
-    q.push(v);
-
-    while (!q.empty()) {
-        Vertex v = q.front();
-        q.pop();
-        for (Vertex w : airportGraph.getAdjacent(v)) {
-            std::string label_e = v + "_" + w;
-            if (explore_vertices[w] == "UNEXPLORED") {
-                std::string name_edge_ = v + "_" + w;
-                explore_edges[name_edge_] = "DISCOVERY";
-                explore_vertices[w] = "VISITED";
-                q.push(w);
-                pred_vertex.insert({w, v});
-            } else if (explore_edges[label_e] == "UNEXPLORED") {
-                explore_edges[label_e] = "CROSS";
+    if (explored.size() != network.vertexCount()) {
+        explored.assign(network.vertexCount(), 0);
+        bfsPred.assign(network.vertexCount(), Graph::InvalidVertexId);
+    }
+    VertexId start = airportGraph.getVertexId(v);
+    if (start == Graph::InvalidVertexId || explored[start])
+        return;
+
+    // Discovery and cross edges follow from bfsPred, so only vertices are marked here
+    bfsQueue.clear();
+    explored[start] = 1;
+    bfsQueue.push_back(start);
+    for (size_t head = 0; head < bfsQueue.size(); head++) {
+        VertexId id = bfsQueue[head];
+        for (uint32_t e = network.edgeBegin(id); e < network.edgeEnd(id); e++) {
+            VertexId w = network.target(e);
+            if (!explored[w]) {
+                explored[w] = 1;
+                bfsPred[w] = id;
+                bfsQueue.push_back(w);
             }
         }
     }
 }
 
+/**
+* Returns the label the last BFS traversal left on an airport.
+* @param v - The airport to look up
+* @return - Visited if the traversal reached it, otherwise Unexplored
+*/
+safeCovid::TraversalLabel safeCovid::getVertexLabel(Vertex v) const {
+    VertexId id = airportGraph.getVertexId(v);
+    if (id == Graph::InvalidVertexId || id >= explored.size() || !explored[id])
+        return Unexplored;
+    return Visited;
+}
+
+/**
+* Returns the label the last BFS traversal left on a flight path.
+* Edge labels are not stored; they are worked out from the
+* traversal's predecessors when asked for.
+* @param source - The airport the flight leaves from
+* @param destination - The airport the flight arrives at
+* @return - Discovery, Cross, or Unexplored if the traversal never
+* examined the edge or it does not exist
+*/
+safeCovid::TraversalLabel safeCovid::getEdgeLabel(Vertex source, Vertex destination) const {
+    VertexId u = airportGraph.getVertexId(source);
+    VertexId w = airportGraph.getVertexId(destination);
+    if (getVertexLabel(source) == Unexplored || network.findEdge(u, w) == CSRGraph::InvalidEdgeIndex)
+        return Unexplored;
+    // every edge out of a reached vertex is examined, and the first one
+    // into each new vertex is the one recorded as its predecessor
+    return bfsPred[w] == u ? Discovery : Cross;
+}
+
 /**
 * Uses a BFS to determine the quickest path from a starting location
 * to an end location. This does not take COVID rates into account
 * and provides purely the shortest path.
 * @param s - The starting airport
 * @param d - The destination airport
-* @return - vector where each entry is the IATA code for each airport along the path.
+* @return - vector where each entry is the IATA code for each airport along the path,
+* starting from the destination. Empty if there is no path.
 */
 vector<std::string> safeCovid::getPathBFS(Vertex s, Vertex d) {
-    BFSstart(s);
-    Vertex destination_ = d;
-    Vertex start_ = s;
     vector<std::string> res_;
-    res_.push_back(destination_);
-    int count_checks = 0;
-    while (count_checks < 10) {
-        std::string pred_ = pred_vertex[destination_];
-        res_.push_back(pred_);
-        destination_ = pred_;
-        if (pred_ == start_) {
-            explore_edges.clear(); // clean variables so BFS can be used again
-            explore_vertices.clear();
-            pred_vertex.clear();
-            return res_;
-        }
+    if (getPathBFS(s, d, BidirectionalBFS::NoHopLimit, res_) != PathFound)
+        std::cout << "There is no path from " << s << " to " << d << "." << std::endl;
+    return res_;
+}
+
+/**
+* Uses a BFS to find the quickest path from a starting location to an
+* end location that takes at most maxHops flights. If every path
+* needs more flights, the search goes on only as far as it takes to
+* tell whether d can be reached at all, so the status is the same
+* whichever way the answer is found. Once the flight-count matrix is
+* ready, such pairs are answered from it without searching.
+* @param s - The starting airport
+* @param d - The destination airport
+* @param maxHops - The most flights the path may take
+* @param path - Filled with the IATA code for each airport along the path,
+* starting from the destination. Empty unless a path is found.
+* @return - PathFound, NoPathWithinHops, or NoPath if d can't be reached at all
+*/
+HopSearchResult safeCovid::getPathBFS(Vertex s, Vertex d, unsigned maxHops, vector<std::string>& path) {
+    vector<VertexId> ids;
+    path.clear();
+    if (hopMatrixReady) {
+        // the matrix only rules pairs out; routes still come from the
+        // search, so they don't depend on whether the matrix is built
+        unsigned hops = hopMatrix.hops(airportGraph.getVertexId(s), airportGraph.getVertexId(d));
+        if (hops == HopMatrix::Unreached)
+            return NoPath;
+        if (hops > maxHops)
+            return NoPathWithinHops;
+    }
+    if (!hopSearchReady) {
+        hopSearch = BidirectionalBFS(network);
+        hopSearchReady = true;
+    }
+    // searches from both ends and stops where they meet, instead of
+    // running BFSstart over the whole graph for one query
+    HopSearchResult result = hopSearch.findPath(airportGraph.getVertexId(s), airportGraph.getVertexId(d), ids, maxHops);
+    for (size_t i = ids.size(); i > 0; i--)
+        path.push_back(network.getVertexName(ids[i - 1]));
+    return result;
+}
+
+/**
+* Counts the fewest flights from one airport to every airport with a
+* direction-optimizing BFS (see DirectionOptimizingBFS). Unlike BFSstart
+* it neither labels edges nor restarts from unvisited airports, which
+* suits analytics that need whole hop layers from many roots.
+* @param s - The starting airport
+* @param hops - Filled with the number of flights to each airport, indexed by
+* VertexId; DirectionOptimizingBFS::Unreached where s can't reach
+* @return - false if s is not an airport
+*/
+bool safeCovid::getHopLayers(Vertex s, std::vector<unsigned>& hops) {
+    if (!hopLayersReady) {
+        hopLayers = DirectionOptimizingBFS(network);
+        hopLayersReady = true;
+    }
+    VertexId root = airportGraph.getVertexId(s);
+    hopLayers.run(root, hops);
+    return root != Graph::InvalidVertexId;
+}
+
+/**
+* Returns the fewest-flight routes from one airport to every airport
+* (see ShortestPathTree). The last few trees are kept, so asking again
+* for the same airport, or reading routes to many destinations, costs
+* no search.
+* @param origin - The airport the routes start from
+* @return - The tree, which reaches nothing if origin is not an airport;
+* it may be replaced by the next getHopTree or getRiskTree call
+*/
+const ShortestPathTree& safeCovid::getHopTree(Vertex origin) {
+    return keepTree(airportGraph.getVertexId(origin), ShortestPathTree::Hops);
+}
+
+/**
+* Returns the safest routes from one airport to every airport, ranked
+* like getPathDijkstra (see ShortestPathTree). The last few trees are
+* kept until the network changes, and getPathDijkstra reads its path
+* from one of them when it can.
+* @param origin - The airport the routes start from
+* @return - The tree, which reaches nothing if origin is not an airport;
+* it may be replaced by the next getHopTree or getRiskTree call
+*/
+const ShortestPathTree& safeCovid::getRiskTree(Vertex origin) {
+    return keepTree(airportGraph.getVertexId(origin), ShortestPathTree::Risk);
+}
+
+/**
+* Fills a table of the least total risk from each of several airports
+* to each of several others, sharing the searches between the cells
+* (see DistanceTable). The contraction hierarchy of the CH query mode
+* is built first if needed.
+* @param sources - The airports the rows start from
+* @param targets - The airports the columns end at
+* @param table - Filled with sources.size() rows of targets.size() risks,
+* row-major; infinity where there is no route or an airport is unknown
+* @param threads - How many threads to use, 0 for one per core
+* @return - false, leaving every cell infinite, if the network has a
+* negative cycle
+*/
+bool safeCovid::getRiskTable(const vector<Vertex>& sources, const vector<Vertex>& targets, vector<double>& table,
+                             unsigned threads) {
+    if (!hierarchyReady) {
+        hierarchy = ContractionHierarchy(network);
+        hierarchyReady = true;
+    }
+    vector<VertexId> sourceIds;
+    vector<VertexId> targetIds;
+    for (const Vertex& s : sources)
+        sourceIds.push_back(airportGraph.getVertexId(s));
+    for (const Vertex& d : targets)
+        targetIds.push_back(airportGraph.getVertexId(d));
+    return distanceTable.fill(hierarchy, sourceIds, targetIds, table, threads);
+}
+
+/**
+* Returns a kept tree with the given root and metric, or NULL.
+*/
+const ShortestPathTree* safeCovid::findTree(VertexId root, ShortestPathTree::Metric metric) const {
+    for (const ShortestPathTree& tree : trees)
+        if (tree.getRoot() == root && tree.getMetric() == metric)
+            return &tree;
+    return NULL;
+}
+
+/**
+* Returns a kept tree with the given root and metric, growing and
+* keeping one if there is none.
+*/
+const ShortestPathTree& safeCovid::keepTree(VertexId root, ShortestPathTree::Metric metric) {
+    const ShortestPathTree* kept = findTree(root, metric);
+    if (kept != NULL)
+        return *kept;
+    // a tree is one double, one count and one parent per airport, about
+    // 55 KB for the OpenFlights data, so a few starts and landmarks fit
+    // in treeSlots
+    // risk trees share the potential Dijkstra's algorithm reduces by
+    ShortestPathTree tree = (metric == ShortestPathTree::Risk)
+        ? ShortestPathTree(network, root, metric, reducingPotential())
+        : ShortestPathTree(network, root, metric);
+    if (trees.size() < treeSlots) {
+        trees.push_back(tree);
+        return trees.back();
     }
-    explore_edges.clear(); // clean variables so BFS can be used again
-    explore_vertices.clear();
-    pred_vertex.clear();
+    trees[nextTree] = tree;
+    const ShortestPathTree& replaced = trees[nextTree];
+    nextTree = (nextTree + 1) % treeSlots;
+    return replaced;
+}
+
+/**
+* Fills the all-pairs flight-count matrix (see HopMatrix). It only
+* depends on which airports are connected, so it is kept across
+* setPerson. Once it is built, here, by getFewestHops or isWithinHops,
+* or loaded, getPathBFS answers pairs with no route within its hop limit
+* from the matrix; the routes it returns are the same either way.
+* @param threads - How many threads to use, 0 for one per core
+* @return - false if some route is too long for the matrix
+*/
+bool safeCovid::buildHopMatrix(unsigned threads) {
+    hopMatrix = HopMatrix(network, threads);
+    hopMatrixReady = hopMatrix.usable();
+    return hopMatrixReady;
+}
 
-    std::cout << "The length of the path exceeded 10 or there is no path from " << s << " to " << d << "."<<std::endl;
-    vector<std::string> empty;
-    return empty;
+/**
+* Writes the flight-count matrix to a file, building it first if needed.
+* @param filename - Where to write the matrix
+* @return - false if it could not be built or written
+*/
+bool safeCovid::saveHopMatrix(const std::string& filename) {
+    if (!prepareHopMatrix())
+        return false;
+    return hopMatrix.save(filename);
+}
+
+/**
+* Reads a flight-count matrix written by saveHopMatrix, so it does not
+* have to be built.
+* @param filename - The file to read
+* @return - false if the file is missing or damaged, or was built for
+* other airports or flights
+*/
+bool safeCovid::loadHopMatrix(const std::string& filename) {
+    if (!hopMatrix.load(filename, network))
+        return false;
+    hopMatrixReady = true;
+    return true;
+}
+
+/**
+* Looks up the fewest flights from one airport to another in the
+* flight-count matrix, building it on the first call.
+* @param s - The starting airport
+* @param d - The destination airport
+* @return - The number of flights, or HopMatrix::Unreached if d can't be
+* reached from s or either is not an airport
+*/
+unsigned safeCovid::getFewestHops(Vertex s, Vertex d) {
+    prepareHopMatrix();
+    return hopMatrix.hops(airportGraph.getVertexId(s), airportGraph.getVertexId(d));
+}
+
+/**
+* Whether d can be reached from s within maxHops flights, answered from
+* the flight-count matrix, which is built on the first call.
+* @param s - The starting airport
+* @param d - The destination airport
+* @param maxHops - The most flights allowed
+*/
+bool safeCovid::isWithinHops(Vertex s, Vertex d, unsigned maxHops) {
+    prepareHopMatrix();
+    return hopMatrix.withinHops(airportGraph.getVertexId(s), airportGraph.getVertexId(d), maxHops);
+}
+
+/**
+* Builds the flight-count matrix with one thread per core if it is not
+* ready.
+* @return - whether the matrix is ready
+*/
+bool safeCovid::prepareHopMatrix() {
+    if (!hopMatrixReady) {
+        hopMatrix = HopMatrix(network);
+        hopMatrixReady = hopMatrix.usable();
+    }
+    return hopMatrixReady;
 }
 
 /**
@@ -296,17 +602,25 @@ void safeCovid::printPathBFS(Vertex s, Vertex d) {
 * This does not take COVID rates into account and provides purely the shortest path.
 * @param s - Starting airport
 * @param d - Destination airport
-* @return - vector where each entry is the IATA code for each airport along the path.
+* @return - vector where each entry is the IATA code for each airport along the path,
+* starting airport first; empty if there is no route through the landmark.
 */
 vector<std::string> safeCovid::getPathLandmarkBFS(Vertex start, Vertex landmark, Vertex destination) {
-    BFSstart(landmark);
-    vector<std::string> to_start_path = getPathBFS(landmark, start);
-    vector<std::string> to_dest_path = getPathBFS(landmark, destination);
+    //Both legs are read off kept trees, so queries sharing a start or a
+    //landmark search once
+    vector<VertexId> to_landmark;
+    vector<VertexId> to_dest;
+    getHopTree(start).pathTo(airportGraph.getVertexId(landmark), to_landmark);
+    getHopTree(landmark).pathTo(airportGraph.getVertexId(destination), to_dest);
 
-    for (unsigned i = 1; i < to_dest_path.size(); i++) {
-        to_start_path.push_back(to_dest_path[to_dest_path.size() - i - 1]);
-    }
-    return to_start_path;
+    vector<std::string> path;
+    if (to_landmark.empty() || to_dest.empty())
+        return path;
+    for (VertexId v : to_landmark)
+        path.push_back(network.getVertexName(v));
+    for (unsigned i = 1; i < to_dest.size(); i++)
+        path.push_back(network.getVertexName(to_dest[i]));
+    return path;
 }
 
 /**
@@ -330,6 +644,10 @@ void safeCovid::printLandmarkPathBFS(Vertex start, Vertex landmark, Vertex desti
 
     startVertex = start;
     vector<std::string> landmark_path = getPathLandmarkBFS(start, landmark, destination);
+    if (landmark_path.empty()) {
+        std::cout << "Sorry! There is no route from " << start << " to " << destination << " through " << landmark << "." << std::endl;
+        return;
+    }
 
     std::cout << "Starting location: " << start << "  Landmark:  " << landmark <<"    End location: " << destination << std::endl;
 
@@ -347,67 +665,174 @@ void safeCovid::printLandmarkPathBFS(Vertex start, Vertex landmark, Vertex desti
 * @param start - The vertex/airport to start from
 */
 void safeCovid::DijkstraSSSP(Vertex start) {
-  p.clear();
-  d.clear();
-  dijkstraGraph.clear();
+  DijkstraSearch(airportGraph.getVertexId(start), Graph::InvalidVertexId);
+}
+
+/**
+* Returns how many airports the last Dijkstra search settled.
+* A full DijkstraSSSP settles every reachable airport, while
+* getPathDijkstra stops as soon as the destination is settled.
+* @return - number of settled airports
+*/
+size_t safeCovid::getSettledCount() const {
+  return settledCount;
+}
+
+/**
+* Chooses how getPathDijkstra searches. Unidirectional, Bidirectional,
+* ALT, CH, CCH and HubLabel find equally safe paths with the same number of flights, but when
+* several such paths exist they may pick different ones. All of them
+* rank paths by Johnson-reduced weights (see CSRGraph::feasiblePotential),
+* which shift every route between two airports by the same amount, so
+* they agree even when setPerson leaves some flights with negative risk.
+* AStar instead
+* finds the path with the least flight distance stretched by risk.
+* @param mode - the search to use
+*/
+void safeCovid::setQueryMode(QueryMode mode) {
+  queryMode = mode;
+}
+
+/**
+* Returns how getPathDijkstra searches.
+* @return - the search in use
+*/
+safeCovid::QueryMode safeCovid::getQueryMode() const {
+  return queryMode;
+}
+
+/**
+* Sets how many landmarks the ALT query mode precomputes distances for.
+* Each one takes two distance tables over all airports; more landmarks
+* give tighter bounds, so queries settle fewer airports. The tables are
+* rebuilt on the next ALT query.
+* @param count - number of landmarks
+*/
+void safeCovid::setALTLandmarkCount(unsigned count) {
+  altLandmarkCount = count;
+  altReady = false;
+}
+
+/**
+* Returns how many landmarks the ALT query mode uses.
+* @return - number of landmarks
+*/
+unsigned safeCovid::getALTLandmarkCount() const {
+  return altLandmarkCount;
+}
+
+/**
+* Writes the contraction hierarchy used by the CH query mode to a file,
+* building it first if needed.
+* @param filename - where to write the hierarchy
+* @return - false if it could not be written, or the weights have a
+* negative cycle and there is no hierarchy
+*/
+bool safeCovid::saveHierarchy(const std::string& filename) {
+  if (!hierarchyReady) {
+    hierarchy = ContractionHierarchy(network);
+    hierarchyReady = true;
+  }
+  return hierarchy.save(filename);
+}
 
-  vector<Vertex> vertices = airportGraph.getVertices();
+/**
+* Reads a contraction hierarchy for the CH query mode from a file,
+* so it does not have to be built on the first query.
+* @param filename - a file written by saveHierarchy
+* @return - false if the file is missing or damaged, or was built
+* for another graph or other weights
+*/
+bool safeCovid::loadHierarchy(const std::string& filename) {
+  if (!hierarchy.load(filename, network))
+    return false;
+  hierarchyReady = true;
+  return true;
+}
 
-  for(Vertex v : vertices) {
-    std::pair<Vertex, double> pair1 (v, std::numeric_limits<double>::infinity());
-    d.insert(pair1);
-    std::pair<Vertex, Vertex> pair2 (v, " ");
-    p.insert(pair2);
+/**
+* Runs Dijkstra's algorithm from start, filling dist, pred and settled.
+* The search runs on weights reduced by the potential, so negative
+* weights are fine as long as no cycle is negative; dist holds the
+* reduced distances.
+* @param startId - ID of the airport to start from
+* @param target - ID of an airport to stop at once it is settled,
+* or Graph::InvalidVertexId to search the whole graph
+*/
+void safeCovid::DijkstraSearch(VertexId startId, VertexId target) {
+  size_t count = network.vertexCount();
+  if (dist.size() != count) {
+    dist.assign(count, std::numeric_limits<double>::infinity());
+    pred.assign(count, Graph::InvalidVertexId);
+    settled.assign(count, 0);
+    hops.assign(count, std::numeric_limits<unsigned>::max());
+    pqueue.reset(count);
+  } else {
+    //Only undo what the last search touched, so short searches stay short
+    for (VertexId v : reached) {
+      dist[v] = std::numeric_limits<double>::infinity();
+      pred[v] = Graph::InvalidVertexId;
+      settled[v] = 0;
+      hops[v] = std::numeric_limits<unsigned>::max();
+    }
+    pqueue.clear();
   }
-  d[start] = 0.0;
+  reached.clear();
+  settledCount = 0;
 
-  heap<Vertex> pqueue (vertices);
-  pqueue.addWeights(d);
+  if (startId == Graph::InvalidVertexId)
+    return;
+  const std::vector<double>& reduce = reducingPotential();
+  dist[startId] = 0.0;
+  //Paths that are equally safe are ordered by how many flights they take,
+  //so ties are broken the same way every run instead of by heap order
+  hops[startId] = 0;
+  reached.push_back(startId);
+
+  //Only vertices that have been reached are queued, keyed by their ID
+  pqueue.push(startId, std::make_pair(0.0, 0u));
 
-  bool started = false;
   while (!pqueue.empty()) {
-    Vertex u;
-    if (!started) {
-      u = start;
-      started = true;
-    } else u = pqueue.pop();
-    dijkstraGraph.insertVertex(u);
-
-    vector<Vertex> dijkstraVertices = dijkstraGraph.getVertices();
-    for (Vertex v : airportGraph.getAdjacent(u)) {
-      bool found = false;
-      //Check if u's neighbor is already in the final graph
-      for (Vertex vert : dijkstraVertices) {
-        if (vert == v) {
-          found = true;
-          break;
-        }
-      }
-      //If it's there, we skip over it and continue to another adjacent vertex
-      if (found) continue;
+    VertexId u = pqueue.pop();
+    settled[u] = 1;
+    settledCount++;
+    //Once the target is settled its path is final, so the rest can wait
+    if (u == target) return;
+
+    network.forEachNeighbor(u, [&](VertexId v, double weight) {
+      //If v is already settled, its path can't get any better
+      if (settled[v]) return;
 
       //Check to see if we found a cheaper path, since that's good
-      if (airportGraph.getEdgeWeight(u, v) + d[u] < d[v]) {
-        d[v] = airportGraph.getEdgeWeight(u, v) + d[u];
-        pqueue.changeWeight(v, d[v]);
-        //If v isn't in our queue, push it back in
-        vector<Vertex> heapVertices;
-        pqueue.getElems(heapVertices);
-        bool exist = false;
-        for (Vertex cur : heapVertices) {
-          if (v == cur) {
-            exist = true;
-            break;
-          }
-        }
-        if (!exist) {
-          pqueue.push(v);
-        }
+      double risk = weight + reduce[u] - reduce[v] + dist[u];
+      unsigned flights = hops[u] + 1;
+      if (risk < dist[v] || (risk == dist[v] && flights < hops[v])) {
+        if (hops[v] == std::numeric_limits<unsigned>::max())
+          reached.push_back(v);
+        dist[v] = risk;
+        hops[v] = flights;
+        //Queues v, or moves it up if it is already queued
+        pqueue.decreaseKey(v, std::make_pair(risk, flights));
         //Update it's new predecessor assuming a path to here from starter
-        p[v] = u;
+        pred[v] = u;
       }
-    }
+    });
+  }
+}
+
+/**
+* Returns a potential that makes every reduced weight of the network
+* non-negative, finding it if the network changed. With a negative cycle
+* there is none, and the potential is all zero, leaving the weights as
+* they are.
+*/
+const std::vector<double>& safeCovid::reducingPotential() {
+  if (!potentialReady) {
+    if (!network.feasiblePotential(potential))
+      potential.assign(network.vertexCount(), 0.0);
+    potentialReady = true;
   }
+  return potential;
 }
 
 /**
@@ -420,27 +845,134 @@ void safeCovid::DijkstraSSSP(Vertex start) {
 */
 vector<std::string> safeCovid::getPathDijkstra(Vertex s, Vertex d) {
   startVertex = s;
-  DijkstraSSSP(s);
+  if (queryMode == Bidirectional) {
+    if (!bidirectionalReady) {
+      bidirectional = BidirectionalDijkstra(network);
+      bidirectionalReady = true;
+    }
+    //A negative cycle leaves the bidirectional search without a meeting criterion
+    if (bidirectional.usable()) {
+      vector<VertexId> ids;
+      bidirectional.findPath(airportGraph.getVertexId(s), airportGraph.getVertexId(d), ids);
+      settledCount = bidirectional.getSettledCount();
+      return namePath(ids, s, d);
+    }
+  }
+
+  if (queryMode == AStar && locations.knownCount() > 0) {
+    if (!aStarReady) {
+      aStar = AStarSearch(network, locations);
+      aStarReady = true;
+    }
+    vector<VertexId> ids;
+    aStar.findPath(airportGraph.getVertexId(s), airportGraph.getVertexId(d), ids);
+    settledCount = aStar.getSettledCount();
+    return namePath(ids, s, d);
+  }
+
+  if (queryMode == ALT) {
+    if (!altReady) {
+      alt = ALTSearch(network, altLandmarkCount);
+      altReady = true;
+    }
+    //Like the bidirectional search, ALT needs the graph to be free of negative cycles
+    if (alt.usable()) {
+      vector<VertexId> ids;
+      alt.findPath(airportGraph.getVertexId(s), airportGraph.getVertexId(d), ids);
+      settledCount = alt.getSettledCount();
+      return namePath(ids, s, d);
+    }
+  }
+
+  if (queryMode == CH) {
+    if (!hierarchyReady) {
+      hierarchy = ContractionHierarchy(network);
+      hierarchyReady = true;
+    }
+    if (hierarchy.usable()) {
+      vector<VertexId> ids;
+      hierarchy.findPath(airportGraph.getVertexId(s), airportGraph.getVertexId(d), ids);
+      settledCount = hierarchy.getSettledCount();
+      return namePath(ids, s, d);
+    }
+  }
+
+  if (queryMode == CCH) {
+    if (!customizableReady) {
+      //setPerson only changes weights, so the order is usually still good
+      if (!customizable.fits(network))
+        customizable = CustomizableHierarchy(network);
+      customizable.customize(network);
+      customizableReady = true;
+    }
+    if (customizable.usable()) {
+      vector<VertexId> ids;
+      customizable.findPath(airportGraph.getVertexId(s), airportGraph.getVertexId(d), ids);
+      settledCount = customizable.getSettledCount();
+      return namePath(ids, s, d);
+    }
+  }
+
+  if (queryMode == HubLabel) {
+    if (!hubLabelsReady) {
+      hubLabels = HubLabels(network);
+      hubLabelsReady = true;
+    }
+    if (hubLabels.usable()) {
+      vector<VertexId> ids;
+      hubLabels.findPath(airportGraph.getVertexId(s), airportGraph.getVertexId(d), ids);
+      //a lookup settles nothing
+      settledCount = 0;
+      return namePath(ids, s, d);
+    }
+  }
+
+  //A kept tree from s already holds the path Unidirectional would find
+  const ShortestPathTree* tree = findTree(airportGraph.getVertexId(s), ShortestPathTree::Risk);
+  if (tree != NULL) {
+    vector<VertexId> ids;
+    tree->pathTo(airportGraph.getVertexId(d), ids);
+    settledCount = 0;
+    return namePath(ids, s, d);
+  }
+
+  VertexId cur = airportGraph.getVertexId(d);
+  DijkstraSearch(airportGraph.getVertexId(s), cur);
   vector<Vertex> path;
   path.push_back(d);
 
-  Vertex cur = d;
-  if (p[d] == " ") {
+  if (cur == Graph::InvalidVertexId || pred[cur] == Graph::InvalidVertexId) {
     path.push_back(s);
   } else {
-    while (p[cur] != " ") {
-      path.push_back(p[cur]);
-      cur = p[cur];
+    while (pred[cur] != Graph::InvalidVertexId) {
+      cur = pred[cur];
+      path.push_back(network.getVertexName(cur));
     }
   }
-
-  p.clear();
-  d.clear();
-  dijkstraGraph.clear();
   return path;
 
 }
 
+/**
+* Turns a path found by one of the search engines into airport codes.
+* @param ids - IDs along the path, starting airport first
+* @param s - The starting airport
+* @param d - The destination airport
+* @return - IATA codes starting from the destination, or just d and s
+* if no path was found
+*/
+vector<std::string> safeCovid::namePath(const vector<VertexId>& ids, Vertex s, Vertex d) const {
+  vector<Vertex> path;
+  path.push_back(d);
+  if (ids.size() < 2) {
+    path.push_back(s);
+  } else {
+    for (size_t i = ids.size() - 1; i > 0; i--)
+      path.push_back(network.getVertexName(ids[i - 1]));
+  }
+  return path;
+}
+
 /**
 * Prints the result from the safest path determined by Dijkstra's algorithm.
 * @param start - Starting airport
@@ -478,23 +1010,25 @@ void safeCovid::printPathDijkstra(Vertex start, Vertex dest) {
 * @param start - The starting airport
 * @param landmark - Landmark airport to visit along the way
 * @param dest - The destination airport
-* @return - vector where each entry is the IATA code for each airport along the path.
+* @return - vector where each entry is the IATA code for each airport along the path,
+* starting airport first; empty if there is no route through the landmark.
 */
 vector<std::string> safeCovid::getPathLandmarkDijkstra(Vertex start, Vertex landmark, Vertex destination) {
-  vector<std::string> to_landmark_path = getPathDijkstra(start, landmark);
-  vector<std::string> to_dest_path = getPathDijkstra(landmark, destination);
+  //Both legs are read off kept trees, so queries sharing a start or a
+  //landmark search once
+  vector<VertexId> to_landmark;
+  vector<VertexId> to_dest;
+  getRiskTree(start).pathTo(airportGraph.getVertexId(landmark), to_landmark);
+  getRiskTree(landmark).pathTo(airportGraph.getVertexId(destination), to_dest);
 
-  for (unsigned i = 1; i <= to_landmark_path.size() / 2; i++) {
-    std::string tmp = to_landmark_path[i-1];
-    to_landmark_path[i-1] = to_landmark_path[to_landmark_path.size()-i];
-    to_landmark_path[to_landmark_path.size()-i] = tmp;
-  }
-
-  for (unsigned i = 2; i < to_dest_path.size(); i++) {
-    to_landmark_path.push_back(to_dest_path[to_dest_path.size()-i]);
-  }
-  to_landmark_path.push_back(destination);
-  return to_landmark_path;
+  vector<std::string> path;
+  if (to_landmark.empty() || to_dest.empty())
+    return path;
+  for (VertexId v : to_landmark)
+    path.push_back(network.getVertexName(v));
+  for (unsigned i = 1; i < to_dest.size(); i++)
+    path.push_back(network.getVertexName(to_dest[i]));
+  return path;
 }
 
 /**
@@ -520,6 +1054,10 @@ void safeCovid::printLandmarkPathDijkstra(Vertex start, Vertex landmark, Vertex
 
   startVertex = start;
   vector<std::string> landmark_path = getPathLandmarkDijkstra(start, landmark, destination);
+  if (landmark_path.empty()) {
+    std::cout << "Sorry! There is no route from " << start << " to " << destination << " through " << landmark << "." << std::endl;
+    return;
+  }
 
   std::cout << "Starting location: " << start << "  Landmark:  " << landmark <<"    End location: " << destination << std::endl;
 
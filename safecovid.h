@@ -1,14 +1,55 @@
 #pragma once
 #include "airportGraph.h"
 #include "person.h"
-#include "heap.h"
+#include "indexedHeap.h"
+#include "csrGraph.h"
+#include "bidirectionalDijkstra.h"
+#include "bidirectionalBFS.h"
+#include "directionOptimizingBFS.h"
+#include "hopMatrix.h"
+#include "airportLocations.h"
+#include "aStarSearch.h"
+#include "altSearch.h"
+#include "contractionHierarchy.h"
+#include "customizableHierarchy.h"
+#include "hubLabels.h"
+#include "shortestPathTree.h"
+#include "distanceTable.h"
 #include <string>
+#include <vector>
 #include <unordered_map>
 #include <queue>
 
+class RouteFile;
+
 class safeCovid
 {
     public:
+      /**
+      * How getPathDijkstra searches for the safest path.
+      */
+      enum QueryMode {
+        Unidirectional, /**< Dijkstra from the starting airport only */
+        Bidirectional, /**< Dijkstra from both ends at once, see BidirectionalDijkstra */
+        AStar, /**< A* over flight distance stretched by risk, see AStarSearch;
+                   needs loadCoordinates, otherwise searches like Unidirectional */
+        ALT, /**< A* guided by distances to and from precomputed landmarks, see ALTSearch */
+        CH, /**< Upward searches on a contraction hierarchy, see ContractionHierarchy */
+        CCH, /**< Like CH, but on a hierarchy whose order survives setPerson and only has
+                  the new weights applied, see CustomizableHierarchy */
+        HubLabel /**< Merges precomputed hub labels and unpacks the path, see HubLabels */
+      };
+
+      /**
+      * Labels left behind by BFSstart and BFS.
+      */
+      enum TraversalLabel {
+        Unexplored, /**< Not reached (vertex) or not examined (edge) */
+        Visited, /**< A vertex the traversal reached */
+        Discovery, /**< An edge the traversal first reached its destination through */
+        Cross /**< An examined edge whose destination had already been reached */
+      };
+
       /**
       * Constructor that takes in a file to initialize graph
       * This will use a default Person instead of user-provided information
@@ -23,6 +64,23 @@ class safeCovid
       */
       safeCovid(const std::string& filename, person pers);
 
+      /**
+      * Constructor that takes in a file to initialize graph
+      * This will use custom Person generated by having a provided age
+      * @param filename - Name of the input file to establish vertices/edges
+      * @param loadThreads - Number of threads used to parse the file, 0 for one per core
+      */
+      safeCovid(const std::string& filename, person pers, unsigned loadThreads);
+
+      /**
+      * Constructor that takes in a file to initialize graph and keeps a
+      * binary snapshot of it at the given path, see loadGraph
+      * @param filename - Name of the input file to establish vertices/edges
+      * @param loadThreads - Number of threads used to parse the file, 0 for one per core
+      * @param snapshot - Path of the snapshot to load from or write to
+      */
+      safeCovid(const std::string& filename, person pers, unsigned loadThreads, const std::string& snapshot);
+
 
       /**
       * Return the graph of airports and flight paths
@@ -30,6 +88,31 @@ class safeCovid
       */
       Graph getAirportGraph();
 
+      /**
+      * Return the read-only CSR copy of the airport graph
+      * @return - the frozen airports and flight paths graph
+      */
+      const CSRGraph& getNetwork() const;
+
+      /**
+      * Rebuilds the read-only CSR copy of the airport graph that the
+      * traversals run on. Must be called whenever airportGraph changes.
+      */
+      void freezeNetwork();
+
+      /**
+      * Reads airport coordinates for the AStar query mode.
+      * @param filename - OpenFlights airport file, e.g. data/airportcodes.txt
+      * @return - false if the file could not be read
+      */
+      bool loadCoordinates(const std::string& filename);
+
+      /**
+      * Return the coordinates read by loadCoordinates
+      * @return - airport coordinates indexed by VertexId
+      */
+      const AirportLocations& getLocations() const;
+
       /**
       * Return the person object associated with each run
       * @return - person object for this specific run
@@ -43,6 +126,35 @@ class safeCovid
       void setPerson(float age);
 
 
+      /**
+      * Loads the airport graph for a route file. Snapshots are opt-in:
+      * when a snapshot path is given, the graph is read from it if its
+      * fingerprint matches the route file's contents, and otherwise built
+      * from the route file and written there. Without one, nothing but
+      * the route file is read or written.
+      * @param filename - Name of the input file to establish vertices/edges
+      * @param threads - Number of threads used to parse the file, 0 for one per core
+      * @param snapshot - Path of the snapshot to use, empty for none
+      */
+      void loadGraph(const std::string& filename, unsigned threads = 0, const std::string& snapshot = "");
+
+      /**
+      * Generates all vertices and edges based on airport data.
+      * The route file is memory-mapped and split into chunks that are
+      * parsed and interned in parallel, then merged into the graph in
+      * file order.
+      * @param filename - Name of the input file to establish vertices/edges
+      * @param threads - Number of threads used to parse the file, 0 for one per core
+      */
+      void initializeGraph(const std::string& filename, unsigned threads = 0);
+
+      /**
+      * Same as above, for a route file that is already mapped.
+      * @param routes - the mapped route file
+      * @param threads - Number of threads used to parse the file, 0 for one per core
+      */
+      void initializeGraph(const RouteFile& routes, unsigned threads = 0);
+
       /**
       * Generates all vertices based on airport data
       * @param filename - Name of the input file to establish vertices/edges
@@ -86,6 +198,24 @@ class safeCovid
       */
       void BFS(Vertex v);
 
+      /**
+      * Returns the label the last BFS traversal left on an airport.
+      * @param v - The airport to look up
+      * @return - Visited if the traversal reached it, otherwise Unexplored
+      */
+      TraversalLabel getVertexLabel(Vertex v) const;
+
+      /**
+      * Returns the label the last BFS traversal left on a flight path.
+      * Edge labels are not stored; they are worked out from the
+      * traversal's predecessors when asked for.
+      * @param source - The airport the flight leaves from
+      * @param destination - The airport the flight arrives at
+      * @return - Discovery, Cross, or Unexplored if the traversal never
+      * examined the edge or it does not exist
+      */
+      TraversalLabel getEdgeLabel(Vertex source, Vertex destination) const;
+
 
       /**
       * Uses a BFS to determine the quickest path from a starting location
@@ -93,10 +223,123 @@ class safeCovid
       * and provides purely the shortest path.
       * @param s - The starting airport
       * @param d - The destination airport
-      * @return - vector where each entry is the IATA code for each airport along the path.
+      * @return - vector where each entry is the IATA code for each airport along the path,
+      * starting from the destination. Empty if there is no path.
       */
       vector<std::string> getPathBFS(Vertex s, Vertex d);
 
+      /**
+      * Uses a BFS to find the quickest path from a starting location to an
+      * end location that takes at most maxHops flights. If every path
+      * needs more flights, the search goes on only as far as it takes to
+      * tell whether d can be reached at all, so the status is the same
+      * whichever way the answer is found. Once the flight-count matrix is
+      * ready, such pairs are answered from it without searching.
+      * @param s - The starting airport
+      * @param d - The destination airport
+      * @param maxHops - The most flights the path may take
+      * @param path - Filled with the IATA code for each airport along the path,
+      * starting from the destination. Empty unless a path is found.
+      * @return - PathFound, NoPathWithinHops, or NoPath if d can't be reached at all
+      */
+      HopSearchResult getPathBFS(Vertex s, Vertex d, unsigned maxHops, vector<std::string>& path);
+
+      /**
+      * Counts the fewest flights from one airport to every airport with a
+      * direction-optimizing BFS (see DirectionOptimizingBFS). Unlike BFSstart
+      * it neither labels edges nor restarts from unvisited airports, which
+      * suits analytics that need whole hop layers from many roots.
+      * @param s - The starting airport
+      * @param hops - Filled with the number of flights to each airport, indexed by
+      * VertexId; DirectionOptimizingBFS::Unreached where s can't reach
+      * @return - false if s is not an airport
+      */
+      bool getHopLayers(Vertex s, std::vector<unsigned>& hops);
+
+      /**
+      * Returns the fewest-flight routes from one airport to every airport
+      * (see ShortestPathTree). The last few trees are kept, so asking again
+      * for the same airport, or reading routes to many destinations, costs
+      * no search.
+      * @param origin - The airport the routes start from
+      * @return - The tree, which reaches nothing if origin is not an airport;
+      * it may be replaced by the next getHopTree or getRiskTree call
+      */
+      const ShortestPathTree& getHopTree(Vertex origin);
+
+      /**
+      * Returns the safest routes from one airport to every airport, ranked
+      * like getPathDijkstra (see ShortestPathTree). The last few trees are
+      * kept until the network changes, and getPathDijkstra reads its path
+      * from one of them when it can.
+      * @param origin - The airport the routes start from
+      * @return - The tree, which reaches nothing if origin is not an airport;
+      * it may be replaced by the next getHopTree or getRiskTree call
+      */
+      const ShortestPathTree& getRiskTree(Vertex origin);
+
+      /**
+      * Fills a table of the least total risk from each of several airports
+      * to each of several others, sharing the searches between the cells
+      * (see DistanceTable). The contraction hierarchy of the CH query mode
+      * is built first if needed.
+      * @param sources - The airports the rows start from
+      * @param targets - The airports the columns end at
+      * @param table - Filled with sources.size() rows of targets.size() risks,
+      * row-major; infinity where there is no route or an airport is unknown
+      * @param threads - How many threads to use, 0 for one per core
+      * @return - false, leaving every cell infinite, if the network has a
+      * negative cycle
+      */
+      bool getRiskTable(const vector<Vertex>& sources, const vector<Vertex>& targets, vector<double>& table,
+                        unsigned threads = 0);
+
+      /**
+      * Fills the all-pairs flight-count matrix (see HopMatrix). It only
+      * depends on which airports are connected, so it is kept across
+      * setPerson. Once it is built, here, by getFewestHops or isWithinHops,
+      * or loaded, getPathBFS answers pairs with no route within its hop limit
+      * from the matrix; the routes it returns are the same either way.
+      * @param threads - How many threads to use, 0 for one per core
+      * @return - false if some route is too long for the matrix
+      */
+      bool buildHopMatrix(unsigned threads = 0);
+
+      /**
+      * Writes the flight-count matrix to a file, building it first if needed.
+      * @param filename - Where to write the matrix
+      * @return - false if it could not be built or written
+      */
+      bool saveHopMatrix(const std::string& filename);
+
+      /**
+      * Reads a flight-count matrix written by saveHopMatrix, so it does not
+      * have to be built.
+      * @param filename - The file to read
+      * @return - false if the file is missing or damaged, or was built for
+      * other airports or flights
+      */
+      bool loadHopMatrix(const std::string& filename);
+
+      /**
+      * Looks up the fewest flights from one airport to another in the
+      * flight-count matrix, building it on the first call.
+      * @param s - The starting airport
+      * @param d - The destination airport
+      * @return - The number of flights, or HopMatrix::Unreached if d can't be
+      * reached from s or either is not an airport
+      */
+      unsigned getFewestHops(Vertex s, Vertex d);
+
+      /**
+      * Whether d can be reached from s within maxHops flights, answered from
+      * the flight-count matrix, which is built on the first call.
+      * @param s - The starting airport
+      * @param d - The destination airport
+      * @param maxHops - The most flights allowed
+      */
+      bool isWithinHops(Vertex s, Vertex d, unsigned maxHops);
+
       /**
       * Prints the result from the shortest path determined by a BFS traversal.
       * @param s - Starting airport
@@ -112,7 +355,8 @@ class safeCovid
       * @param start - Starting airport
       * @param landmark - Landmark airport to visit along the way
       * @param destination - Destination airport
-      * @return - vector where each entry is the IATA code for each airport along the path.
+      * @return - vector where each entry is the IATA code for each airport along the path,
+      * starting airport first; empty if there is no route through the landmark.
       */
       vector<std::string> getPathLandmarkBFS(Vertex start, Vertex landmark, Vertex destination);
 
@@ -132,6 +376,66 @@ class safeCovid
       */
       void DijkstraSSSP(Vertex start);
 
+      /**
+      * Returns how many airports the last Dijkstra search settled.
+      * A full DijkstraSSSP settles every reachable airport, while
+      * getPathDijkstra stops as soon as the destination is settled.
+      * @return - number of settled airports
+      */
+      size_t getSettledCount() const;
+
+      /**
+      * Chooses how getPathDijkstra searches. Unidirectional, Bidirectional,
+      * ALT, CH, CCH and HubLabel find equally safe paths with the same number of flights, but when
+      * several such paths exist they may pick different ones. All of them
+      * rank paths by Johnson-reduced weights (see CSRGraph::feasiblePotential),
+      * which shift every route between two airports by the same amount, so
+      * they agree even when setPerson leaves some flights with negative risk.
+      * AStar instead
+      * finds the path with the least flight distance stretched by risk.
+      * @param mode - the search to use
+      */
+      void setQueryMode(QueryMode mode);
+
+      /**
+      * Returns how getPathDijkstra searches.
+      * @return - the search in use
+      */
+      QueryMode getQueryMode() const;
+
+      /**
+      * Sets how many landmarks the ALT query mode precomputes distances for.
+      * Each one takes two distance tables over all airports; more landmarks
+      * give tighter bounds, so queries settle fewer airports. The tables are
+      * rebuilt on the next ALT query.
+      * @param count - number of landmarks
+      */
+      void setALTLandmarkCount(unsigned count);
+
+      /**
+      * Returns how many landmarks the ALT query mode uses.
+      * @return - number of landmarks
+      */
+      unsigned getALTLandmarkCount() const;
+
+      /**
+      * Writes the contraction hierarchy used by the CH query mode to a file,
+      * building it first if needed.
+      * @param filename - where to write the hierarchy
+      * @return - false if it could not be written, or the weights have a
+      * negative cycle and there is no hierarchy
+      */
+      bool saveHierarchy(const std::string& filename);
+
+      /**
+      * Reads a contraction hierarchy for the CH query mode from a file,
+      * so it does not have to be built on the first query.
+      * @param filename - a file written by saveHierarchy
+      * @return - false if the file is missing or damaged, or was built
+      * for another graph or other weights
+      */
+      bool loadHierarchy(const std::string& filename);
+
       /**
       * Uses Dijkstra's algorithm to determine the safest path from a starting location
       * to an end location. This takes COVID rates into account and
@@ -156,7 +460,8 @@ class safeCovid
       * @param start - The starting airport
       * @param landmark - Landmark airport to visit along the way
       * @param dest - The destination airport
-      * @return - vector where each entry is the IATA code for each airport along the path.
+      * @return - vector where each entry is the IATA code for each airport along the path,
+      * starting airport first; empty if there is no route through the landmark.
       */
       vector<std::string> getPathLandmarkDijkstra(Vertex start, Vertex landmark, Vertex destination);
 
@@ -171,16 +476,125 @@ class safeCovid
 
     private:
       Graph airportGraph;
+      CSRGraph network;
       person person_;
       Vertex startVertex;
 
-      // Variables for the BFS functions
-      std::unordered_map<std::string, std::string> explore_vertices;
-      std::unordered_map<std::string, std::string> explore_edges;
-      std::unordered_map<std::string, std::string> pred_vertex;
+      // Variables for the BFS functions, indexed by VertexId
+      std::vector<char> explored;
+      std::vector<VertexId> bfsPred;
+      std::vector<VertexId> bfsQueue;
+
+      // Variables for Dijkstra algorithm, indexed by VertexId
+      std::vector<double> dist;
+      std::vector<VertexId> pred;
+      std::vector<char> settled;
+      std::vector<unsigned> hops;
+      std::vector<VertexId> reached;
+      IndexedHeap<std::pair<double, unsigned>> pqueue;
+      size_t settledCount = 0;
+
+      // Reweights the Dijkstra search so that no edge is negative, see
+      // CSRGraph::feasiblePotential; found on the first search after the
+      // network changes, and all zero if the network has a negative cycle
+      std::vector<double> potential;
+      bool potentialReady = false;
+      QueryMode queryMode = Unidirectional;
+
+      // Built on the first bidirectional query after the network changes
+      BidirectionalDijkstra bidirectional;
+      bool bidirectionalReady = false;
+
+      // Used by getPathBFS, built on the first query after the network changes
+      BidirectionalBFS hopSearch;
+      bool hopSearchReady = false;
+
+      // Used by getHopLayers, built on the first call after the network changes
+      DirectionOptimizingBFS hopLayers;
+      bool hopLayersReady = false;
+
+      // Used by getFewestHops and isWithinHops, and by getPathBFS to rule
+      // out pairs, once built or loaded; kept while the airports and flights
+      // stay the same
+      HopMatrix hopMatrix;
+      bool hopMatrixReady = false;
+
+      // Used by the AStar query mode, built on the first query after the network changes
+      AirportLocations locations;
+      AStarSearch aStar;
+      bool aStarReady = false;
+
+      // Used by the ALT query mode, built on the first query after the network changes
+      ALTSearch alt;
+      unsigned altLandmarkCount = 8;
+      bool altReady = false;
+
+      // Used by the CH query mode, built on the first query after the network changes
+      ContractionHierarchy hierarchy;
+      bool hierarchyReady = false;
+
+      // Used by the CCH query mode; the order is kept while the airports and
+      // flights stay the same, and new weights are applied on the next query
+      CustomizableHierarchy customizable;
+      bool customizableReady = false;
+
+      // Used by the HubLabel query mode, built on the first query after the network changes
+      HubLabels hubLabels;
+      bool hubLabelsReady = false;
+
+      // Kept by getHopTree and getRiskTree until the network changes; the
+      // oldest is replaced once all the slots are taken. Room for every slot
+      // is reserved up front, so only replacing a tree moves it and a
+      // returned reference stays valid until then
+      const static size_t treeSlots = 16;
+      std::vector<ShortestPathTree> trees;
+      size_t nextTree = 0;
+
+      // Used by getRiskTable on the CH query mode's hierarchy
+      DistanceTable distanceTable;
+
+      /**
+      * Builds the flight-count matrix with one thread per core if it is not
+      * ready.
+      * @return - whether the matrix is ready
+      */
+      bool prepareHopMatrix();
+
+      /**
+      * Returns a kept tree with the given root and metric, or NULL.
+      */
+      const ShortestPathTree* findTree(VertexId root, ShortestPathTree::Metric metric) const;
 
-      // Variables for Dijkstra algorithm
-      Graph dijkstraGraph;
-      std::map<Vertex, Vertex> p;
-      std::map<Vertex, double> d;
+      /**
+      * Returns a kept tree with the given root and metric, growing and
+      * keeping one if there is none.
+      */
+      const ShortestPathTree& keepTree(VertexId root, ShortestPathTree::Metric metric);
+
+      /**
+      * Runs Dijkstra's algorithm from start, filling dist, pred and settled.
+      * The search runs on weights reduced by the potential, so negative
+      * weights are fine as long as no cycle is negative; dist holds the
+      * reduced distances.
+      * @param startId - ID of the airport to start from
+      * @param target - ID of an airport to stop at once it is settled,
+      * or Graph::InvalidVertexId to search the whole graph
+      */
+      void DijkstraSearch(VertexId startId, VertexId target);
+
+      /**
+      * Returns a potential that makes every reduced weight of the network
+      * non-negative, finding it if the network changed.
+      */
+      const std::vector<double>& reducingPotential();
+
+      /**
+      * Turns a path found by one of the search engines into airport codes.
+      * @param ids - IDs along the path, starting airport first
+      * @param s - The starting airport
+      * @param d - The destination airport
+      * @return - IATA codes starting from the destination, or just d and s
+      * if no path was found
+      */
+      vector<std::string> namePath(const vector<VertexId>& ids, Vertex s, Vertex d) const;
 };
@@ -0,0 +1,222 @@
+#include "shortestPathTree.h"
+#include "indexedHeap.h"
+
+#include <climits>
+#include <limits>
+#include <utility>
+
+const unsigned ShortestPathTree::Unreached = UINT_MAX;
+
+namespace
+{
+
+const double Infinity = std::numeric_limits<double>::infinity();
+
+/**
+ * Returns a potential that makes every reduced weight of a graph
+ * non-negative, or all zeros if the graph has a negative cycle.
+ */
+std::vector<double> reducingPotential(const CSRGraph& g)
+{
+    std::vector<double> potential;
+    if (!g.feasiblePotential(potential))
+        potential.assign(g.vertexCount(), 0.0);
+    return potential;
+}
+
+} // namespace
+
+/**
+ * Constructs an empty tree that reaches nothing.
+ */
+ShortestPathTree::ShortestPathTree() : root(Graph::InvalidVertexId), metric(Hops)
+{
+}
+
+/**
+ * Searches a graph from a root. A Risk tree first finds a potential for
+ * the graph, which takes a Bellman-Ford pass.
+ * @param g - the graph to search
+ * @param root - ID of the vertex to start from; if it is not a vertex
+ *               the tree reaches nothing
+ * @param metric - what the routes minimize
+ */
+ShortestPathTree::ShortestPathTree(const CSRGraph& g, VertexId root, Metric metric)
+    : ShortestPathTree(g, root, metric, metric == Risk ? reducingPotential(g) : std::vector<double>())
+{
+}
+
+/**
+ * Searches a graph from a root, reducing the weights of a Risk tree by
+ * a potential that was already found.
+ * @param g - the graph to search
+ * @param root - ID of the vertex to start from; if it is not a vertex
+ *               the tree reaches nothing
+ * @param metric - what the routes minimize
+ * @param potential - one value per vertex that makes every reduced
+ *                    weight non-negative; not used by a Hops tree
+ */
+ShortestPathTree::ShortestPathTree(const CSRGraph& g, VertexId root, Metric metric,
+                                   const std::vector<double>& potential)
+    : root(root), metric(metric), distances(g.vertexCount(), Infinity), edges(g.vertexCount(), Unreached),
+      parents(g.vertexCount(), Graph::InvalidVertexId)
+{
+    if (root >= g.vertexCount())
+        return;
+    distances[root] = 0;
+    edges[root] = 0;
+    if (metric == Hops)
+        searchHops(g);
+    else
+        searchRisk(g, potential);
+}
+
+/**
+ * Returns the ID of the vertex the tree was grown from.
+ */
+VertexId ShortestPathTree::getRoot() const
+{
+    return root;
+}
+
+/**
+ * Returns what the tree's routes minimize.
+ */
+ShortestPathTree::Metric ShortestPathTree::getMetric() const
+{
+    return metric;
+}
+
+/**
+ * Whether the root can reach a vertex.
+ * @param v - ID of the vertex
+ */
+bool ShortestPathTree::reaches(VertexId v) const
+{
+    return v < edges.size() && edges[v] != Unreached;
+}
+
+/**
+ * Returns the distance from the root: edges for a Hops tree, total
+ * weight for a Risk tree.
+ * @param v - ID of the vertex
+ * @return - the distance, or infinity if v is not reached
+ */
+double ShortestPathTree::distance(VertexId v) const
+{
+    return v < distances.size() ? distances[v] : Infinity;
+}
+
+/**
+ * Returns how many edges the tree's route from the root to a vertex
+ * takes.
+ * @param v - ID of the vertex
+ * @return - the count, or Unreached if v is not reached
+ */
+unsigned ShortestPathTree::hops(VertexId v) const
+{
+    return v < edges.size() ? edges[v] : Unreached;
+}
+
+/**
+ * Returns the vertex before v on the tree's route from the root.
+ * @param v - ID of the vertex
+ * @return - the parent, or Graph::InvalidVertexId for the root and for
+ *           vertices that are not reached
+ */
+VertexId ShortestPathTree::parent(VertexId v) const
+{
+    return v < parents.size() ? parents[v] : Graph::InvalidVertexId;
+}
+
+/**
+ * Writes out the tree's route from the root to a vertex.
+ * @param destination - ID of the vertex to reach
+ * @param path - filled with the IDs along the route, root first; left
+ *               empty if destination is not reached
+ * @return - whether destination is reached
+ */
+bool ShortestPathTree::pathTo(VertexId destination, std::vector<VertexId>& path) const
+{
+    path.clear();
+    if (!reaches(destination))
+        return false;
+    // the length is known, so the route is written back to front in place
+    path.resize(edges[destination] + 1);
+    VertexId v = destination;
+    for (size_t i = path.size(); i > 0; i--)
+    {
+        path[i - 1] = v;
+        v = parents[v];
+    }
+    return true;
+}
+
+/**
+ * Returns how many vertices the tree covers.
+ */
+size_t ShortestPathTree::vertexCount() const
+{
+    return parents.size();
+}
+
+/**
+ * Fills the arrays with a breadth-first search.
+ */
+void ShortestPathTree::searchHops(const CSRGraph& g)
+{
+    // every vertex is queued at most once, so the queue is a plain array
+    std::vector<VertexId> queue;
+    queue.reserve(g.vertexCount());
+    queue.push_back(root);
+    for (size_t head = 0; head < queue.size(); head++)
+    {
+        VertexId u = queue[head];
+        for (uint32_t e = g.edgeBegin(u); e < g.edgeEnd(u); e++)
+        {
+            VertexId v = g.target(e);
+            if (edges[v] != Unreached)
+                continue;
+            edges[v] = edges[u] + 1;
+            distances[v] = edges[v];
+            parents[v] = u;
+            queue.push_back(v);
+        }
+    }
+}
+
+/**
+ * Fills the arrays with Dijkstra's algorithm on reduced weights, then
+ * turns the distances back into plain weights.
+ */
+void ShortestPathTree::searchRisk(const CSRGraph& g, const std::vector<double>& potential)
+{
+    IndexedHeap<std::pair<double, unsigned>> queue(g.vertexCount());
+    std::vector<char> settled(g.vertexCount(), 0);
+    queue.push(root, std::make_pair(0.0, 0u));
+    while (!queue.empty())
+    {
+        VertexId u = queue.pop();
+        settled[u] = 1;
+        for (uint32_t e = g.edgeBegin(u); e < g.edgeEnd(u); e++)
+        {
+            VertexId v = g.target(e);
+            if (settled[v])
+                continue;
+            // summed in the same order as safeCovid::DijkstraSearch, so that
+            // ties come out the same
+            double risk = g.weight(e) + potential[u] - potential[v] + distances[u];
+            unsigned flights = edges[u] + 1;
+            if (risk < distances[v] || (risk == distances[v] && flights < edges[v]))
+            {
+                distances[v] = risk;
+                edges[v] = flights;
+                parents[v] = u;
+                queue.decreaseKey(v, std::make_pair(risk, flights));
+            }
+        }
+    }
+    for (VertexId v = 0; v < g.vertexCount(); v++)
+        if (edges[v] != Unreached)
+            distances[v] += potential[v] - potential[root];
+}
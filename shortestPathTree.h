@@ -0,0 +1,144 @@
+/**
+ * @file shortestPathTree.h
+ * Fewest-flight or safest routes from one airport to every airport.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "csrGraph.h"
+
+/**
+ * The result of one full search from a root: for every vertex the
+ * distance from the root and its parent on a best route, in flat arrays
+ * indexed by vertex ID.
+ *
+ * A tree is built once per origin and then answers any number of
+ * destinations. A route is read off by following parents from the
+ * destination back to the root; the number of edges on it is stored, so
+ * the route is written straight into place in time proportional to its
+ * length, with no search and nothing to reset afterwards.
+ *
+ * Hops trees come from a breadth-first search and count edges. Risk trees
+ * come from Dijkstra's algorithm over the weights reduced by a potential
+ * (see CSRGraph::feasiblePotential), ranking routes of equal weight by how
+ * many edges they take, exactly like safeCovid::getPathDijkstra, so the
+ * two agree on every route. Negative weights are fine as long as no cycle
+ * is negative; with a negative cycle no route is safest, and the tree is
+ * what Dijkstra's algorithm makes of the plain weights.
+ */
+class ShortestPathTree
+{
+  public:
+    /**
+     * What a tree minimizes.
+     */
+    enum Metric
+    {
+        Hops, /**< the number of edges **/
+        Risk  /**< the total weight, then the number of edges **/
+    };
+
+    /**
+     * Constructs an empty tree that reaches nothing.
+     */
+    ShortestPathTree();
+
+    /**
+     * Searches a graph from a root.
+     * @param g - the graph to search
+     * @param root - ID of the vertex to start from; if it is not a vertex
+     *               the tree reaches nothing
+     * @param metric - what the routes minimize
+     */
+    ShortestPathTree(const CSRGraph& g, VertexId root, Metric metric);
+
+    /**
+     * Searches a graph from a root, reducing the weights of a Risk tree by
+     * a potential that was already found, e.g. one kept for many trees.
+     * @param g - the graph to search
+     * @param root - ID of the vertex to start from; if it is not a vertex
+     *               the tree reaches nothing
+     * @param metric - what the routes minimize
+     * @param potential - one value per vertex that makes every reduced
+     *                    weight non-negative; not used by a Hops tree
+     */
+    ShortestPathTree(const CSRGraph& g, VertexId root, Metric metric, const std::vector<double>& potential);
+
+    /**
+     * Returns the ID of the vertex the tree was grown from.
+     */
+    VertexId getRoot() const;
+
+    /**
+     * Returns what the tree's routes minimize.
+     */
+    Metric getMetric() const;
+
+    /**
+     * Whether the root can reach a vertex.
+     * @param v - ID of the vertex
+     */
+    bool reaches(VertexId v) const;
+
+    /**
+     * Returns the distance from the root: edges for a Hops tree, total
+     * weight for a Risk tree.
+     * @param v - ID of the vertex
+     * @return - the distance, or infinity if v is not reached
+     */
+    double distance(VertexId v) const;
+
+    /**
+     * Returns how many edges the tree's route from the root to a vertex
+     * takes.
+     * @param v - ID of the vertex
+     * @return - the count, or Unreached if v is not reached
+     */
+    unsigned hops(VertexId v) const;
+
+    /**
+     * Returns the vertex before v on the tree's route from the root.
+     * @param v - ID of the vertex
+     * @return - the parent, or Graph::InvalidVertexId for the root and for
+     *           vertices that are not reached
+     */
+    VertexId parent(VertexId v) const;
+
+    /**
+     * Writes out the tree's route from the root to a vertex.
+     * @param destination - ID of the vertex to reach
+     * @param path - filled with the IDs along the route, root first; left
+     *               empty if destination is not reached
+     * @return - whether destination is reached
+     */
+    bool pathTo(VertexId destination, std::vector<VertexId>& path) const;
+
+    /**
+     * Returns how many vertices the tree covers.
+     */
+    size_t vertexCount() const;
+
+    /** hops result for a vertex that is not reached. */
+    const static unsigned Unreached;
+
+  private:
+    VertexId root;
+    Metric metric;
+    std::vector<double> distances;
+    std::vector<unsigned> edges; /**< Edges on the tree's route, Unreached if none **/
+    std::vector<VertexId> parents;
+
+    /**
+     * Fills the arrays with a breadth-first search.
+     */
+    void searchHops(const CSRGraph& g);
+
+    /**
+     * Fills the arrays with Dijkstra's algorithm on reduced weights, then
+     * turns the distances back into plain weights.
+     */
+    void searchRisk(const CSRGraph& g, const std::vector<double>& potential);
+};
@@ -3,6 +3,28 @@
 
 #include "../safecovid.h"
 #include "../airportGraph.h"
+#include "../graphBuilder.h"
+#include "../routeFile.h"
+#include "../graphSnapshot.h"
+#include "../csrGraph.h"
+#include "../indexedHeap.h"
+#include "../bidirectionalBFS.h"
+#include "../directionOptimizingBFS.h"
+#include "../multiSourceBFS.h"
+#include "../hopMatrix.h"
+#include "../riskMatrix.h"
+#include "../aStarSearch.h"
+#include "../altSearch.h"
+#include "../contractionHierarchy.h"
+#include "../customizableHierarchy.h"
+#include "../hubLabels.h"
+#include "../shortestPathTree.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
 
 safeCovid temp("data/edges.txt");
 
@@ -41,6 +63,282 @@ TEST_CASE("Existence of edges in graph") {
   REQUIRE( graph_.assertEdgeExists("RUH","ISB","1"));
 }
 
+TEST_CASE("GraphBuilder matches per-row inserts") {
+  Graph rowByRow(true, true);
+  GraphBuilder builder;
+  const char* routes[][2] = {{"AER","KZN"}, {"ASF","KZN"}, {"ASF","MRV"}, {"AER","KZN"}, {"KZN","AER"}};
+  for (auto& r : routes) {
+    rowByRow.insertVertex(r[0]);
+    rowByRow.insertVertex(r[1]);
+    builder.addVertex(r[0]);
+    builder.addVertex(r[1]);
+  }
+  for (auto& r : routes) {
+    rowByRow.insertEdge(r[0], r[1]);
+    builder.addEdge(r[0], r[1]);
+  }
+  Graph bulk(true, true);
+  builder.build(bulk);
+
+  REQUIRE( bulk.getVertices().size() == rowByRow.getVertices().size() );
+  REQUIRE( bulk.getEdges().size() == rowByRow.getEdges().size() );
+  REQUIRE( bulk.getEdges().size() == 4 );
+  for (Edge e : rowByRow.getEdges())
+    REQUIRE( bulk.edgeExists(e.source, e.dest) );
+  REQUIRE_FALSE( bulk.edgeExists("MRV", "ASF") );
+}
+
+TEST_CASE("RouteFile reads source and destination codes") {
+  RouteFile routes("data/edges.txt");
+  REQUIRE( routes.isOpen() );
+  vector<std::string> first;
+  size_t rows = routes.forEachRoute([&first](const Field& source, const Field& dest) {
+    if (first.empty()) {
+      first.push_back(source.str());
+      first.push_back(dest.str());
+    }
+  });
+  REQUIRE( rows == 67663 );
+  REQUIRE( first[0] == "AER" );
+  REQUIRE( first[1] == "KZN" );
+
+  const char text[] = "2B,410,AER,2965,KZN,2990,,0,CR2\r\nshort,row\nXX,1,ORD,2,MNL,3";
+  vector<std::string> codes;
+  rows = RouteFile::forEachRoute(text, text + sizeof(text) - 1, [&codes](const Field& source, const Field& dest) {
+    codes.push_back(source.str() + "-" + dest.str());
+  });
+  REQUIRE( rows == 2 );
+  REQUIRE( codes[0] == "AER-KZN" );
+  REQUIRE( codes[1] == "ORD-MNL" );
+  REQUIRE_FALSE( RouteFile().open("data/missing.txt") );
+}
+
+TEST_CASE("Parallel route parsing matches a single pass") {
+  RouteFile routes("data/edges.txt");
+  vector<std::string> serial;
+  routes.forEachRoute([&serial](const Field& source, const Field& dest) {
+    serial.push_back(source.str() + dest.str());
+  });
+  for (unsigned threads = 2; threads <= 7; threads += 5) {
+    vector<std::string> parallel;
+    size_t rows = routes.forEachRouteParallel(threads, [&parallel](const Field& source, const Field& dest) {
+      parallel.push_back(source.str() + dest.str());
+    });
+    REQUIRE( rows == serial.size() );
+    REQUIRE( parallel == serial );
+  }
+
+  // per-chunk builders merged in order number the vertices like one pass
+  GraphBuilder single;
+  routes.forEachRoute([&single](const Field& source, const Field& dest) {
+    single.addEdge(source.str(), dest.str());
+  });
+  Graph expected(true, true);
+  single.build(expected);
+  vector<GraphBuilder> chunks;
+  size_t rows = routes.forEachRouteParallel(3, chunks, [](GraphBuilder& chunk, const Field& source, const Field& dest) {
+    chunk.addEdge(source.str(), dest.str());
+  });
+  REQUIRE( rows == serial.size() );
+  REQUIRE( chunks.size() == 3 );
+  GraphBuilder merged;
+  for (const GraphBuilder& chunk : chunks)
+    merged.append(chunk);
+  REQUIRE( merged.edgeCount() == single.edgeCount() );
+  Graph built(true, true);
+  merged.build(built);
+  REQUIRE( built.getEdges().size() == expected.getEdges().size() );
+  bool sameIds = true;
+  size_t vertices = expected.getVertices().size();
+  for (VertexId id = 0; id < vertices; id++)
+    sameIds = sameIds && built.getVertexName(id) == expected.getVertexName(id);
+  REQUIRE( sameIds );
+}
+
+TEST_CASE("Graph snapshots round-trip") {
+  Graph original = temp.getAirportGraph();
+  const std::string path = "data/tests_snapshot.graph";
+  REQUIRE( GraphSnapshot::save(original, path, 42) );
+
+  Graph loaded(true, true);
+  REQUIRE( GraphSnapshot::load(loaded, path, 42) );
+  REQUIRE( loaded.getVertices().size() == original.getVertices().size() );
+  REQUIRE( loaded.getEdges().size() == original.getEdges().size() );
+  REQUIRE( loaded.getEdgeLabel("CEK","KZN") == "CEK_KZN" );
+  REQUIRE( loaded.getEdgeWeight("CEK","KZN") == original.getEdgeWeight("CEK","KZN") );
+  REQUIRE( loaded.edgeExists("DEN","AIA") );
+
+  Graph rejected(true, true);
+  REQUIRE_FALSE( GraphSnapshot::load(rejected, path, 43) );
+  REQUIRE_FALSE( GraphSnapshot::load(rejected, "data/missing.graph", 42) );
+
+  {
+    MappedFile full(path);
+    std::ofstream truncated("data/tests_truncated.graph", std::ios::binary);
+    truncated.write(full.data(), full.size() - 1);
+  }
+  REQUIRE_FALSE( GraphSnapshot::load(rejected, "data/tests_truncated.graph", 42) );
+  REQUIRE( rejected.getVertices().empty() );
+
+  std::remove(path.c_str());
+  std::remove("data/tests_truncated.graph");
+}
+
+TEST_CASE("Snapshots are only written when asked for") {
+  std::remove("data/edges.txt.graph");
+  safeCovid plain("data/edges.txt");
+  REQUIRE_FALSE( MappedFile("data/edges.txt.graph").isOpen() );
+
+  const std::string path = "data/tests_safecovid.graph";
+  std::remove(path.c_str());
+  {
+    safeCovid written("data/edges.txt", person(), 0, path);
+  }
+  REQUIRE( MappedFile(path).isOpen() );
+  safeCovid loaded("data/edges.txt", person(), 0, path);
+  Graph expected = plain.getAirportGraph();
+  Graph fromSnapshot = loaded.getAirportGraph();
+  REQUIRE( fromSnapshot.getVertices().size() == expected.getVertices().size() );
+  REQUIRE( fromSnapshot.getEdges().size() == expected.getEdges().size() );
+  REQUIRE( fromSnapshot.getEdgeLabel("CEK","KZN") == "CEK_KZN" );
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Dense vertex IDs") {
+  Graph g(true, true);
+  g.insertVertex("ORD");
+  g.insertEdge("ORD", "NRT");
+  g.insertVertex("NRT");
+  g.insertEdge("NRT", "MNL");
+  REQUIRE( g.getVertexId("ORD") == 0 );
+  REQUIRE( g.getVertexId("NRT") == 1 );
+  REQUIRE( g.getIdCount() == 2 );
+  REQUIRE( g.getVertexId("MNL") == Graph::InvalidVertexId );
+  REQUIRE( g.getVertexName(1) == "NRT" );
+  REQUIRE( g.getVertexName(7) == Graph::InvalidVertex );
+  REQUIRE( g.edgeExists(VertexId(0), VertexId(1)) );
+  REQUIRE( g.getAdjacentIds(0) == vector<VertexId>(1, 1) );
+
+  g.removeVertex("ORD");
+  REQUIRE_FALSE( g.vertexExists(VertexId(0)) );
+  g.insertVertex("ORD");
+  REQUIRE( g.getVertexId("ORD") == 0 );
+  REQUIRE( g.getIdCount() == 2 );
+
+  Graph airports = temp.getAirportGraph();
+  REQUIRE( airports.getIdCount() == airports.getVertices().size() );
+  VertexId aer = airports.getVertexId("AER");
+  VertexId kzn = airports.getVertexId("KZN");
+  REQUIRE( aer == 0 );
+  REQUIRE( kzn == 1 );
+  REQUIRE( airports.edgeExists(aer, kzn) );
+  REQUIRE( airports.getAdjacentIds(aer).size() == airports.getAdjacent("AER").size() );
+  bool roundTrip = true;
+  for (VertexId id = 0; id < airports.getIdCount(); id++)
+    roundTrip = roundTrip && airports.getVertexId(airports.getVertexName(id)) == id;
+  REQUIRE( roundTrip );
+}
+
+TEST_CASE("CSR view matches the graph") {
+  Graph graph_ = temp.getAirportGraph();
+  CSRGraph csr(graph_);
+  REQUIRE( csr.vertexCount() == graph_.getIdCount() );
+  REQUIRE( csr.edgeCount() == graph_.getEdges().size() );
+
+  VertexId ycu = graph_.getVertexId("YCU");
+  VertexId ctu = graph_.getVertexId("CTU");
+  REQUIRE( csr.degree(ycu) == graph_.getAdjacent("YCU").size() );
+  uint32_t e = csr.findEdge(ycu, ctu);
+  REQUIRE( e != CSRGraph::InvalidEdgeIndex );
+  REQUIRE( csr.target(e) == ctu );
+  REQUIRE( csr.weight(e) == graph_.getEdgeWeight("YCU", "CTU") );
+  REQUIRE( csr.findEdge(graph_.getVertexId("AIA"), graph_.getVertexId("DEN")) == CSRGraph::InvalidEdgeIndex );
+
+  bool matches = true;
+  for (VertexId v = 0; v < csr.vertexCount(); v++) {
+    for (uint32_t i = csr.edgeBegin(v); i < csr.edgeEnd(v); i++) {
+      matches = matches && graph_.edgeExists(v, csr.target(i));
+      matches = matches && (i == csr.edgeBegin(v) || csr.target(i - 1) < csr.target(i));
+    }
+  }
+  REQUIRE( matches );
+}
+
+TEST_CASE("Neighbor iteration without copies") {
+  Graph graph_ = temp.getAirportGraph();
+  const CSRGraph& csr = temp.getNetwork();
+
+  vector<Vertex> fromGraph;
+  graph_.forEachNeighbor("YCU", [&fromGraph](const Vertex& w, double) { fromGraph.push_back(w); });
+  vector<Vertex> adjacent = graph_.getAdjacent("YCU");
+  std::sort(fromGraph.begin(), fromGraph.end());
+  std::sort(adjacent.begin(), adjacent.end());
+  REQUIRE( fromGraph == adjacent );
+  REQUIRE( graph_.getDegree("YCU") == adjacent.size() );
+  REQUIRE( graph_.getDegree("_NOT_AN_AIRPORT") == 0 );
+
+  VertexId ycu = graph_.getVertexId("YCU");
+  vector<VertexId> fromRange;
+  for (Neighbor n : csr.neighbors(ycu)) {
+    fromRange.push_back(n.id);
+    REQUIRE( n.weight == graph_.getEdgeWeight(ycu, n.id) );
+  }
+  vector<VertexId> fromCallback;
+  csr.forEachNeighbor(ycu, [&fromCallback](VertexId w, double) { fromCallback.push_back(w); });
+  REQUIRE( fromRange == fromCallback );
+  REQUIRE( fromRange.size() == csr.neighbors(ycu).size() );
+  REQUIRE( fromRange.size() == adjacent.size() );
+}
+
+/**
+ * Pushes keys with scrambled priorities, lowers some of them and checks
+ * that everything comes back out in priority order.
+ */
+template <unsigned Arity>
+void checkIndexedHeap() {
+  const unsigned count = 200;
+  IndexedHeap<double, Arity> h (count);
+  vector<double> expected (count);
+  for (unsigned k = 0; k < count; k++) {
+    expected[k] = (k * 37) % count;
+    h.push(k, expected[k]);
+  }
+  REQUIRE( h.size() == count );
+  REQUIRE( h.contains(7) );
+  for (unsigned k = 0; k < count; k += 3) {
+    expected[k] -= 50.5;
+    REQUIRE( h.decreaseKey(k, expected[k]) );
+  }
+  REQUIRE( !h.decreaseKey(1, expected[1] + 1) );
+  REQUIRE( h.priority(1) == expected[1] );
+
+  double last = -1000;
+  unsigned popped = 0;
+  while (!h.empty()) {
+    REQUIRE( h.topPriority() >= last );
+    last = h.topPriority();
+    IndexedHeap<>::Key k = h.pop();
+    REQUIRE( expected[k] == last );
+    REQUIRE( !h.contains(k) );
+    popped++;
+  }
+  REQUIRE( popped == count );
+
+  h.push(5, 2.0);
+  h.push(9, 1.0);
+  h.push(5, 0.5);
+  REQUIRE( h.top() == 5 );
+  h.clear();
+  REQUIRE( h.empty() );
+  REQUIRE( !h.contains(5) );
+}
+
+TEST_CASE("Indexed heap decrease-key") {
+  checkIndexedHeap<2>();
+  checkIndexedHeap<4>();
+  checkIndexedHeap<8>();
+}
+
 TEST_CASE("Edge labels") {
   Graph graph_ = temp.getAirportGraph();
   REQUIRE( graph_.getEdgeLabel("YCU","CTU") == "YCU_CTU");
@@ -52,28 +350,34 @@ TEST_CASE("Edge labels") {
 TEST_CASE("BFS function") {
   vector<std::string> bfs_path = temp.getPathBFS("BDJ", "MPL");
   REQUIRE(bfs_path[0] == "MPL");
-  REQUIRE(bfs_path[1] == "FCO");
-  REQUIRE(bfs_path[2] == "SIN");
-  REQUIRE(bfs_path[3] == "JOG");
+  REQUIRE(bfs_path[1] == "LGW");
+  REQUIRE(bfs_path[2] == "DXB");
+  REQUIRE(bfs_path[3] == "CGK");
   REQUIRE(bfs_path[4] == "BDJ");
 }
 
 TEST_CASE("BFS landmark function") {
   vector<std::string> landmark_path = temp.getPathLandmarkBFS("NTE", "GYE", "CGK");
+  REQUIRE(landmark_path.size() == 6);
   REQUIRE(landmark_path[0] == "NTE");
   REQUIRE(landmark_path[1] == "MAD");
   REQUIRE(landmark_path[2] == "GYE");
-  REQUIRE(landmark_path[3] == "MAD");
-  REQUIRE(landmark_path[4] == "BKK");
+  REQUIRE(landmark_path[3] == "AMS");
+  REQUIRE(landmark_path[4] == "DXB");
   REQUIRE(landmark_path[5] == "CGK");
+  // there is a GYE -> AMS flight but none back, so the first leg can't be AMS
+  Graph graph_ = temp.getAirportGraph();
+  for (unsigned i = 0; i + 1 < landmark_path.size(); i++)
+    REQUIRE( graph_.edgeExists(landmark_path[i], landmark_path[i + 1]) );
 }
 
 TEST_CASE("Dijkstra's algorithm: 1") {
   float age = 21;
   temp.setPerson(age);
   vector<std::string> dijkstra_path = temp.getPathDijkstra("ORD", "MNL");
+  REQUIRE(dijkstra_path.size() == 3);
   REQUIRE(dijkstra_path[0] == "MNL");
-  REQUIRE(dijkstra_path[1] == "NRT");
+  REQUIRE(dijkstra_path[1] == "AUH");
   REQUIRE(dijkstra_path[2] == "ORD");
 }
 
@@ -81,20 +385,981 @@ TEST_CASE("Dijkstra's algorithm: 2") {
   float age = 21;
   temp.setPerson(age);
   vector<std::string> dijkstra_path = temp.getPathDijkstra("DXB", "KEF");
+  REQUIRE(dijkstra_path.size() == 3);
   REQUIRE(dijkstra_path[0] == "KEF");
-  REQUIRE(dijkstra_path[1] == "SFB");
-  REQUIRE(dijkstra_path[2] == "FAR");
-  REQUIRE(dijkstra_path[3] == "ATL");
-  REQUIRE(dijkstra_path[4] == "DXB");
+  REQUIRE(dijkstra_path[1] == "CPH");
+  REQUIRE(dijkstra_path[2] == "DXB");
 }
 
 TEST_CASE("Dijkstra's Landmark algorithm") {
   float age = 21;
   temp.setPerson(age);
   vector<std::string> dijkstra_path = temp.getPathLandmarkDijkstra("YCU", "JOG", "RUH");
+  REQUIRE(dijkstra_path.size() == 6);
   REQUIRE(dijkstra_path[0] == "YCU");
-  REQUIRE(dijkstra_path[1] == "JOG");
-  REQUIRE(dijkstra_path[2] == "DPS");
-  REQUIRE(dijkstra_path[3] == "ICN");
-  REQUIRE(dijkstra_path[4] == "RUH");
+  REQUIRE(dijkstra_path[1] == "HGH");
+  REQUIRE(dijkstra_path[2] == "KUL");
+  REQUIRE(dijkstra_path[3] == "JOG");
+  REQUIRE(dijkstra_path[4] == "SIN");
+  REQUIRE(dijkstra_path[5] == "RUH");
+  Graph graph_ = temp.getAirportGraph();
+  for (unsigned i = 0; i + 1 < dijkstra_path.size(); i++)
+    REQUIRE( graph_.edgeExists(dijkstra_path[i], dijkstra_path[i + 1]) );
+}
+
+TEST_CASE("Dijkstra's algorithm: repeated and unknown airports") {
+  temp.setPerson(21);
+  vector<std::string> first = temp.getPathDijkstra("DXB", "KEF");
+  REQUIRE(temp.getPathDijkstra("ORD", "MNL").size() == 3);
+  REQUIRE(temp.getPathDijkstra("DXB", "KEF") == first);
+
+  vector<std::string> unknown = temp.getPathDijkstra("ORD", "_NOT_AN_AIRPORT");
+  REQUIRE(unknown.size() == 2);
+  REQUIRE(unknown[0] == "_NOT_AN_AIRPORT");
+  REQUIRE(unknown[1] == "ORD");
+}
+
+TEST_CASE("Dijkstra stops once the destination is settled") {
+  temp.setPerson(21);
+  temp.DijkstraSSSP("ORD");
+  size_t full = temp.getSettledCount();
+  REQUIRE(full > 3000);
+
+  vector<std::string> path = temp.getPathDijkstra("ORD", "MNL");
+  REQUIRE(path.size() == 3);
+  REQUIRE(temp.getSettledCount() > 0);
+  REQUIRE(temp.getSettledCount() < full);
+
+  temp.getPathDijkstra("ORD", "_NOT_AN_AIRPORT");
+  REQUIRE(temp.getSettledCount() == full);
+}
+
+/**
+ * Steps a linear congruential generator and returns its high bits, so
+ * that the randomized tests see the same numbers on every run.
+ */
+uint32_t nextRandom(uint32_t& state) {
+  state = state * 1664525u + 1013904223u;
+  return state >> 8;
+}
+
+/**
+ * Returns n pseudo-random (source, destination) pairs of vertex IDs
+ * below count, the same ones for the same seed.
+ */
+vector<std::pair<VertexId, VertexId>> randomPairs(uint32_t seed, int n, size_t count) {
+  vector<std::pair<VertexId, VertexId>> pairs;
+  uint32_t state = seed;
+  for (int i = 0; i < n; i++) {
+    VertexId s = nextRandom(state) % count;
+    pairs.push_back(std::make_pair(s, static_cast<VertexId>(nextRandom(state) % count)));
+  }
+  return pairs;
+}
+
+/**
+ * Requires a path of IDs to run from s to d along edges of the graph.
+ * @return - the total weight of the path
+ */
+double checkedPathWeight(const CSRGraph& csr, const vector<VertexId>& path, VertexId s, VertexId d) {
+  REQUIRE( path.front() == s );
+  REQUIRE( path.back() == d );
+  double total = 0;
+  for (size_t i = 0; i + 1 < path.size(); i++) {
+    uint32_t e = csr.findEdge(path[i], path[i + 1]);
+    REQUIRE( e != CSRGraph::InvalidEdgeIndex );
+    total += csr.weight(e);
+  }
+  return total;
+}
+
+/**
+ * Builds a graph of count vertices named V0, V1, ... with up to degree
+ * random flights out of each. Every weight is a non-negative base plus a
+ * potential difference, so many weights are negative but no cycle is.
+ */
+Graph feasibleRandomGraph(uint32_t seed, size_t count, int degree) {
+  Graph g(true, true);
+  vector<int> potential;
+  uint32_t state = seed;
+  for (size_t i = 0; i < count; i++) {
+    g.insertVertex("V" + std::to_string(i));
+    potential.push_back(static_cast<int>(nextRandom(state) % 7));
+  }
+  for (size_t i = 0; i < count; i++) {
+    for (int n = 0; n < degree; n++) {
+      size_t j = nextRandom(state) % count;
+      int base = static_cast<int>(nextRandom(state) % 5);
+      Vertex from = "V" + std::to_string(i);
+      Vertex to = "V" + std::to_string(j);
+      if (i != j && g.insertEdge(from, to))
+        g.setEdgeWeight(from, to, base + potential[i] - potential[j]);
+    }
+  }
+  return g;
+}
+
+/**
+ * Least total weights from a source to every vertex by Bellman-Ford,
+ * which needs no assumption about the weights beyond having no negative
+ * cycle.
+ * @return - one weight per vertex, infinity where there is no path
+ */
+vector<double> bellmanFord(const CSRGraph& csr, VertexId source) {
+  vector<double> distance(csr.vertexCount(), std::numeric_limits<double>::infinity());
+  distance[source] = 0;
+  for (size_t round = 1; round < csr.vertexCount(); round++) {
+    bool changed = false;
+    for (VertexId u = 0; u < csr.vertexCount(); u++) {
+      if (distance[u] == std::numeric_limits<double>::infinity())
+        continue;
+      for (uint32_t e = csr.edgeBegin(u); e < csr.edgeEnd(u); e++) {
+        if (distance[u] + csr.weight(e) < distance[csr.target(e)]) {
+          distance[csr.target(e)] = distance[u] + csr.weight(e);
+          changed = true;
+        }
+      }
+    }
+    if (!changed)
+      break;
+  }
+  return distance;
+}
+
+/**
+ * Requires an engine's route for one pair to match a plain forward
+ * Dijkstra's: found for the same pairs, with as many flights, and a
+ * valid path whose weight is the cost both searches report.
+ * @return - whether there is a route
+ */
+template <typename Engine>
+bool matchesForwardSearch(Engine& engine, ALTSearch& plain, const CSRGraph& csr, VertexId s, VertexId d) {
+  vector<VertexId> expected;
+  vector<VertexId> path;
+  bool found = plain.findPath(s, d, expected, false);
+  REQUIRE( engine.findPath(s, d, path) == found );
+  REQUIRE( path.size() == expected.size() );
+  if (found) {
+    REQUIRE( engine.getCost() == plain.getCost() );
+    REQUIRE( checkedPathWeight(csr, path, s, d) == plain.getCost() );
+  }
+  return found;
+}
+
+/**
+ * Requires an engine to agree with Bellman-Ford on a graph with negative
+ * weights: from every stride-th source to every destination it finds a
+ * route exactly when there is one, reports the least total weight and
+ * returns a valid path of that weight.
+ */
+template <typename Engine>
+void matchesBellmanFord(Engine& engine, const CSRGraph& csr, VertexId stride) {
+  vector<VertexId> path;
+  for (VertexId s = 0; s < csr.vertexCount(); s += stride) {
+    vector<double> expected = bellmanFord(csr, s);
+    for (VertexId d = 0; d < csr.vertexCount(); d++) {
+      bool reachable = expected[d] != std::numeric_limits<double>::infinity();
+      REQUIRE( engine.findPath(s, d, path) == reachable );
+      if (reachable) {
+        REQUIRE( engine.getCost() == expected[d] );
+        REQUIRE( checkedPathWeight(csr, path, s, d) == expected[d] );
+      }
+    }
+  }
+}
+
+/**
+ * Adds up the weights along a path returned by getPathDijkstra, which
+ * lists the destination first.
+ */
+double pathWeight(const CSRGraph& csr, const Graph& g, const vector<std::string>& path) {
+  double total = 0;
+  for (size_t i = path.size() - 1; i > 0; i--) {
+    uint32_t e = csr.findEdge(g.getVertexId(path[i]), g.getVertexId(path[i - 1]));
+    REQUIRE( e != CSRGraph::InvalidEdgeIndex );
+    total += csr.weight(e);
+  }
+  return total;
+}
+
+TEST_CASE("Bidirectional Dijkstra matches the forward search") {
+  temp.setPerson(21);
+  Graph graph_ = temp.getAirportGraph();
+  const CSRGraph& csr = temp.getNetwork();
+
+  CSRGraph reversed = csr.reversed();
+  REQUIRE( reversed.edgeCount() == csr.edgeCount() );
+  VertexId ord = graph_.getVertexId("ORD");
+  VertexId nrt = graph_.getVertexId("NRT");
+  REQUIRE( reversed.findEdge(nrt, ord) != CSRGraph::InvalidEdgeIndex );
+  vector<double> potential;
+  REQUIRE( csr.feasiblePotential(potential) );
+  for (VertexId v = 0; v < csr.vertexCount(); v++)
+    for (Neighbor n : csr.neighbors(v))
+      REQUIRE( n.weight + potential[v] - potential[n.id] >= 0 );
+
+  for (const auto& pair : randomPairs(7, 100, csr.vertexCount())) {
+    Vertex s = csr.getVertexName(pair.first);
+    Vertex d = csr.getVertexName(pair.second);
+
+    temp.setQueryMode(safeCovid::Unidirectional);
+    vector<std::string> forward = temp.getPathDijkstra(s, d);
+    temp.setQueryMode(safeCovid::Bidirectional);
+    vector<std::string> both = temp.getPathDijkstra(s, d);
+    REQUIRE( both.size() == forward.size() );
+    REQUIRE( both.front() == d );
+    REQUIRE( both.back() == s );
+    if (s != d && graph_.edgeExists(forward[1], d))
+      REQUIRE( pathWeight(csr, graph_, both) == pathWeight(csr, graph_, forward) );
+  }
+  temp.setQueryMode(safeCovid::Unidirectional);
+}
+
+TEST_CASE("Bidirectional BFS finds fewest-hop routes") {
+  const CSRGraph& csr = temp.getNetwork();
+  BidirectionalBFS search (csr);
+
+  // hop counts from a plain forward BFS
+  VertexId ord = temp.getAirportGraph().getVertexId("ORD");
+  vector<unsigned> hops (csr.vertexCount(), UINT32_MAX);
+  vector<VertexId> queue;
+  hops[ord] = 0;
+  queue.push_back(ord);
+  for (size_t head = 0; head < queue.size(); head++)
+    for (Neighbor n : csr.neighbors(queue[head]))
+      if (hops[n.id] == UINT32_MAX) {
+        hops[n.id] = hops[queue[head]] + 1;
+        queue.push_back(n.id);
+      }
+
+  vector<VertexId> path;
+  for (VertexId d = 0; d < csr.vertexCount(); d += 7) {
+    bool found = search.findPath(ord, d, path) == PathFound;
+    REQUIRE( found == (hops[d] != UINT32_MAX) );
+    if (!found) {
+      REQUIRE( path.empty() );
+      continue;
+    }
+    REQUIRE( path.size() == hops[d] + 1 );
+    checkedPathWeight(csr, path, ord, d);
+  }
+
+  REQUIRE( search.findPath(ord, ord, path) == PathFound );
+  REQUIRE( path.size() == 1 );
+  REQUIRE( temp.getPathBFS("ORD", "_NOT_AN_AIRPORT").empty() );
+}
+
+TEST_CASE("BFS traversal labels") {
+  safeCovid traversal("data/edges.txt");
+  REQUIRE(traversal.getVertexLabel("ORD") == safeCovid::Unexplored);
+  REQUIRE(traversal.getEdgeLabel("ORD", "NRT") == safeCovid::Unexplored);
+
+  traversal.BFSstart("ORD");
+  const CSRGraph& csr = traversal.getNetwork();
+  size_t discovery = 0;
+  size_t cross = 0;
+  for (VertexId v = 0; v < csr.vertexCount(); v++) {
+    REQUIRE(traversal.getVertexLabel(csr.getVertexName(v)) == safeCovid::Visited);
+    for (Neighbor n : csr.neighbors(v)) {
+      safeCovid::TraversalLabel label = traversal.getEdgeLabel(csr.getVertexName(v), csr.getVertexName(n.id));
+      REQUIRE(label != safeCovid::Unexplored);
+      if (label == safeCovid::Discovery)
+        discovery++;
+      else
+        cross++;
+    }
+  }
+  // every vertex but the traversal roots is discovered exactly once
+  REQUIRE(discovery < csr.vertexCount());
+  REQUIRE(discovery + cross == csr.edgeCount());
+  REQUIRE(traversal.getEdgeLabel("NRT", "ORD") == safeCovid::Cross);
+  REQUIRE(traversal.getEdgeLabel("ORD", "_NOT_AN_AIRPORT") == safeCovid::Unexplored);
+}
+
+TEST_CASE("Hop-bounded BFS") {
+  vector<std::string> path;
+  REQUIRE( temp.getPathBFS("BDJ", "MPL", 4, path) == PathFound );
+  REQUIRE( path.size() == 5 );
+  REQUIRE( path[0] == "MPL" );
+  REQUIRE( path[4] == "BDJ" );
+  REQUIRE( temp.getPathBFS("BDJ", "MPL", 3, path) == NoPathWithinHops );
+  REQUIRE( path.empty() );
+  REQUIRE( temp.getPathBFS("BDJ", "MPL", 0, path) == NoPathWithinHops );
+  REQUIRE( temp.getPathBFS("BDJ", "BDJ", 0, path) == PathFound );
+  REQUIRE( path.size() == 1 );
+
+  // a sink airport has no flights out, so nothing is reachable from it
+  const CSRGraph& csr = temp.getNetwork();
+  VertexId sink = 0;
+  while (csr.degree(sink) != 0)
+    sink++;
+  REQUIRE( temp.getPathBFS(csr.getVertexName(sink), "ORD", 10, path) == NoPath );
+  REQUIRE( temp.getPathBFS("ORD", "_NOT_AN_AIRPORT", 10, path) == NoPath );
+
+  // SPB is only served from SSB, which ORD can't reach, so no limit
+  // makes a difference
+  REQUIRE( temp.getPathBFS("ORD", "SPB", 2, path) == NoPath );
+  REQUIRE( path.empty() );
+  REQUIRE( temp.getPathBFS("ORD", "SPB", 0, path) == NoPath );
+  REQUIRE( temp.getPathBFS("ORD", "SPB").empty() );
+}
+
+TEST_CASE("A* with a great-circle heuristic") {
+  safeCovid located("data/edges.txt");
+  located.setPerson(21);
+  REQUIRE( located.loadCoordinates("data/airportcodes.txt") );
+  const AirportLocations& locations = located.getLocations();
+  const CSRGraph& csr = located.getNetwork();
+  Graph graph = located.getAirportGraph();
+  VertexId ord = graph.getVertexId("ORD");
+  VertexId syd = graph.getVertexId("SYD");
+  REQUIRE( locations.known(ord) );
+  REQUIRE( locations.latitude(ord) == Approx(41.9786) );
+  REQUIRE( locations.longitude(syd) == Approx(151.177) );
+  REQUIRE( locations.distanceKm(ord, syd) == Approx(14900).epsilon(0.01) );
+  REQUIRE( locations.knownCount() < csr.vertexCount() );
+
+  // A* settles less than Dijkstra but finds a route of the same cost
+  AStarSearch search(csr, locations);
+  vector<VertexId> path;
+  REQUIRE( search.findPath(ord, syd, path, false) );
+  double cost = search.getCost();
+  size_t dijkstraSettled = search.getSettledCount();
+  REQUIRE( search.findPath(ord, syd, path) );
+  REQUIRE( search.getCost() == Approx(cost) );
+  REQUIRE( search.getSettledCount() < dijkstraSettled );
+  REQUIRE( cost >= locations.distanceKm(ord, syd) );
+  REQUIRE( path.front() == ord );
+  REQUIRE( path.back() == syd );
+  double sum = 0;
+  for (size_t i = 0; i + 1 < path.size(); i++) {
+    uint32_t e = csr.findEdge(path[i], path[i + 1]);
+    REQUIRE( e != CSRGraph::InvalidEdgeIndex );
+    sum += search.edgeCost(e);
+  }
+  REQUIRE( sum == Approx(cost) );
+
+  located.setQueryMode(safeCovid::AStar);
+  vector<std::string> names = located.getPathDijkstra("ORD", "SYD");
+  REQUIRE( names.size() == path.size() );
+  REQUIRE( names.front() == "SYD" );
+  REQUIRE( names.back() == "ORD" );
+}
+
+TEST_CASE("ALT matches the forward search") {
+  temp.setPerson(21);
+  Graph graph_ = temp.getAirportGraph();
+  const CSRGraph& csr = temp.getNetwork();
+
+  ALTSearch search(csr, 4);
+  REQUIRE( search.usable() );
+  REQUIRE( search.getLandmarks().size() == 4 );
+  REQUIRE( search.tableBytes() == 2 * 4 * csr.vertexCount() * sizeof(std::pair<double, unsigned>) );
+
+  size_t plainSettled = 0;
+  size_t altSettled = 0;
+  vector<VertexId> path;
+  temp.setALTLandmarkCount(4);
+  for (const auto& pair : randomPairs(11, 100, csr.vertexCount())) {
+    VertexId s = pair.first;
+    VertexId d = pair.second;
+
+    bool found = search.findPath(s, d, path, false);
+    double cost = search.getCost();
+    size_t flights = path.size();
+    plainSettled += search.getSettledCount();
+    REQUIRE( search.findPath(s, d, path) == found );
+    altSettled += search.getSettledCount();
+    REQUIRE( path.size() == flights );
+    if (found)
+      REQUIRE( search.getCost() == cost );
+
+    temp.setQueryMode(safeCovid::Unidirectional);
+    vector<std::string> forward = temp.getPathDijkstra(csr.getVertexName(s), csr.getVertexName(d));
+    temp.setQueryMode(safeCovid::ALT);
+    vector<std::string> guided = temp.getPathDijkstra(csr.getVertexName(s), csr.getVertexName(d));
+    REQUIRE( guided.size() == forward.size() );
+    if (s != d && graph_.edgeExists(forward[1], forward[0]))
+      REQUIRE( pathWeight(csr, graph_, guided) == pathWeight(csr, graph_, forward) );
+  }
+  REQUIRE( altSettled < plainSettled );
+  temp.setQueryMode(safeCovid::Unidirectional);
+
+  // negative but feasible weights, checked against Bellman-Ford
+  for (uint32_t seed : {5u, 29u}) {
+    CSRGraph synthetic(feasibleRandomGraph(seed, 200, 3));
+    ALTSearch guided(synthetic, 4);
+    REQUIRE( guided.usable() );
+    matchesBellmanFord(guided, synthetic, 23);
+  }
+
+  // every weight is -1 before setPerson, so there are negative cycles
+  safeCovid unweighted("data/edges.txt");
+  REQUIRE( !ALTSearch(unweighted.getNetwork(), 4).usable() );
+  unweighted.setQueryMode(safeCovid::ALT);
+  REQUIRE( unweighted.getPathDijkstra("ORD", "NRT").front() == "NRT" );
+}
+
+TEST_CASE("Contraction hierarchy matches the forward search") {
+  temp.setPerson(21);
+  Graph graph_ = temp.getAirportGraph();
+  const CSRGraph& csr = temp.getNetwork();
+
+  ContractionHierarchy hierarchy(csr);
+  REQUIRE( hierarchy.usable() );
+  ALTSearch plain(csr, 0);
+  for (const auto& pair : randomPairs(13, 300, csr.vertexCount()))
+    matchesForwardSearch(hierarchy, plain, csr, pair.first, pair.second);
+
+  const std::string file = "data/tests_hierarchy.ch";
+  REQUIRE( hierarchy.save(file) );
+  ContractionHierarchy loaded;
+  REQUIRE_FALSE( loaded.usable() );
+  REQUIRE( loaded.load(file, csr) );
+  REQUIRE( loaded.shortcutCount() == hierarchy.shortcutCount() );
+  vector<VertexId> path;
+  REQUIRE( loaded.findPath(graph_.getVertexId("ORD"), graph_.getVertexId("MNL"), path) );
+  REQUIRE( path.size() == 3 );
+
+  // the loaded hierarchy spares safeCovid a second build
+  REQUIRE( temp.loadHierarchy(file) );
+  temp.setQueryMode(safeCovid::CH);
+  vector<std::string> names = temp.getPathDijkstra("ORD", "MNL");
+  REQUIRE( names.size() == 3 );
+  REQUIRE( names.front() == "MNL" );
+  REQUIRE( names.back() == "ORD" );
+  temp.setQueryMode(safeCovid::Unidirectional);
+
+  // ranks that no longer order the arcs are refused: the rank table sits
+  // just before the two offset tables at the end of the file
+  {
+    MappedFile full(file);
+    std::string bytes(full.data(), full.size());
+    size_t V = csr.vertexCount();
+    size_t ranks = bytes.size() - (V * sizeof(uint32_t) + 2 * (V + 1) * sizeof(uint32_t));
+    for (size_t v = 0; v < V; v++) {
+      uint32_t rank;
+      memcpy(&rank, &bytes[ranks + v * sizeof(rank)], sizeof(rank));
+      rank = static_cast<uint32_t>(V - 1 - rank);
+      memcpy(&bytes[ranks + v * sizeof(rank)], &rank, sizeof(rank));
+    }
+    std::ofstream reversed("data/tests_reversed.ch", std::ios::binary);
+    reversed.write(bytes.data(), bytes.size());
+  }
+  ContractionHierarchy damaged;
+  REQUIRE_FALSE( damaged.load("data/tests_reversed.ch", csr) );
+  REQUIRE_FALSE( damaged.usable() );
+  std::remove("data/tests_reversed.ch");
+
+  // negative but feasible weights, checked against Bellman-Ford
+  for (uint32_t seed : {5u, 29u}) {
+    CSRGraph synthetic(feasibleRandomGraph(seed, 200, 3));
+    ContractionHierarchy contracted(synthetic);
+    REQUIRE( contracted.usable() );
+    matchesBellmanFord(contracted, synthetic, 23);
+  }
+
+  // a hierarchy only fits the weights it was built for
+  safeCovid unweighted("data/edges.txt");
+  REQUIRE_FALSE( loaded.load(file, unweighted.getNetwork()) );
+  REQUIRE_FALSE( unweighted.loadHierarchy(file) );
+  REQUIRE_FALSE( unweighted.saveHierarchy(file) );
+  std::remove(file.c_str());
+}
+
+TEST_CASE("Customizable hierarchy follows new weights") {
+  Graph g(true, true);
+  g.insertVertex("ORD");
+  g.insertVertex("NRT");
+  g.insertVertex("MNL");
+  g.insertEdge("ORD", "NRT");
+  g.setEdgeWeight("ORD", "NRT", 1);
+  g.insertEdge("NRT", "MNL");
+  g.setEdgeWeight("NRT", "MNL", 1);
+  g.insertEdge("ORD", "MNL");
+  g.setEdgeWeight("ORD", "MNL", 5);
+  VertexId ord = g.getVertexId("ORD");
+  VertexId mnl = g.getVertexId("MNL");
+
+  CSRGraph triangle(g);
+  CustomizableHierarchy small(triangle);
+  REQUIRE_FALSE( small.usable() );
+  REQUIRE( small.customize(triangle) );
+  vector<VertexId> path;
+  REQUIRE( small.findPath(ord, mnl, path) );
+  REQUIRE( path.size() == 3 );
+  REQUIRE( small.getCost() == 2 );
+
+  // same flights, new weights: no new order needed
+  g.setEdgeWeight("ORD", "MNL", 1);
+  REQUIRE( small.customize(CSRGraph(g)) );
+  REQUIRE( small.findPath(ord, mnl, path) );
+  REQUIRE( path.size() == 2 );
+  REQUIRE( small.getCost() == 1 );
+
+  g.insertEdge("MNL", "ORD");
+  REQUIRE_FALSE( small.fits(CSRGraph(g)) );
+  REQUIRE_FALSE( small.customize(CSRGraph(g)) );
+  REQUIRE_FALSE( small.usable() );
+
+  // negative but feasible weights, then new ones on the same flights,
+  // checked against Bellman-Ford
+  Graph random = feasibleRandomGraph(5, 200, 3);
+  CSRGraph synthetic(random);
+  CustomizableHierarchy reweighted(synthetic);
+  REQUIRE( reweighted.customize(synthetic) );
+  matchesBellmanFord(reweighted, synthetic, 23);
+  uint32_t state = 29;
+  vector<int> potential;
+  for (size_t i = 0; i < random.getVertices().size(); i++)
+    potential.push_back(static_cast<int>(nextRandom(state) % 7));
+  for (const Edge& e : random.getEdges()) {
+    int base = static_cast<int>(nextRandom(state) % 5);
+    random.setEdgeWeight(e.source, e.dest, base + potential[random.getVertexId(e.source)] - potential[random.getVertexId(e.dest)]);
+  }
+  CSRGraph resynthetic(random);
+  REQUIRE( reweighted.customize(resynthetic) );
+  matchesBellmanFord(reweighted, resynthetic, 23);
+
+  // every weight is -1 until a person is set
+  safeCovid covid("data/edges.txt");
+  const CSRGraph& csr = covid.getNetwork();
+  CustomizableHierarchy customizable(csr);
+  REQUIRE_FALSE( customizable.customize(csr) );
+
+  for (float age : {70.0f, 21.0f}) {
+    covid.setPerson(age);
+    REQUIRE( customizable.fits(csr) );
+    REQUIRE( customizable.customize(csr) );
+    ALTSearch plain(csr, 0);
+    for (const auto& pair : randomPairs(29, 150, csr.vertexCount()))
+      matchesForwardSearch(customizable, plain, csr, pair.first, pair.second);
+  }
+
+  covid.setQueryMode(safeCovid::CCH);
+  vector<std::string> names = covid.getPathDijkstra("ORD", "MNL");
+  REQUIRE( names.size() == 3 );
+  REQUIRE( names.front() == "MNL" );
+  REQUIRE( names.back() == "ORD" );
+}
+
+TEST_CASE("Direction-optimizing BFS matches a queue BFS") {
+  Graph graph_ = temp.getAirportGraph();
+  const CSRGraph& csr = temp.getNetwork();
+  DirectionOptimizingBFS layers(csr);
+  vector<unsigned> hops;
+  vector<unsigned> topDown;
+  vector<unsigned> bottomUp;
+  for (const char* name : {"ATL", "FRA", "ORD", "YCU"}) {
+    VertexId root = graph_.getVertexId(name);
+    vector<unsigned> expected(csr.vertexCount(), DirectionOptimizingBFS::Unreached);
+    vector<VertexId> queue(1, root);
+    expected[root] = 0;
+    for (size_t i = 0; i < queue.size(); i++) {
+      for (uint32_t e = csr.edgeBegin(queue[i]); e < csr.edgeEnd(queue[i]); e++) {
+        VertexId v = csr.target(e);
+        if (expected[v] == DirectionOptimizingBFS::Unreached) {
+          expected[v] = expected[queue[i]] + 1;
+          queue.push_back(v);
+        }
+      }
+    }
+
+    layers.run(root, hops);
+    REQUIRE( hops == expected );
+    layers.run(root, topDown, DirectionOptimizingBFS::TopDownOnly);
+    REQUIRE( layers.getBottomUpLevels() == 0 );
+    REQUIRE( topDown == expected );
+    layers.run(root, bottomUp, DirectionOptimizingBFS::BottomUpOnly);
+    REQUIRE( layers.getTopDownLevels() == 0 );
+    REQUIRE( bottomUp == expected );
+  }
+
+  // a hub's middle levels cover most of the graph, so they go bottom-up
+  layers.run(graph_.getVertexId("ATL"), hops);
+  REQUIRE( layers.getTopDownLevels() > 0 );
+  REQUIRE( layers.getBottomUpLevels() > 0 );
+
+  REQUIRE( temp.getHopLayers("ORD", hops) );
+  REQUIRE( hops[graph_.getVertexId("ORD")] == 0 );
+  REQUIRE( hops[graph_.getVertexId("MNL")] + 1 == temp.getPathBFS("ORD", "MNL").size() );
+  REQUIRE_FALSE( temp.getHopLayers("_NOT_AN_AIRPORT", hops) );
+  REQUIRE( std::count(hops.begin(), hops.end(), DirectionOptimizingBFS::Unreached) == long(hops.size()) );
+}
+
+TEST_CASE("Multi-source BFS matches single-source runs") {
+  const CSRGraph& csr = temp.getNetwork();
+  size_t count = csr.vertexCount();
+  MultiSourceBFS batch(csr);
+  DirectionOptimizingBFS single(csr);
+
+  // a full batch of 64 spread over the graph, then a short one
+  vector<VertexId> sources;
+  for (size_t i = 0; i < MultiSourceBFS::Width; i++)
+    sources.push_back(static_cast<VertexId>(i * count / MultiSourceBFS::Width));
+  vector<uint8_t> rows(sources.size() * count);
+  REQUIRE( batch.run(sources.data(), sources.size(), rows.data()) );
+  vector<unsigned> hops;
+  vector<uint8_t> expected(count);
+  for (size_t i = 0; i < sources.size(); i++) {
+    single.run(sources[i], hops);
+    for (VertexId v = 0; v < count; v++)
+      expected[v] = std::min<unsigned>(hops[v], MultiSourceBFS::Unreached);
+    REQUIRE( std::equal(expected.begin(), expected.end(), rows.begin() + i * count) );
+  }
+  REQUIRE( batch.run(sources.data(), 3, rows.data()) );
+  single.run(sources[2], hops);
+  for (VertexId v = 0; v < count; v++)
+    expected[v] = std::min<unsigned>(hops[v], MultiSourceBFS::Unreached);
+  REQUIRE( std::equal(expected.begin(), expected.end(), rows.begin() + 2 * count) );
+
+  vector<uint8_t> matrix;
+  vector<uint8_t> threaded;
+  REQUIRE( batch.allPairs(matrix, 1) );
+  REQUIRE( batch.allPairs(threaded, 3) );
+  REQUIRE( matrix == threaded );
+  for (VertexId s = 0; s < count; s += 97) {
+    single.run(s, hops);
+    for (VertexId v = 0; v < count; v++)
+      expected[v] = std::min<unsigned>(hops[v], MultiSourceBFS::Unreached);
+    REQUIRE( std::equal(expected.begin(), expected.end(), matrix.begin() + s * count) );
+  }
+
+  VertexId bad = static_cast<VertexId>(count);
+  REQUIRE_FALSE( batch.run(&bad, 1, rows.data()) );
+}
+
+TEST_CASE("Hop matrix answers fewest-flight queries") {
+  safeCovid covid("data/edges.txt");
+  const CSRGraph& csr = covid.getNetwork();
+  vector<std::pair<VertexId, VertexId>> pairs = randomPairs(59, 100, csr.vertexCount());
+  vector<vector<std::string>> searched(pairs.size());
+  vector<std::string> names;
+  for (size_t i = 0; i < pairs.size(); i++)
+    covid.getPathBFS(csr.getVertexName(pairs[i].first), csr.getVertexName(pairs[i].second),
+                     BidirectionalBFS::NoHopLimit, searched[i]);
+  REQUIRE( covid.getPathBFS("ORD", "SPB", 2, names) == NoPath );
+  REQUIRE( covid.getFewestHops("BDJ", "MPL") == 4 );
+  REQUIRE( covid.isWithinHops("BDJ", "MPL", 4) );
+  REQUIRE_FALSE( covid.isWithinHops("BDJ", "MPL", 3) );
+  REQUIRE( covid.getFewestHops("BDJ", "BDJ") == 0 );
+  REQUIRE( covid.getFewestHops("ORD", "_NOT_AN_AIRPORT") == HopMatrix::Unreached );
+
+  HopMatrix matrix(csr, 2);
+  REQUIRE( matrix.usable() );
+  REQUIRE( matrix.bytes() == csr.vertexCount() * csr.vertexCount() );
+  BidirectionalBFS search(csr);
+  vector<VertexId> expected;
+  vector<VertexId> path;
+  for (const auto& pair : randomPairs(53, 300, csr.vertexCount())) {
+    VertexId s = pair.first;
+    VertexId d = pair.second;
+
+    HopSearchResult result = search.findPath(s, d, expected);
+    REQUIRE( matrix.findPath(csr, s, d, path) == result );
+    REQUIRE( path.size() == expected.size() );
+    if (result != PathFound) {
+      REQUIRE( matrix.hops(s, d) == HopMatrix::Unreached );
+      continue;
+    }
+    REQUIRE( matrix.hops(s, d) + 1 == path.size() );
+    checkedPathWeight(csr, path, s, d);
+  }
+
+  // the getters built the matrix, which only rules pairs out, so
+  // getPathBFS returns the searched routes, also once it is rebuilt
+  for (int round = 0; round < 2; round++) {
+    bool sameRoutes = true;
+    for (size_t i = 0; i < pairs.size(); i++) {
+      covid.getPathBFS(csr.getVertexName(pairs[i].first), csr.getVertexName(pairs[i].second),
+                       BidirectionalBFS::NoHopLimit, names);
+      sameRoutes = sameRoutes && names == searched[i];
+    }
+    REQUIRE( sameRoutes );
+    REQUIRE( covid.getPathBFS("ORD", "SPB", 2, names) == NoPath );
+    REQUIRE( covid.buildHopMatrix(2) );
+  }
+
+  // with the same hop limits as the search
+  REQUIRE( covid.getPathBFS("BDJ", "MPL", 4, names) == PathFound );
+  REQUIRE( names.size() == 5 );
+  REQUIRE( names.front() == "MPL" );
+  REQUIRE( names.back() == "BDJ" );
+  REQUIRE( covid.getPathBFS("BDJ", "MPL", 3, names) == NoPathWithinHops );
+  REQUIRE( names.empty() );
+  REQUIRE( covid.getPathBFS("ORD", "_NOT_AN_AIRPORT", 10, names) == NoPath );
+  REQUIRE( covid.getPathBFS("ORD", "SPB", 2, names) == NoPath );
+
+  // weights don't change the matrix, so it survives setPerson and loads
+  // for the reweighted network
+  const std::string file = "data/tests_hops.bin";
+  covid.setPerson(21);
+  REQUIRE( covid.saveHopMatrix(file) );
+  safeCovid loaded("data/edges.txt");
+  loaded.setPerson(70);
+  REQUIRE( loaded.loadHopMatrix(file) );
+  REQUIRE( loaded.getFewestHops("BDJ", "MPL") == 4 );
+
+  Graph g(true, true);
+  g.insertVertex("ORD");
+  g.insertVertex("MNL");
+  g.insertEdge("ORD", "MNL");
+  REQUIRE_FALSE( matrix.load(file, CSRGraph(g)) );
+  REQUIRE( matrix.fits(csr) );
+  std::remove(file.c_str());
+}
+
+TEST_CASE("Hub labels match the forward search") {
+  temp.setPerson(21);
+  const CSRGraph& csr = temp.getNetwork();
+
+  HubLabels labels(csr);
+  REQUIRE( labels.usable() );
+  REQUIRE( labels.entryCount() >= 2 * csr.vertexCount() );
+  ALTSearch plain(csr, 0);
+  for (const auto& pair : randomPairs(41, 300, csr.vertexCount())) {
+    VertexId s = pair.first;
+    VertexId d = pair.second;
+    if (matchesForwardSearch(labels, plain, csr, s, d))
+      REQUIRE( labels.distance(s, d) == plain.getCost() );
+    else
+      REQUIRE( labels.distance(s, d) == std::numeric_limits<double>::infinity() );
+  }
+
+  // negative but feasible weights, checked against Bellman-Ford
+  for (uint32_t seed : {5u, 29u}) {
+    CSRGraph synthetic(feasibleRandomGraph(seed, 200, 3));
+    HubLabels hubs(synthetic);
+    REQUIRE( hubs.usable() );
+    matchesBellmanFord(hubs, synthetic, 23);
+    vector<double> expected = bellmanFord(synthetic, 7);
+    vector<double> found;
+    for (VertexId d = 0; d < synthetic.vertexCount(); d++)
+      found.push_back(hubs.distance(7, d));
+    REQUIRE( found == expected );
+  }
+
+  temp.setQueryMode(safeCovid::HubLabel);
+  vector<std::string> names = temp.getPathDijkstra("ORD", "MNL");
+  REQUIRE( names.size() == 3 );
+  REQUIRE( names.front() == "MNL" );
+  REQUIRE( names.back() == "ORD" );
+  temp.setQueryMode(safeCovid::Unidirectional);
+
+  // every weight is -1 until a person is set
+  safeCovid unweighted("data/edges.txt");
+  HubLabels cyclic(unweighted.getNetwork());
+  REQUIRE_FALSE( cyclic.usable() );
+  REQUIRE( cyclic.distance(0, 1) == std::numeric_limits<double>::infinity() );
+}
+
+TEST_CASE("Risk matrix matches a plain Floyd-Warshall") {
+  // 150 airports, not a multiple of the tile size; each weight is a
+  // non-negative base plus a potential difference, so some are negative
+  // but no cycle is
+  const size_t count = 150;
+  Graph g(true, true);
+  vector<string> names;
+  vector<int> potential;
+  uint32_t state = 97531;
+  for (size_t i = 0; i < count; i++) {
+    names.push_back("V" + std::to_string(i));
+    g.insertVertex(names.back());
+    potential.push_back(static_cast<int>(nextRandom(state) % 7));
+  }
+  for (size_t i = 0; i < count; i++) {
+    for (int n = 0; n < 4; n++) {
+      size_t j = nextRandom(state) % count;
+      int base = static_cast<int>(nextRandom(state) % 5);
+      if (i != j && g.insertEdge(names[i], names[j]))
+        g.setEdgeWeight(names[i], names[j], base + potential[i] - potential[j]);
+    }
+  }
+  CSRGraph csr(g);
+
+  const double inf = std::numeric_limits<double>::infinity();
+  vector<double> expected(count * count, inf);
+  for (VertexId u = 0; u < count; u++) {
+    expected[u * count + u] = 0;
+    for (uint32_t e = csr.edgeBegin(u); e < csr.edgeEnd(u); e++)
+      expected[u * count + csr.target(e)] = csr.weight(e);
+  }
+  for (size_t k = 0; k < count; k++)
+    for (size_t i = 0; i < count; i++)
+      for (size_t j = 0; j < count; j++)
+        expected[i * count + j] = std::min(expected[i * count + j], expected[i * count + k] + expected[k * count + j]);
+
+  RiskMatrix risks(csr, 1);
+  RiskMatrix threaded(csr, 3);
+  REQUIRE( risks.usable() );
+  REQUIRE_FALSE( risks.hasNegativeCycle() );
+  REQUIRE( risks.vertexCount() == count );
+  vector<double> found(count * count);
+  vector<double> foundThreaded(count * count);
+  for (VertexId s = 0; s < count; s++) {
+    for (VertexId d = 0; d < count; d++) {
+      found[s * count + d] = risks.risk(s, d);
+      foundThreaded[s * count + d] = threaded.risk(s, d);
+    }
+  }
+  REQUIRE( std::count_if(expected.begin(), expected.end(), [](double w) { return w < 0; }) > 0 );
+  REQUIRE( found == expected );
+  REQUIRE( foundThreaded == expected );
+  REQUIRE( risks.risk(0, count) == RiskMatrix::Unreachable );
+
+  // a two-flight loop of total weight -1
+  g.insertEdge(names[0], names[1]);
+  g.setEdgeWeight(names[0], names[1], -3);
+  g.insertEdge(names[1], names[0]);
+  g.setEdgeWeight(names[1], names[0], 2);
+  RiskMatrix cyclic((CSRGraph(g)));
+  REQUIRE( cyclic.hasNegativeCycle() );
+  REQUIRE_FALSE( cyclic.usable() );
+  REQUIRE( cyclic.risk(0, 1) == RiskMatrix::Unreachable );
+
+  // every weight is -1 until a person is set
+  safeCovid covid("data/edges.txt");
+  RiskMatrix unweighted(covid.getNetwork());
+  REQUIRE( unweighted.hasNegativeCycle() );
+}
+
+TEST_CASE("Shortest-path trees answer many destinations") {
+  temp.setPerson(21);
+  temp.setQueryMode(safeCovid::Unidirectional);
+  const CSRGraph& csr = temp.getNetwork();
+  size_t count = csr.vertexCount();
+  Graph graph_ = temp.getAirportGraph();
+  VertexId origin = graph_.getVertexId("ORD");
+
+  // built directly, so getPathDijkstra below still searches
+  ShortestPathTree risks(csr, origin, ShortestPathTree::Risk);
+  REQUIRE( risks.getRoot() == origin );
+  REQUIRE( risks.vertexCount() == count );
+  vector<VertexId> ids;
+  for (VertexId d = 0; d < count; d += 37) {
+    vector<std::string> expected = temp.getPathDijkstra("ORD", csr.getVertexName(d));
+    if (!risks.pathTo(d, ids)) {
+      REQUIRE( expected.size() == 2 );
+      continue;
+    }
+    REQUIRE( ids.size() == risks.hops(d) + 1 );
+    REQUIRE( ids.front() == origin );
+    REQUIRE( ids.back() == d );
+    vector<std::string> named;
+    for (size_t i = ids.size(); i > 0; i--)
+      named.push_back(csr.getVertexName(ids[i - 1]));
+    if (ids.size() == 1)
+      named.push_back("ORD");
+    REQUIRE( named == expected );
+  }
+
+  DirectionOptimizingBFS bfs(csr);
+  vector<unsigned> hops;
+  bfs.run(origin, hops);
+  ShortestPathTree flights(csr, origin, ShortestPathTree::Hops);
+  for (VertexId v = 0; v < count; v++) {
+    if (hops[v] == DirectionOptimizingBFS::Unreached) {
+      REQUIRE_FALSE( flights.reaches(v) );
+      REQUIRE( flights.parent(v) == Graph::InvalidVertexId );
+      continue;
+    }
+    REQUIRE( flights.hops(v) == hops[v] );
+    REQUIRE( flights.distance(v) == hops[v] );
+    if (v != origin)
+      REQUIRE( flights.hops(flights.parent(v)) + 1 == hops[v] );
+  }
+  // negative weights that no cycle adds up below zero
+  for (uint32_t seed : {3u, 17u}) {
+    CSRGraph synthetic(feasibleRandomGraph(seed, 200, 3));
+    for (VertexId root = 0; root < synthetic.vertexCount(); root += 23) {
+      vector<double> expected = bellmanFord(synthetic, root);
+      ShortestPathTree tree(synthetic, root, ShortestPathTree::Risk);
+      vector<double> found(synthetic.vertexCount());
+      bool validPaths = true;
+      for (VertexId v = 0; v < synthetic.vertexCount(); v++) {
+        found[v] = tree.distance(v);
+        if (tree.pathTo(v, ids))
+          validPaths = validPaths && checkedPathWeight(synthetic, ids, root, v) == expected[v];
+      }
+      REQUIRE( found == expected );
+      REQUIRE( validPaths );
+    }
+  }
+
+  REQUIRE_FALSE( flights.pathTo(static_cast<VertexId>(count), ids) );
+  REQUIRE( ids.empty() );
+  REQUIRE_FALSE( ShortestPathTree(csr, Graph::InvalidVertexId, ShortestPathTree::Hops).reaches(origin) );
+
+  // kept trees are reused, and once one is kept getPathDijkstra reads it
+  const ShortestPathTree& kept = temp.getRiskTree("ORD");
+  REQUIRE( &temp.getRiskTree("ORD") == &kept );
+  REQUIRE( temp.getPathDijkstra("ORD", "MNL").size() == 3 );
+  REQUIRE( temp.getSettledCount() == 0 );
+  for (const char* code : {"DXB", "KEF", "MNL", "CPH", "AUH", "SIN", "JOG", "RUH", "LHR"})
+    temp.getHopTree(code);
+  vector<std::string> path = temp.getPathLandmarkBFS("NTE", "GYE", "CGK");
+  REQUIRE( path.front() == "NTE" );
+  REQUIRE( path.back() == "CGK" );
+  REQUIRE( std::find(path.begin(), path.end(), "GYE") != path.end() );
+  for (unsigned i = 0; i + 1 < path.size(); i++)
+    REQUIRE( graph_.edgeExists(path[i], path[i + 1]) );
+  REQUIRE( temp.getPathLandmarkBFS("NTE", "GYE", "CGK") == path );
+  REQUIRE( temp.getPathLandmarkDijkstra("NTE", "XXX", "CGK").empty() );
+}
+
+TEST_CASE("Risk table matches one search per source") {
+  temp.setPerson(21);
+  const CSRGraph& csr = temp.getNetwork();
+  size_t count = csr.vertexCount();
+  vector<std::string> sources;
+  vector<std::string> targets;
+  for (VertexId v = 0; v < count; v += 131)
+    sources.push_back(csr.getVertexName(v));
+  for (VertexId v = 5; v < count; v += 97)
+    targets.push_back(csr.getVertexName(v));
+  targets.push_back(sources[3]);
+  targets.push_back("_NOT_AN_AIRPORT");
+
+  vector<double> table;
+  vector<double> threaded;
+  REQUIRE( temp.getRiskTable(sources, targets, table, 1) );
+  REQUIRE( temp.getRiskTable(sources, targets, threaded, 3) );
+  REQUIRE( table.size() == sources.size() * targets.size() );
+  REQUIRE( table == threaded );
+
+  Graph graph_ = temp.getAirportGraph();
+  vector<double> expected;
+  for (const std::string& s : sources) {
+    ShortestPathTree tree(csr, graph_.getVertexId(s), ShortestPathTree::Risk);
+    for (const std::string& d : targets)
+      expected.push_back(tree.distance(graph_.getVertexId(d)));
+  }
+  REQUIRE( table == expected );
+  REQUIRE( table[3 * targets.size() + targets.size() - 2] == 0 );
+  REQUIRE( table.back() == std::numeric_limits<double>::infinity() );
+  REQUIRE( std::count(table.begin(), table.end(), std::numeric_limits<double>::infinity()) < static_cast<long>(table.size()) / 2 );
+
+  // negative but feasible weights, checked against Bellman-Ford
+  for (uint32_t seed : {5u, 29u}) {
+    CSRGraph synthetic(feasibleRandomGraph(seed, 200, 3));
+    vector<VertexId> from;
+    vector<VertexId> to;
+    for (VertexId v = 0; v < synthetic.vertexCount(); v += 23)
+      from.push_back(v);
+    for (VertexId v = 0; v < synthetic.vertexCount(); v++)
+      to.push_back(v);
+    vector<double> filled;
+    REQUIRE( DistanceTable().fill(ContractionHierarchy(synthetic), from, to, filled, 2) );
+    vector<double> reference;
+    for (VertexId s : from) {
+      vector<double> row = bellmanFord(synthetic, s);
+      reference.insert(reference.end(), row.begin(), row.end());
+    }
+    REQUIRE( filled == reference );
+  }
+
+  // every weight is -1 until a person is set
+  safeCovid covid("data/edges.txt");
+  REQUIRE_FALSE( covid.getRiskTable(sources, targets, table) );
+  REQUIRE( table[0] == std::numeric_limits<double>::infinity() );
 }